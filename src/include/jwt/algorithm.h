@@ -0,0 +1,81 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_ALGORITHM_H_
+#define SRC_INCLUDE_JWT_ALGORITHM_H_
+
+#include "jwt/json.hpp"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+using json = nlohmann::json;
+
+/**
+ * The JWS algorithms known to this library, in the (ASCII) order of their
+ * names. Validators for other algorithms report UNKNOWN.
+ */
+enum class Algorithm : uint8_t {
+  ES256,
+  ES384,
+  ES512,
+  EdDSA,
+  HS256,
+  HS384,
+  HS512,
+  RS256,
+  RS384,
+  RS512,
+  none,
+  UNKNOWN
+};
+
+/**
+ * Conversions between algorithm names and the Algorithm enum. None of these
+ * allocate memory.
+ */
+class Algorithms {
+public:
+  /**
+   * The number of known algorithms, and the size of a table indexed by
+   * Algorithm.
+   */
+  static const size_t kCount = static_cast<size_t>(Algorithm::UNKNOWN);
+
+  static Algorithm Parse(const char *name, size_t num_name);
+  static Algorithm Parse(const std::string &name) {
+    return Parse(name.data(), name.size());
+  }
+
+  /**
+   * The "alg" of the given jose header, UNKNOWN if the header has no or an
+   * unknown alg.
+   */
+  static Algorithm FromJose(const json &jose);
+
+  /**
+   * The name of the algorithm, an empty string for UNKNOWN.
+   */
+  static const char *Name(Algorithm algorithm);
+};
+
+#endif // SRC_INCLUDE_JWT_ALGORITHM_H_
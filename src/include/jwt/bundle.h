@@ -0,0 +1,101 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_BUNDLE_H_
+#define SRC_INCLUDE_JWT_BUNDLE_H_
+
+#include "jwt/claimvalidator.h"
+#include "jwt/json.hpp"
+#include "jwt/messagevalidator.h"
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+/**
+ * A bundle is a precompiled, binary form of a MessageValidatorFactory and a
+ * ClaimValidatorFactory configuration. Loading a bundle avoids parsing json
+ * and PEM blocks when a process starts.
+ *
+ * A bundle contains:
+ * - A table of interned strings, which holds the algorithms, kids, secrets,
+ *   DER encoded public keys and claim values.
+ * - The validator tree, flattened in pre-order.
+ * - The claim validator tree, flattened in pre-order.
+ *
+ * All integers are stored as 32 bit little endian values. Bundles carry a
+ * version, a bundle with a different version will be rejected.
+ */
+class Bundle {
+public:
+  using json = nlohmann::json;
+
+  static const uint32_t kVersion;
+
+  /**
+   * Compiles the given configurations into a bundle. Secrets read from a file
+   * are resolved while compiling, so watching a file has no effect. Lazy
+   * validators are compiled as regular validators.
+   *
+   * @param validator The json accepted by MessageValidatorFactory::Build
+   * @param claims The json accepted by ClaimValidatorFactory::Build, or null
+   * if the bundle has no claim validator
+   * @return The binary bundle
+   * @throw std::logic_error if either configuration is invalid
+   */
+  static std::string Compile(const json &validator, const json &claims);
+
+  /**
+   * Loads the bundle from the given file. The file is mapped into memory and
+   * read in a single pass.
+   *
+   * @throw std::logic_error if the file cannot be read or is not a valid
+   * bundle
+   */
+  static Bundle *Load(const std::string &path);
+
+  /**
+   * Loads the bundle from memory. Validators that are nested more than 64
+   * levels deep are rejected.
+   *
+   * @throw std::logic_error if this is not a valid bundle
+   */
+  static Bundle *Parse(const uint8_t *data, size_t size);
+
+  /**
+   * The message validator, owned by this bundle.
+   */
+  MessageValidator *validator() const { return validator_.get(); }
+
+  /**
+   * The claim validator, owned by this bundle. Null if the bundle was compiled
+   * without claims.
+   */
+  ClaimValidator *claims() const { return claims_.get(); }
+
+private:
+  Bundle(MessageValidator *validator, ClaimValidator *claims);
+
+  validator_ptr validator_;
+  std::unique_ptr<ClaimValidator> claims_;
+};
+
+#endif // SRC_INCLUDE_JWT_BUNDLE_H_
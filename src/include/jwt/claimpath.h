@@ -0,0 +1,70 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_CLAIMPATH_H_
+#define SRC_INCLUDE_JWT_CLAIMPATH_H_
+
+#include "jwt/json.hpp"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * The location of a claim in a payload. A path that starts with a / is a
+ * JSON pointer (RFC 6901), such as /realm_access/roles or /cnf/jkt, any
+ * other path names a top level claim.
+ *
+ * The path is parsed once, finding a claim walks the payload without
+ * allocating.
+ */
+class ClaimPath {
+public:
+  using json = nlohmann::json;
+
+  /**
+   * @throw std::logic_error if the path is not a valid JSON pointer
+   */
+  explicit ClaimPath(const std::string &path);
+
+  /**
+   * The claim at this path, or nullptr if the payload has no such claim.
+   */
+  const json *Find(const json &claimset) const;
+
+  inline bool is_pointer() const { return pointer_; }
+
+  /**
+   * The top level claim this path starts at.
+   */
+  inline const std::string &head() const { return tokens_[0].key; }
+
+private:
+  struct Token {
+    std::string key;
+    int64_t index;  // the array index this token denotes, or -1
+  };
+
+  bool pointer_;
+  std::vector<Token> tokens_;
+};
+
+#endif // SRC_INCLUDE_JWT_CLAIMPATH_H_
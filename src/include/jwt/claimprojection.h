@@ -0,0 +1,88 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_CLAIMPROJECTION_H_
+#define SRC_INCLUDE_JWT_CLAIMPROJECTION_H_
+
+#include "jwt/claimvalidator.h"
+#include "jwt/decodelimits.h"
+#include "jwt/json.hpp"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * A ClaimProjection decodes only the top level claims of a payload that a
+ * caller asks for and that its claim validator reads. The payload is read
+ * with a SAX parser, so all other claims are skipped without building json
+ * for them, which saves most of the work for large payloads:
+ *
+ *   ClaimProjection projection({"sub", "exp"}, claims.get());
+ *   std::tie(header, payload) =
+ *       JWT::Decode(token, projection, validator.get(), claims.get());
+ *
+ * Validators that may read any claim, such as custom validators, make the
+ * projection keep the whole payload.
+ */
+class ClaimProjection {
+public:
+  using json = nlohmann::json;
+
+  /**
+   * @param claims The top level claims the caller needs.
+   * @param validator The claim validator the payload will be validated with,
+   * which may be null. Its claims are kept as well.
+   */
+  explicit ClaimProjection(const std::vector<std::string> &claims,
+                           const ClaimValidator *validator = nullptr);
+
+  /**
+   * Parses the projected claims of the json payload.
+   *
+   * @param limits Optional depth and member limits, which apply to the whole
+   * payload, skipped claims included.
+   * @throw TokenFormatError if the payload is invalid or exceeds the limits
+   */
+  json Parse(const char *str, size_t num_str,
+             const DecodeLimits *limits = nullptr) const;
+
+  /**
+   * True if the whole payload is kept.
+   */
+  inline bool keeps_all() const { return keeps_all_; }
+
+  /**
+   * The sorted top level claims that are kept.
+   */
+  inline const std::vector<std::string> &claims() const { return claims_; }
+
+  /**
+   * True if the claim is kept.
+   */
+  bool Keeps(const std::string &claim) const;
+
+private:
+  std::vector<std::string> claims_;
+  bool keeps_all_;
+};
+
+#endif // SRC_INCLUDE_JWT_CLAIMPROJECTION_H_
@@ -23,6 +23,7 @@
 #ifndef SRC_INCLUDE_JWT_CLAIMVALIDATOR_H_
 #define SRC_INCLUDE_JWT_CLAIMVALIDATOR_H_
 
+#include "jwt/claimpath.h"
 #include "jwt/json.hpp"
 #include "jwt/jwt_error.h"
 #include <memory>
@@ -38,6 +39,66 @@ public:
   explicit InvalidClaimError(std::string msg) : InvalidTokenError(msg) {}
 };
 
+/**
+ * The outcome of validating a claimset without throwing. The message is only
+ * built when requested, and may refer to the validator and the claimset, so
+ * it must be requested while both are still alive.
+ */
+class ClaimStatus {
+public:
+  using json = nlohmann::json;
+
+  enum Code : uint8_t {
+    kValid,
+    kMissing,    // the claim is not present
+    kWrongType,  // the claim is present but has the wrong json type
+    kNegative,   // the claim is a negative timestamp
+    kInvalid,    // the claim has a value that is not accepted
+    kNoneValid,  // none of the children of an any validator accepted
+    kError       // a validator threw, the message holds the reason
+  };
+
+  /**
+   * The validator that reported the failure, so the message reads the same as
+   * the exceptions the built in validators have always thrown.
+   */
+  enum Wording : uint8_t { kGeneric, kTime, kList, kAud };
+
+  ClaimStatus()
+      : code_(kValid), wording_(kGeneric), property_(nullptr), value_(nullptr) {
+  }
+  ClaimStatus(Code code, const std::string *property,
+              const json *value = nullptr, Wording wording = kGeneric)
+      : code_(code), wording_(wording), property_(property), value_(value) {}
+
+  /**
+   * A failed status with an already formatted message.
+   */
+  static ClaimStatus Error(const std::string &message);
+
+  inline Code code() const { return code_; }
+  inline bool valid() const { return code_ == kValid; }
+  explicit operator bool() const { return code_ == kValid; }
+
+  /**
+   * A human readable description of the failure, empty if valid.
+   */
+  std::string message() const;
+
+  /**
+   * Returns true if valid.
+   * @throw InvalidClaimError with the message if not valid
+   */
+  bool ThrowIfInvalid() const;
+
+private:
+  Code code_;
+  Wording wording_;
+  const std::string *property_;
+  const json *value_;
+  std::string message_;
+};
+
 /**
  * A ClaimValidator is capable of validating a JWT payload
  */
@@ -46,6 +107,25 @@ public:
   using json = nlohmann::json;
   virtual ~ClaimValidator() {}
 
+  /**
+   * How expensive a validator is to run. Adaptive all and any validators try
+   * cheap children first. Stateful validators remember the claims they accept
+   * and are never moved, so they see exactly the tokens they would see in
+   * config order.
+   */
+  enum Cost { kCheap, kModerate, kExpensive, kStateful };
+
+  /**
+   * How a validator combines the validators it is composed of.
+   */
+  enum Composition {
+    kLeaf,       // validates the claims itself
+    kWrapper,    // has the verdict of its only child
+    kAllOf,      // accepts if all children accept
+    kAnyOf,      // accepts if any child accepts
+    kOptionalOf  // accepts if its claim is missing or its only child accepts
+  };
+
   /**
    * Returns true if this claim validator is able to validate
    * the given claim.
@@ -56,6 +136,16 @@ public:
    */
   virtual bool IsValid(const json &claimset) const = 0;
 
+  /**
+   * Validates the claimset without throwing. The built in validators
+   * implement this directly and derive IsValid from it, the default
+   * implementation calls IsValid and captures the InvalidClaimError.
+   *
+   * @param claimset The set of claims to be validated
+   * @return the status of the validation.
+   */
+  virtual ClaimStatus Check(const json &claimset) const;
+
   /**
    * A Json representation of this validator. This can
    * be used to reconstruct this validator using a ClaimValidatorFactory
@@ -63,15 +153,65 @@ public:
   virtual std::string toJson() const = 0;
 
   /**
-   * The key in the payload this claim validator validates.
+   * The cost class of this validator, kModerate unless overridden.
+   */
+  virtual Cost cost() const { return kModerate; }
+
+  /**
+   * Adds the top level claims this validator reads to the list, so a decoder
+   * can skip all others.
+   *
+   * @return false if the validator may read any claim, which is the default.
+   */
+  virtual bool ListClaims(std::vector<std::string> *claims) const {
+    return false;
+  }
+
+  /**
+   * Points at the validators this validator is composed of, so a tree can be
+   * walked without knowing every composite class.
+   *
+   * @return how the children are combined, kLeaf if there are none.
+   */
+  virtual Composition Children(const ClaimValidator *const **children,
+                               size_t *num_children) const {
+    *children = nullptr;
+    *num_children = 0;
+    return kLeaf;
+  }
+
+  /**
+   * The key in the payload this claim validator validates. This is a JSON
+   * pointer for claims that are nested in the payload.
    */
   inline const std::string property() const { return property_; }
 
 protected:
-  explicit ClaimValidator(std::string property) : property_(property) {}
+  explicit ClaimValidator(std::string property)
+      : property_(property), path_(property) {}
+
+  /**
+   * The claim this validator validates, or nullptr if it is missing.
+   */
+  inline const json *Find(const json &claimset) const {
+    return path_.Find(claimset);
+  }
+
+  /**
+   * Lists the claim this validator validates, for validators that read no
+   * other claims.
+   */
+  inline bool ListOwnClaim(std::vector<std::string> *claims) const {
+    claims->push_back(path_.head());
+    return true;
+  }
+
   std::string property_;
+  ClaimPath path_;
 };
 
+class AdaptiveOrder;
+
 /**
  * An AllClaimValidator evaluates to true if all of its
  * child ClaimValidators evaluate to true.
@@ -82,13 +222,30 @@ public:
    * Constructs a new AllClaimValidator with a list validators that need to
    * evaluate to true.
    * @param validators The list of claimvalidators that have to evaluate to true
+   * @param adaptive Checks the children that reject most often, and are
+   * cheapest, first. The verdict does not change, but when several children
+   * reject the status may come from another one.
    */
-  explicit AllClaimValidator(std::vector<ClaimValidator *> validators);
+  explicit AllClaimValidator(std::vector<ClaimValidator *> validators,
+                             bool adaptive = false);
+  ~AllClaimValidator();
   bool IsValid(const json& claimset) const;
+  ClaimStatus Check(const json &claimset) const;
   std::string toJson() const;
+  Cost cost() const;
+  bool ListClaims(std::vector<std::string> *claims) const;
+  inline const std::vector<ClaimValidator *> &validators() const { return validators_; }
+  inline Composition Children(const ClaimValidator *const **children,
+                              size_t *num_children) const {
+    *children = validators_.data();
+    *num_children = validators_.size();
+    return kAllOf;
+  }
+  inline bool adaptive() const { return order_ != nullptr; }
 
 private:
   std::vector<ClaimValidator *> validators_;
+  std::unique_ptr<AdaptiveOrder> order_;
 };
 
 /**
@@ -102,7 +259,19 @@ class OptionalClaimValidator : public ClaimValidator {
 public:
   explicit OptionalClaimValidator(const ClaimValidator *inner);
   bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
   std::string toJson() const;
+  inline Cost cost() const { return inner_->cost(); }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return inner_->ListClaims(claims);
+  }
+  inline const ClaimValidator *inner() const { return inner_; }
+  inline Composition Children(const ClaimValidator *const **children,
+                              size_t *num_children) const {
+    *children = &inner_;
+    *num_children = 1;
+    return kOptionalOf;
+  }
 
 private:
   const ClaimValidator *inner_;
@@ -114,12 +283,30 @@ private:
  */
 class AnyClaimValidator : public ClaimValidator {
 public:
-  explicit AnyClaimValidator(std::vector<ClaimValidator *> validators);
+  /**
+   * @param adaptive Tries the children that accept most often, and are
+   * cheapest, first.
+   */
+  explicit AnyClaimValidator(std::vector<ClaimValidator *> validators,
+                             bool adaptive = false);
+  ~AnyClaimValidator();
   bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
   std::string toJson() const;
+  Cost cost() const;
+  bool ListClaims(std::vector<std::string> *claims) const;
+  inline const std::vector<ClaimValidator *> &validators() const { return validators_; }
+  inline Composition Children(const ClaimValidator *const **children,
+                              size_t *num_children) const {
+    *children = validators_.data();
+    *num_children = validators_.size();
+    return kAnyOf;
+  }
+  inline bool adaptive() const { return order_ != nullptr; }
 
 private:
   std::vector<ClaimValidator *> validators_;
+  std::unique_ptr<AdaptiveOrder> order_;
 };
 
 typedef std::unique_ptr<ClaimValidator> claim_ptr;
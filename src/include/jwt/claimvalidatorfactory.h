@@ -29,16 +29,30 @@
 #include <string>
 #include <vector>
 
+class IClock;
+
 class ClaimValidatorFactory {
 public:
   using json = nlohmann::json;
 
   static ClaimValidator *Build(const std::string &fromJson);
   static ClaimValidator *Build(const json &claim);
+
+  /**
+   * Builds the claim validator described by the json and compiles it into a
+   * flat program. The program looks up every claim once and validates
+   * without walking the tree, it accepts exactly the same claimsets as the
+   * validator returned by Build. If no claim is checked more than once the
+   * program would save nothing, and the tree itself is returned.
+   */
+  static ClaimValidator *Compile(const std::string &fromJson);
+  static ClaimValidator *Compile(const json &claim);
   ~ClaimValidatorFactory();
 
 private:
   std::vector<std::string> BuildList(const json &lst);
+  uint64_t BuildLeeway(const json &time);
+  IClock *BuildClock(const json &time);
   std::vector<ClaimValidator *> BuildValidatorList(const json &lst);
   ClaimValidator *BuildInternal(const json &fromJson);
 
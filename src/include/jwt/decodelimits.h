@@ -0,0 +1,118 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_DECODELIMITS_H_
+#define SRC_INCLUDE_JWT_DECODELIMITS_H_
+
+#include "jwt/json.hpp"
+#include <stddef.h>
+#include <map>
+#include <string>
+
+/**
+ * Limits on the size and structure of the tokens JWT::Decode accepts, so an
+ * attacker cannot make it allocate large buffers or parse deeply nested json.
+ *
+ * The size of the token and of its sections are checked while the token is
+ * split into sections, before anything is allocated. The limits of an alg
+ * apply once the header is parsed, until then the sections may be as large
+ * as the limits of any alg allow. A limit of 0 means no limit, which is the
+ * default for all limits.
+ *
+ * JWT::Decode applies the limits of the Precheck it is given. To enforce
+ * limits without prechecking any claims, use a precheck without a claim
+ * validator:
+ *
+ *       Precheck limited(nullptr, limits);
+ *       JWT::Decode(token, validator.get(), claims.get(), &limited);
+ */
+class DecodeLimits {
+public:
+  using json = nlohmann::json;
+
+  struct Sections {
+    size_t header;
+    size_t payload;
+    size_t signature;
+  };
+
+  DecodeLimits();
+
+  /**
+   * The largest token, in bytes.
+   */
+  size_t max_token;
+
+  /**
+   * The largest encoded sections of tokens with an alg that has no limits of
+   * its own.
+   */
+  Sections max_sections;
+
+  /**
+   * The largest encoded sections per alg, for example a small signature for
+   * HS256 and a larger one for RS512.
+   */
+  std::map<std::string, Sections> max_sections_by_alg;
+
+  /**
+   * The deepest nesting of objects and arrays in the header or payload.
+   */
+  size_t max_depth;
+
+  /**
+   * The largest number of keys, values, objects and arrays in the header or
+   * payload.
+   */
+  size_t max_members;
+
+  /**
+   * @throw TokenFormatError if the token is too large
+   */
+  void CheckToken(size_t num_token) const;
+
+  /**
+   * Checks the sections before the alg is known.
+   *
+   * @throw TokenFormatError if a section is larger than any alg allows
+   */
+  void CheckSections(size_t num_header, size_t num_payload,
+                     size_t num_signature) const;
+
+  /**
+   * Checks the sections against the limits of the alg.
+   *
+   * @throw TokenFormatError if a section is too large for the alg
+   */
+  void CheckSections(const std::string &alg, size_t num_header,
+                     size_t num_payload, size_t num_signature) const;
+
+  /**
+   * Parses the \0 terminated json within the depth and member limits.
+   *
+   * @throw TokenFormatError if the json exceeds the limits
+   * @throw json::parse_error if the json is invalid
+   */
+  json Parse(const char *str) const;
+};
+
+#endif // SRC_INCLUDE_JWT_DECODELIMITS_H_
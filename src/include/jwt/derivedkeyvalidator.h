@@ -0,0 +1,106 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_DERIVEDKEYVALIDATOR_H_
+#define SRC_INCLUDE_JWT_DERIVEDKEYVALIDATOR_H_
+
+#include "jwt/messagevalidator.h"
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+class HMACValidator;
+template <typename K, typename V>
+class LruCache;
+
+/**
+ * Validates HMAC signed tokens whose key is derived from the kid, instead of
+ * being stored.
+ *
+ * The key for a kid is HKDF-SHA256(master, salt, info = kid) (RFC 5869),
+ * with the length of the HMAC digest. The pseudo random key is computed
+ * once, so deriving a key only costs the expand step. Derived validators are
+ * kept in a bounded cache of recently used kids, so memory use does not
+ * depend on the number of kids.
+ *
+ * Only tokens with a kid that matches the kid pattern are accepted. The
+ * pattern is a glob where * matches any sequence of characters and ? matches
+ * a single character.
+ */
+class DerivedKeyValidator : public MessageValidator {
+public:
+  /**
+   * @param algorithm HS256, HS384 or HS512
+   * @param master The master secret
+   * @param pattern The glob that accepted kids must match
+   * @param cache_size The maximum number of derived validators kept in memory
+   * @param salt The HKDF salt, optional
+   * @throw std::logic_error if the algorithm is not supported
+   */
+  DerivedKeyValidator(const std::string &algorithm, const std::string &master,
+                      const std::string &pattern, size_t cache_size,
+                      const std::string &salt = "");
+  ~DerivedKeyValidator();
+
+  /**
+   * Derives the key for the given kid, this is the secret to sign tokens
+   * with for that kid.
+   */
+  std::string DeriveKey(const std::string &kid) const;
+
+  /**
+   * True if the kid matches the kid pattern.
+   */
+  bool Matches(const std::string &kid) const;
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t cHeader,
+              const uint8_t *signature, size_t cSignature) const override;
+  bool Accepts(const json &jose) const override;
+  std::string algorithm() const override { return algorithm_; }
+  Algorithm algorithm_id() const override { return algorithm_id_; }
+  std::string toJson() const override;
+
+  /**
+   * The number of validators that are currently cached.
+   */
+  size_t cache_size() const;
+
+private:
+  DerivedKeyValidator(const DerivedKeyValidator &);
+  DerivedKeyValidator &operator=(const DerivedKeyValidator &);
+
+  HMACValidator *NewValidator(const std::string &key) const;
+  const std::string *Kid(const json &jose) const;
+
+  std::string algorithm_;
+  Algorithm algorithm_id_;
+  const EVP_MD *md_;
+  std::string master_;
+  std::string pattern_;
+  std::string salt_;
+  std::string prk_;
+  std::unique_ptr<LruCache<std::string, MessageValidator>> cache_;
+};
+
+#endif // SRC_INCLUDE_JWT_DERIVEDKEYVALIDATOR_H_
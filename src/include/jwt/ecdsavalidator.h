@@ -0,0 +1,114 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_ECDSAVALIDATOR_H_
+#define SRC_INCLUDE_JWT_ECDSAVALIDATOR_H_
+
+#include "jwt/messagevalidator.h"
+#include <openssl/evp.h>
+#include <string>
+
+/**
+ * The ECDSAValidator can sign and validate the ECDSA family of signature
+ * algorithms. JWS carries the signature as the fixed size concatenation of
+ * the R and S values, which is converted to and from the DER encoding used by
+ * openssl.
+ */
+class ECDSAValidator : public MessageSigner {
+public:
+  explicit ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                          const std::string &public_key);
+  explicit ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                          const std::string &public_key,
+                          const std::string &private_key);
+  /**
+   * Creates a validator for an already materialized public key. The validator
+   * takes its own reference on the key.
+   */
+  explicit ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                          EVP_PKEY *public_key);
+  virtual ~ECDSAValidator();
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
+              const uint8_t *signature, size_t num_signature) const override;
+  bool Sign(const uint8_t *header, size_t num_header, uint8_t *signature,
+            size_t *num_signature) const override;
+
+  inline std::string algorithm() const override { return algorithm_; }
+  inline Algorithm algorithm_id() const override { return algorithm_id_; }
+  std::string toJson() const override;
+
+private:
+  ECDSAValidator(const ECDSAValidator &);
+  ECDSAValidator &operator=(const ECDSAValidator &);
+
+  std::string algorithm_;
+  Algorithm algorithm_id_;
+  EVP_PKEY *private_key_;
+  EVP_PKEY *public_key_;
+  const EVP_MD *md_;
+  // Number of bytes used by each of the R and S values.
+  size_t num_component_;
+};
+
+/**
+ * ECDSA using P-256 and SHA-256
+ */
+class ES256Validator : public ECDSAValidator {
+public:
+  explicit ES256Validator(const std::string &public_key)
+      : ECDSAValidator("ES256", EVP_sha256(), public_key) {}
+  explicit ES256Validator(const std::string &public_key,
+                          const std::string &private_key)
+      : ECDSAValidator("ES256", EVP_sha256(), public_key, private_key) {}
+  explicit ES256Validator(EVP_PKEY *public_key)
+      : ECDSAValidator("ES256", EVP_sha256(), public_key) {}
+};
+
+/**
+ * ECDSA using P-384 and SHA-384
+ */
+class ES384Validator : public ECDSAValidator {
+public:
+  explicit ES384Validator(const std::string &public_key)
+      : ECDSAValidator("ES384", EVP_sha384(), public_key) {}
+  explicit ES384Validator(const std::string &public_key,
+                          const std::string &private_key)
+      : ECDSAValidator("ES384", EVP_sha384(), public_key, private_key) {}
+  explicit ES384Validator(EVP_PKEY *public_key)
+      : ECDSAValidator("ES384", EVP_sha384(), public_key) {}
+};
+
+/**
+ * ECDSA using P-521 and SHA-512
+ */
+class ES512Validator : public ECDSAValidator {
+public:
+  explicit ES512Validator(const std::string &public_key)
+      : ECDSAValidator("ES512", EVP_sha512(), public_key) {}
+  explicit ES512Validator(const std::string &public_key,
+                          const std::string &private_key)
+      : ECDSAValidator("ES512", EVP_sha512(), public_key, private_key) {}
+  explicit ES512Validator(EVP_PKEY *public_key)
+      : ECDSAValidator("ES512", EVP_sha512(), public_key) {}
+};
+#endif // SRC_INCLUDE_JWT_ECDSAVALIDATOR_H_
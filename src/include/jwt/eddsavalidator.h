@@ -0,0 +1,63 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_EDDSAVALIDATOR_H_
+#define SRC_INCLUDE_JWT_EDDSAVALIDATOR_H_
+
+#include "jwt/messagevalidator.h"
+#include <openssl/evp.h>
+#include <string>
+
+/**
+ * The EdDSAValidator can sign and validate the EdDSA signature algorithm
+ * (RFC 8037) using an Ed25519 or Ed448 key. This requires openssl 1.1.1 or
+ * later.
+ */
+class EdDSAValidator : public MessageSigner {
+public:
+  explicit EdDSAValidator(const std::string &public_key);
+  explicit EdDSAValidator(const std::string &public_key,
+                          const std::string &private_key);
+  /**
+   * Creates a validator for an already materialized public key. The validator
+   * takes its own reference on the key.
+   */
+  explicit EdDSAValidator(EVP_PKEY *public_key);
+  virtual ~EdDSAValidator();
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
+              const uint8_t *signature, size_t num_signature) const override;
+  bool Sign(const uint8_t *header, size_t num_header, uint8_t *signature,
+            size_t *num_signature) const override;
+
+  inline std::string algorithm() const override { return "EdDSA"; }
+  inline Algorithm algorithm_id() const override { return Algorithm::EdDSA; }
+  std::string toJson() const override;
+
+private:
+  EdDSAValidator(const EdDSAValidator &);
+  EdDSAValidator &operator=(const EdDSAValidator &);
+
+  EVP_PKEY *private_key_;
+  EVP_PKEY *public_key_;
+};
+#endif // SRC_INCLUDE_JWT_EDDSAVALIDATOR_H_
@@ -47,6 +47,7 @@ public:
 
   inline unsigned int key_size() const { return key_size_; }
   inline std::string algorithm() const { return algorithm_; }
+  inline Algorithm algorithm_id() const { return algorithm_id_; }
   std::string toJson() const;
 
 private:
@@ -57,6 +58,7 @@ private:
 
   const EVP_MD *md_;
   std::string algorithm_;
+  Algorithm algorithm_id_;
   unsigned int key_size_;
   std::string key_;
 };
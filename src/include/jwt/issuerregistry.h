@@ -0,0 +1,133 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_ISSUERREGISTRY_H_
+#define SRC_INCLUDE_JWT_ISSUERREGISTRY_H_
+
+#include "jwt/claimvalidator.h"
+#include "jwt/decodelimits.h"
+#include "jwt/json.hpp"
+#include "jwt/messagevalidator.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+/**
+ * An IssuerRegistry holds the message and claim validator of every issuer a
+ * service accepts tokens from. Decoding a token peeks at its unverified iss
+ * claim, looks up the validators registered for that issuer and then decodes
+ * the token as JWT::Decode does. Only the iss claim is read by the peek, the
+ * rest of the payload is skipped.
+ *
+ * A registry with DecodeLimits checks the size of a token before peeking at
+ * it, and decodes it with a Precheck of the issuer's claim validator.
+ *
+ * The registry can be read and changed from many threads at once. Issuers
+ * are spread over shards with their own lock, which is only held while
+ * looking an issuer up, never while a token is verified.
+ */
+class IssuerRegistry {
+public:
+  using json = nlohmann::json;
+
+  IssuerRegistry();
+  explicit IssuerRegistry(const DecodeLimits &limits);
+  ~IssuerRegistry();
+
+  /**
+   * Registers the validators of an issuer, replacing any validators that were
+   * registered for it before. The registry takes ownership of the validators.
+   *
+   * @param claims The claim validator, or null to only verify the signature
+   */
+  void Register(const std::string &issuer, MessageValidator *validator,
+                ClaimValidator *claims);
+
+  /**
+   * Builds the validators of an issuer with the MessageValidatorFactory and
+   * the ClaimValidatorFactory and registers them.
+   *
+   * @param claims The claim configuration, or null for none
+   * @throw std::logic_error if either configuration is invalid
+   */
+  void Register(const std::string &issuer, const json &validator,
+                const json &claims);
+
+  /**
+   * Registers all issuers of a configuration of the form
+   * { "issuer" : { "validator" : {...}, ("claims" : {...})? }, ... }
+   *
+   * @throw std::logic_error if any of the configurations is invalid
+   */
+  void Load(const json &issuers);
+
+  /**
+   * Removes an issuer. Tokens that are being decoded with its validators
+   * finish normally.
+   *
+   * @return true if the issuer was registered
+   */
+  bool Remove(const std::string &issuer);
+
+  size_t size() const;
+
+  /**
+   * Decodes the token with the validators of the issuer named in its iss
+   * claim.
+   *
+   * @return A tuple containing the json header and the payload.
+   * @throw TokenFormatError in case the token cannot be parsed
+   * @throw InvalidSignatureError in case the issuer is unknown or the token
+   * is not signed by it
+   * @throw InvalidClaimError in case the payload cannot be validated
+   */
+  std::tuple<json, json> Decode(const std::string &token) const;
+
+  /**
+   * Reads the kid from the header and the iss claim from the payload of a
+   * token, without verifying or fully parsing it. Either is left empty if
+   * the token does not have it as a string.
+   *
+   * @param kid Receives the kid, or null to not decode the header
+   *
+   * @throw TokenFormatError in case the token cannot be parsed
+   */
+  static void Peek(const char *token, size_t num_token, std::string *kid,
+                   std::string *iss);
+
+private:
+  struct Issuer;
+  struct Shard {
+    mutable std::mutex lock;
+    std::unordered_map<std::string, std::shared_ptr<const Issuer>> issuers;
+  };
+  static const size_t kShards = 16;
+
+  Shard &ShardFor(const std::string &issuer) const;
+
+  std::unique_ptr<Shard[]> shards_;
+  std::unique_ptr<DecodeLimits> limits_;
+};
+
+#endif // SRC_INCLUDE_JWT_ISSUERREGISTRY_H_
@@ -0,0 +1,84 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_JTIREPLAYVALIDATOR_H_
+#define SRC_INCLUDE_JWT_JTIREPLAYVALIDATOR_H_
+
+#include "jwt/claimvalidator.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+class IClock;
+
+/**
+ * A JtiReplayValidator accepts every jti (JWT ID) only once, which makes
+ * tokens single use.
+ *
+ * Seen ids are remembered for a fixed time to live, or until the token
+ * expires at its exp claim if that is later. The time to live should be at
+ * least the leeway allowed on exp. The ids are spread over a
+ * number of independently locked shards, each of which expires its ids
+ * through a hierarchical timing wheel, so concurrent validations rarely
+ * contend and expiry costs O(1) per id.
+ *
+ * The number of remembered ids is bounded. When a shard is full new tokens
+ * are rejected until ids expire, as accepting them would allow replays.
+ */
+class JtiReplayValidator : public ClaimValidator {
+public:
+  static const size_t kDefaultEntries = 1 << 20;
+  static const uint64_t kDefaultTtl = 3600;
+
+  /**
+   * @param max_entries The maximum number of ids that are remembered
+   * @param ttl The minimum time, in seconds, to remember an id
+   * @param clock The clock used to expire ids
+   */
+  JtiReplayValidator(size_t max_entries, uint64_t ttl, IClock *clock);
+  JtiReplayValidator(size_t max_entries, uint64_t ttl);
+  JtiReplayValidator();
+  ~JtiReplayValidator();
+
+  bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+  inline Cost cost() const { return kStateful; }
+  bool ListClaims(std::vector<std::string> *claims) const;
+  std::string toJson() const;
+
+  /**
+   * The number of ids that are currently remembered.
+   */
+  size_t size() const;
+
+private:
+  struct Shard;
+  static const size_t kShards = 16;
+
+  size_t max_entries_;
+  uint64_t ttl_;
+  IClock *clock_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+#endif // SRC_INCLUDE_JWT_JTIREPLAYVALIDATOR_H_
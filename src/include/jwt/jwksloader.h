@@ -0,0 +1,111 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_JWKSLOADER_H_
+#define SRC_INCLUDE_JWT_JWKSLOADER_H_
+
+#include "jwt/json.hpp"
+#include "jwt/kidvalidator.h"
+#include <openssl/evp.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Builds a KidValidator from a JSON Web Key Set (RFC 7517).
+ *
+ * The following key types are supported:
+ * - RSA (n, e): RS256, RS384, RS512
+ * - EC (crv, x, y): ES256, ES384, ES512
+ * - oct (k): HS256, HS384, HS512
+ * - OKP (crv, x): EdDSA
+ *
+ * Keys with a "use" other than "sig", an unknown "kty" or an unsupported "alg"
+ * are ignored. Keys without a "kid" are registered under their RFC 7638
+ * thumbprint.
+ *
+ * Materialized public keys are cached by thumbprint, so reloading a key set
+ * only has to parse the keys that were added since the last load. Keys that
+ * are no longer part of the set are evicted from the cache.
+ */
+class JwksLoader {
+public:
+  using json = nlohmann::json;
+
+  JwksLoader();
+
+  /**
+   * Reads the key set from the given file.
+   *
+   * @param path Path to a file containing a JWKS document
+   * @return A new KidValidator, owned by the caller
+   * @throw InvalidValidatorError if the file cannot be read or contains an
+   * invalid key
+   */
+  KidValidator *Load(const std::string &path);
+
+  /**
+   * Creates a KidValidator from a parsed JWKS document.
+   */
+  KidValidator *Build(const json &jwks);
+
+  /**
+   * Reads the key set from the given file, and atomically swaps it into the
+   * given kid validator.
+   */
+  void Reload(const std::string &path, KidValidator *kid);
+
+  /**
+   * Atomically swaps the given key set into the given kid validator.
+   */
+  void Reload(const json &jwks, KidValidator *kid);
+
+  /**
+   * The RFC 7638 thumbprint (base64url encoded SHA-256) of the given key.
+   */
+  static std::string Thumbprint(const json &jwk);
+
+  /** Number of keys currently cached */
+  size_t cache_size() const;
+
+  /** Number of keys that had to be materialized, i.e. cache misses */
+  size_t materialized() const;
+
+private:
+  typedef std::shared_ptr<EVP_PKEY> pkey_ptr;
+  typedef std::unordered_map<std::string, pkey_ptr> PKeyCache;
+
+  static json ReadFile(const std::string &path);
+  KidValidator::KidMap BuildMap(const json &jwks, std::string *first);
+  std::shared_ptr<MessageValidator> BuildKey(const json &jwk,
+                                             const std::string &thumbprint,
+                                             PKeyCache *used);
+  pkey_ptr Materialize(const std::string &thumbprint, const json &jwk,
+                       PKeyCache *used);
+
+  PKeyCache cache_;
+  size_t materialized_;
+  mutable std::mutex lock_;
+};
+
+#endif // SRC_INCLUDE_JWT_JWKSLOADER_H_
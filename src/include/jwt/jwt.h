@@ -27,14 +27,20 @@
 #include <memory>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include "jwt/claimprojection.h"
 #include "jwt/claimvalidator.h"
 #include "jwt/json.hpp"
 #include "jwt/messagevalidator.h"
+#include "jwt/precheck.h"
+#include "jwt/registeredclaims.h"
 
 // Stack allocated signature.
 #define MAX_SIGNATURE_LENGTH 256
 
+class PayloadDecoder;
+
 /**
  * JSON Web Token (JWT) is a compact, URL-safe means of representing claims to
  * be transferred between two parties. The claims in a JWT are encoded as a JSON
@@ -60,13 +66,16 @@ class JWT {
      *                 parameter is null the signature will not be verified.
      * @param validator Optional validator to validate the claims in this token.
      * The payload will not be validated if this parameter is null
+     * @param precheck Optional checks that can reject the token before its
+     * signature is verified.
      * @throw TokenFormatError in case the token cannot be parsed
      * @throw InvalidSignatureError in case the token is not signed
      * @throw InvalidClaimError in case the payload cannot be validated
      */
     static std::tuple<json, json> Decode(const std::string &jwsToken,
                                          MessageValidator *verifier = nullptr,
-                                         ClaimValidator *validator = nullptr);
+                                         ClaimValidator *validator = nullptr,
+                                         const Precheck *precheck = nullptr);
 
     /**
      * Decodes and validates a JSON Web Token.
@@ -77,6 +86,8 @@ class JWT {
      *                 verification will be done if this parameter is null .
      * @param validator Optional validator to validate the claims in this token.
      * The payload will not be validated if this parameter is null
+     * @param precheck Optional checks that can reject the token before its
+     * signature is verified.
      * @return A tuple containing the json header and the payload.
      * @throw TokenFormatError in case the token cannot be parsed
      * @throw InvalidSignatureError in case the token is not signed
@@ -85,7 +96,57 @@ class JWT {
     static std::tuple<json, json> Decode(const char *jws_token,
                                          size_t num_jws_token,
                                          MessageValidator *verifier = nullptr,
-                                         ClaimValidator *validator = nullptr);
+                                         ClaimValidator *validator = nullptr,
+                                         const Precheck *precheck = nullptr);
+
+    /**
+     * Decodes and validates a JSON Web Token, but only keeps the claims of the
+     * payload that are in the projection. The other claims are skipped while
+     * the payload is parsed.
+     *
+     * @param projection The claims to keep, made for the given validator.
+     * @return A tuple containing the json header and the projected payload.
+     * @throw TokenFormatError in case the token cannot be parsed
+     * @throw InvalidSignatureError in case the token is not signed
+     * @throw InvalidClaimError in case the payload cannot be validated
+     */
+    static std::tuple<json, json> Decode(const std::string &jwsToken,
+                                         const ClaimProjection &projection,
+                                         MessageValidator *verifier = nullptr,
+                                         ClaimValidator *validator = nullptr,
+                                         const Precheck *precheck = nullptr);
+
+    /**
+     * Decodes and validates a JSON Web Token straight into T, which derives
+     * from RegisteredClaims. The payload is read with a SAX parser that only
+     * builds the claims T describes and the claims its validators read, no
+     * json is kept for the payload as a whole. The built in time, iss, sub and
+     * aud validators check the typed claims:
+     *
+     *   Session session;
+     *   std::tie(header, session) =
+     *       JWT::Decode<Session>(token, validator.get(), claims.get());
+     *
+     * @return A tuple containing the json header and the decoded claims.
+     * @throw TokenFormatError in case the token cannot be parsed, or a claim
+     * does not fit the field T describes for it
+     * @throw InvalidSignatureError in case the token is not signed
+     * @throw InvalidClaimError in case the payload cannot be validated
+     */
+    template <typename T>
+    static std::tuple<json, T> Decode(const std::string &jwsToken,
+                                      MessageValidator *verifier = nullptr,
+                                      ClaimValidator *validator = nullptr,
+                                      const Precheck *precheck = nullptr) {
+        static_assert(std::is_base_of<RegisteredClaims, T>::value,
+                      "T must derive from RegisteredClaims");
+        static const ClaimFields<T> fields;
+        T claims;
+        json header = DecodeTyped(jwsToken.c_str(), jwsToken.size(), verifier,
+                                  validator, precheck, fields, &claims,
+                                  &claims);
+        return std::make_tuple(std::move(header), std::move(claims));
+    }
 
     /**
      * Encodes the given json payload and optional header with the given signer.
@@ -101,7 +162,18 @@ class JWT {
                               json header = {});
 
    private:
-    static json ExtractPayload(const char *payload, size_t num_payload);
+    static json Decode(const char *jws_token, size_t num_jws_token,
+                       MessageValidator *verifier, ClaimValidator *validator,
+                       const Precheck *precheck, PayloadDecoder *decoder);
+    static json DecodeTyped(const char *jws_token, size_t num_jws_token,
+                            MessageValidator *verifier,
+                            ClaimValidator *validator,
+                            const Precheck *precheck,
+                            const ClaimFieldsBase &fields,
+                            RegisteredClaims *claims, void *object);
+    static void ExtractPayload(const char *payload, size_t num_payload,
+                               const DecodeLimits *limits,
+                               PayloadDecoder *decoder);
     static bool VerifySignature(const json &header_claims_, const char *header,
                                 size_t num_header_and_payload,
                                 const char *signature, size_t num_signature,
@@ -24,15 +24,29 @@
 #define SRC_INCLUDE_JWT_JWT_ALL_H_
 #include "jwt/allocators.h"
 #include "jwt/jwt.h"
+#include "jwt/issuerregistry.h"
 
 // Validators
+#include "jwt/derivedkeyvalidator.h"
+#include "jwt/ecdsavalidator.h"
+#include "jwt/eddsavalidator.h"
 #include "jwt/hmacvalidator.h"
+#include "jwt/jwksloader.h"
+#include "jwt/keystorevalidator.h"
 #include "jwt/messagevalidatorfactory.h"
+#include "jwt/multikeyvalidator.h"
 #include "jwt/nonevalidator.h"
 #include "jwt/rsavalidator.h"
 
 // Claims
 #include "jwt/claimvalidatorfactory.h"
+#include "jwt/jtireplayvalidator.h"
 #include "jwt/listclaimvalidator.h"
+#include "jwt/policyset.h"
+#include "jwt/revocationvalidator.h"
+#include "jwt/scopevalidator.h"
 #include "jwt/timevalidator.h"
+
+// Precompiled configurations
+#include "jwt/bundle.h"
 #endif // SRC_INCLUDE_JWT_JWT_ALL_H_
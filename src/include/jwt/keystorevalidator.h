@@ -0,0 +1,136 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_KEYSTOREVALIDATOR_H_
+#define SRC_INCLUDE_JWT_KEYSTOREVALIDATOR_H_
+
+#include "jwt/messagevalidator.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class MappedFile;
+template <typename K, typename V>
+class LruCache;
+
+/**
+ * A kid validator for very large numbers of HMAC keys.
+ *
+ * The keys live in a hashed key file (see KeyStoreWriter) that is memory
+ * mapped, so the operating system pages in the parts of the file that are
+ * used. A validator for a kid is only constructed when a token with that kid
+ * is verified, and is kept in a bounded cache of recently used validators.
+ * Resident memory therefore scales with the number of active kids instead of
+ * the number of keys in the file.
+ */
+class KeyStoreValidator : public MessageValidator {
+public:
+  /**
+   * Opens the given key file.
+   *
+   * @param path The key file, created by KeyStoreWriter
+   * @param cache_size The maximum number of validators that are kept in
+   * memory
+   * @throw std::logic_error if the file cannot be read or is not a key file
+   */
+  KeyStoreValidator(const std::string &path, size_t cache_size);
+  ~KeyStoreValidator();
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t cHeader,
+              const uint8_t *signature, size_t cSignature) const override;
+  bool Accepts(const json &jose) const override;
+
+  /**
+   * The algorithm of the first key in the file.
+   */
+  std::string algorithm() const override;
+  Algorithm algorithm_id() const override;
+  std::string toJson() const override;
+
+  /**
+   * The number of keys in the key file.
+   */
+  size_t size() const { return num_keys_; }
+
+  /**
+   * The number of validators that are currently materialized.
+   */
+  size_t cache_size() const;
+
+private:
+  struct Key {
+    uint8_t algorithm;
+    const char *kid;
+    size_t num_kid;
+    const char *secret;
+    size_t num_secret;
+  };
+
+  bool Find(const json &jose, Key *key) const;
+  bool Lookup(const char *kid, size_t num_kid, Key *key) const;
+  bool ReadKey(uint64_t offset, Key *key) const;
+
+  std::string path_;
+  std::unique_ptr<MappedFile> file_;
+  std::unique_ptr<LruCache<std::string, MessageValidator>> cache_;
+  uint64_t num_buckets_;
+  uint64_t num_keys_;
+};
+
+/**
+ * Creates the key file used by the KeyStoreValidator.
+ */
+class KeyStoreWriter {
+public:
+  /**
+   * Adds a key.
+   *
+   * @param kid The key id
+   * @param algorithm HS256, HS384 or HS512
+   * @param secret The HMAC secret
+   * @throw std::logic_error if the algorithm is not supported, or the kid was
+   * already added
+   */
+  void Add(const std::string &kid, const std::string &algorithm,
+           const std::string &secret);
+
+  /**
+   * Writes the key file.
+   *
+   * @throw std::logic_error if the file cannot be written
+   */
+  void Write(const std::string &path) const;
+
+private:
+  struct Key {
+    std::string kid;
+    uint8_t algorithm;
+    std::string secret;
+  };
+  std::vector<Key> keys_;
+  std::unordered_set<std::string> kids_;
+};
+
+#endif // SRC_INCLUDE_JWT_KEYSTOREVALIDATOR_H_
@@ -24,10 +24,12 @@
 #define SRC_INCLUDE_JWT_KIDVALIDATOR_H_
 
 #include "jwt/messagevalidator.h"
-#include <map>
+#include <memory>
+#include <mutex>
 #include <stddef.h>
 #include <stdint.h>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -40,24 +42,83 @@
  * explicitly signal a change of key to recipients.  The structure of
  * the "kid" value is unspecified.  Its value MUST be a case-sensitive
  * string.
+ *
+ * The kid table is an immutable snapshot that is replaced as a whole
+ * whenever keys are registered, removed or swapped. Readers pick up the
+ * current snapshot and never wait for a writer, so keys can be rotated
+ * while tokens are being verified on other threads.
  */
 class KidValidator : public MessageValidator {
 public:
+  typedef std::unordered_map<std::string, std::shared_ptr<MessageValidator>>
+      KidMap;
+
   KidValidator();
 
+  /**
+   * Creates a kid validator that uses the given table.
+   * @param validators The key id to validator table
+   * @param first The key id that was listed first, see Swap
+   */
+  explicit KidValidator(const KidMap &validators,
+                        const std::string &first = std::string());
+
   /** Registers the given validator to handle the given key id.
    * @param kid The key id
-   * @param validator The validator that should handle this key id
+   * @param validator The validator that should handle this key id, the
+   * validator is not owned by the KidValidator and should outlive it.
    */
   void Register(const std::string &kid, MessageValidator *validator);
+
+  /** Registers the given validator to handle the given key id.
+   * @param kid The key id
+   * @param validator The validator that should handle this key id. It is
+   * released once it is no longer part of any snapshot in use.
+   */
+  void Register(const std::string &kid,
+                std::shared_ptr<MessageValidator> validator);
+
+  /** Removes the validator for the given key id.
+   * @param kid The key id
+   * @return true if the key id was registered
+   */
+  bool Unregister(const std::string &kid);
+
+  /** Atomically replaces the whole kid table. Verifications that are in
+   * flight finish with the table they started with.
+   *
+   * The table has no order, so algorithm() comes from the validator of the
+   * first key id, as if the keys were registered in their original order.
+   * Without a first key id the lexicographically smallest key id is used,
+   * which is the order of a json object.
+   * @param validators The new key id to validator table
+   * @param first The key id that was listed first
+   */
+  void Swap(const KidMap &validators,
+            const std::string &first = std::string());
+
   bool Verify(const json &jsonHeader, const uint8_t *header, size_t cHeader,
               const uint8_t *signature, size_t cSignature) const override;
   bool Accepts(const json &jose) const override;
-  std::string algorithm() const override { return algorithm_; }
+  std::string algorithm() const override;
+  Algorithm algorithm_id() const override;
   std::string toJson() const override;
 
 private:
-  std::map<std::string, MessageValidator *> validator_map_;
-  std::string algorithm_;
+  struct Snapshot {
+    Snapshot() : algorithm_id(Algorithm::UNKNOWN) {}
+
+    KidMap validators;
+    std::string algorithm;
+    Algorithm algorithm_id;
+  };
+  typedef std::shared_ptr<const Snapshot> snapshot_ptr;
+
+  snapshot_ptr Load() const;
+  void Publish(const snapshot_ptr &snapshot);
+  MessageValidator *Find(const json &jose, snapshot_ptr *snapshot) const;
+
+  snapshot_ptr snapshot_;
+  std::mutex writer_;
 };
 #endif // SRC_INCLUDE_JWT_KIDVALIDATOR_H_
@@ -25,17 +25,55 @@
 #define SRC_INCLUDE_JWT_LISTCLAIMVALIDATOR_H_
 
 #include "jwt/claimvalidator.h"
+#include <memory>
 #include <string>
 #include <vector>
 
+class StringSet;
+
+/**
+ * A ListClaimValidator accepts a claim if it is a string contained in the
+ * list of accepted values. The accepted values are hashed once at
+ * construction, so large allow lists are as cheap to check as small ones.
+ */
 class ListClaimValidator : public ClaimValidator {
 public:
   ListClaimValidator(const std::string &property, const std::vector<std::string> &accepted);
   bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+
+  /**
+   * Checks a string claim that has already been decoded.
+   */
+  ClaimStatus CheckValue(const std::string &value) const;
+
+  /**
+   * Checks a claim that has already been looked up, null if it is missing.
+   */
+  ClaimStatus CheckClaim(const json *claim) const;
+
+  /**
+   * The verdict of CheckClaim, without building a status.
+   */
+  bool AcceptsClaim(const json *claim) const;
+
+  /**
+   * The status of a claim that AcceptsClaim rejected.
+   */
+  ClaimStatus Failure(const json *claim) const;
   std::string toJson() const;
+  inline Cost cost() const { return kCheap; }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return ListOwnClaim(claims);
+  }
+  inline const std::vector<std::string> &accepted() const { return accepted_; }
+  inline const StringSet &accepted_set() const { return *accepted_set_; }
 
 protected:
+  ClaimStatus Failure(const json *claim, ClaimStatus::Wording wording) const;
+
   std::vector<std::string> accepted_;
+  std::shared_ptr<const StringSet> accepted_set_;
 };
 
 /**
@@ -80,6 +118,18 @@ class AudValidator : public ListClaimValidator {
 public:
   AudValidator(const std::vector<std::string> &accepted)
       : ListClaimValidator("aud", accepted) {}
-  bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+
+  /**
+   * Checks audiences that have already been decoded.
+   */
+  ClaimStatus CheckValues(const std::vector<std::string> &values) const;
+
+  /**
+   * Like the ListClaimValidator, but the claim may be an array.
+   */
+  ClaimStatus CheckClaim(const json *claim) const;
+  bool AcceptsClaim(const json *claim) const;
+  ClaimStatus Failure(const json *claim) const;
 };
 #endif // SRC_INCLUDE_JWT_LISTCLAIMVALIDATOR_H_
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <string>
+#include "jwt/algorithm.h"
 #include "jwt/allocators.h"
 #include "jwt/json.hpp"
 #include "jwt/jwt_error.h"
@@ -58,6 +59,13 @@ class MessageValidator {
      */
     virtual std::string algorithm() const = 0;
 
+    /**
+     * The JWS algorithm that this message validator can handle, UNKNOWN if
+     * it does not handle a single known algorithm. Validators override this
+     * so no strings have to be compared when dispatching on the algorithm.
+     */
+    virtual Algorithm algorithm_id() const;
+
     /**
      * True if the given jose header can be validated by this validtor.
      *
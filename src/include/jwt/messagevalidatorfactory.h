@@ -27,11 +27,15 @@
 #include "jwt/kidvalidator.h"
 #include "jwt/messagevalidator.h"
 #include <exception>
+#include <memory>
 #include <string>
 #include <vector>
 
 using json = nlohmann::json;
 
+class FileWatcher;
+class LazyValidator;
+
 class MessageValidatorFactory {
 public:
   static MessageValidator *Build(const std::string &msg);
@@ -42,7 +46,13 @@ public:
   ~MessageValidatorFactory();
 
 private:
+  friend class BundleCompiler;
+
+  MessageValidatorFactory();
   static std::string ParseSecret(const std::string &property, const json &object);
+  static std::vector<std::string> WatchedFiles(const json &validator);
+  static MessageValidator *BuildUnwatched(const json &validator);
+  static bool IsKeyed(const json &validator);
 
   std::vector<std::string> BuildList(const json &lst);
   std::vector<MessageValidator *> BuildValidatorList(const json &list);
@@ -50,6 +60,11 @@ private:
   MessageValidator *BuildKid(KidValidator *kid,const json &kidlist);
 
   std::vector<MessageValidator *> build_;
+  std::unique_ptr<FileWatcher> watcher_;
+  bool watch_;
+  bool lazy_;
+  bool warmup_;
+  std::vector<LazyValidator *> lazy_validators_;
 };
 
 #endif // SRC_INCLUDE_JWT_MESSAGEVALIDATORFACTORY_H_
@@ -0,0 +1,87 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_MULTIKEYVALIDATOR_H_
+#define SRC_INCLUDE_JWT_MULTIKEYVALIDATOR_H_
+
+#include "jwt/messagevalidator.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class RSAValidator;
+
+/**
+ * A validator that holds several validators per algorithm, and accepts a
+ * token if any of the validators for its algorithm verifies it. This makes it
+ * possible to rotate keys for issuers that do not send a kid.
+ *
+ * The validator that verified the last token for an algorithm is tried
+ * first. When all the candidates for an algorithm are RSA validators the
+ * digest of the signing input is computed once, and only the public key
+ * operation is done for every candidate.
+ */
+class MultiKeyValidator : public MessageValidator {
+public:
+  /**
+   * @param validators The validators to try, they are not owned by this
+   * validator and should outlive it.
+   */
+  explicit MultiKeyValidator(const std::vector<MessageValidator *> &validators);
+  ~MultiKeyValidator();
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t cHeader,
+              const uint8_t *signature, size_t cSignature) const override;
+  bool Accepts(const json &jose) const override;
+
+  /**
+   * The algorithm of the validators, or MULTI if they use several
+   * algorithms.
+   */
+  std::string algorithm() const override;
+  Algorithm algorithm_id() const override;
+  std::string toJson() const override;
+
+private:
+  struct Candidates {
+    Candidates() : last(0) {}
+
+    std::vector<MessageValidator *> validators;
+    // Same order as validators, empty unless all of them are RSA validators.
+    std::vector<const RSAValidator *> rsa;
+    mutable std::atomic<size_t> last;
+  };
+
+  Candidates *Find(const json &jose) const;
+  static Candidates *Add(std::unique_ptr<Candidates> *candidates,
+                         MessageValidator *validator);
+
+  std::vector<MessageValidator *> validators_;
+  std::unique_ptr<Candidates> candidates_[Algorithms::kCount];
+  std::map<std::string, std::unique_ptr<Candidates>> unknown_;
+};
+
+#endif // SRC_INCLUDE_JWT_MULTIKEYVALIDATOR_H_
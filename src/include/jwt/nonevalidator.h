@@ -38,6 +38,7 @@ public:
             size_t *num_signature) const;
 
   std::string algorithm() const { return "none"; }
+  Algorithm algorithm_id() const { return Algorithm::none; }
 
   std::string toJson() const { return "{ \"none\" : null }"; }
 };
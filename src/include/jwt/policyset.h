@@ -0,0 +1,100 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_POLICYSET_H_
+#define SRC_INCLUDE_JWT_POLICYSET_H_
+
+#include "jwt/claimpath.h"
+#include "jwt/claimvalidator.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A PolicySet evaluates a payload against many claim validators at once, for
+ * example one per route of a gateway. Validators that occur in several
+ * policies, such as a shared exp or iss check, are merged and run at most
+ * once per payload:
+ *
+ *   PolicySet routes({admin.get(), api.get()});
+ *   json header, payload;
+ *   std::tie(header, payload) = JWT::Decode(token, &validator);
+ *   uint64_t allowed = routes.Evaluate(payload);
+ *
+ * Built in validators are merged when they are configured the same, any
+ * other validator only with itself. Stateful validators, such as the jti
+ * validator, are only merged with themselves and run at most once.
+ */
+class PolicySet {
+public:
+  using json = nlohmann::json;
+  static const size_t kMaxPolicies = 64;
+
+  /**
+   * Merges the given policies. The policies must outlive the set.
+   *
+   * @throw std::logic_error if there are more than kMaxPolicies policies.
+   */
+  explicit PolicySet(const std::vector<const ClaimValidator *> &policies);
+
+  /**
+   * Evaluates all policies against the claimset.
+   *
+   * @return a mask with bit i set if policy i accepts the claimset.
+   */
+  uint64_t Evaluate(const json &claimset) const;
+
+  /**
+   * True if the given policy accepts the claimset.
+   */
+  static inline bool Accepts(uint64_t mask, size_t policy) {
+    return (mask >> policy) & 1;
+  }
+
+  inline size_t size() const { return roots_.size(); }
+
+  /**
+   * The number of distinct validators after merging.
+   */
+  inline size_t checks() const { return nodes_.size(); }
+
+private:
+  enum Kind { kLeaf, kAll, kAny, kOptional };
+
+  struct Node {
+    Kind kind;
+    const ClaimValidator *leaf;
+    std::vector<uint32_t> children;
+    ClaimPath path;  // the claim an optional node looks for
+  };
+
+  uint32_t Add(const ClaimValidator *validator);
+  uint32_t Intern(const std::string &key, const Node &node);
+  bool Eval(uint32_t node, const json &claimset, uint8_t *memo) const;
+
+  std::vector<Node> nodes_;
+  std::unordered_map<std::string, uint32_t> index_;
+  std::vector<uint32_t> roots_;
+};
+
+#endif // SRC_INCLUDE_JWT_POLICYSET_H_
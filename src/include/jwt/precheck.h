@@ -0,0 +1,76 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_PRECHECK_H_
+#define SRC_INCLUDE_JWT_PRECHECK_H_
+
+#include "jwt/claimvalidator.h"
+#include "jwt/decodelimits.h"
+#include "jwt/json.hpp"
+#include <stddef.h>
+#include <vector>
+
+/**
+ * A Precheck rejects tokens before their signature is verified, which is by
+ * far the most expensive step for RSA and ECDSA tokens. It runs the cheap
+ * checks of a claim validator, such as exp, nbf and iss, on the unverified
+ * payload and enforces the DecodeLimits.
+ *
+ * A precheck can only reject a token. A token that passes it is still
+ * verified and validated by JWT::Decode as usual.
+ */
+class Precheck {
+public:
+  using json = nlohmann::json;
+
+  /**
+   * Selects the checks of the validator that can run before the signature is
+   * verified: the validator itself if it is cheap, otherwise the cheap
+   * children of an all validator, recursively. Stateful validators are never
+   * selected, so forged tokens cannot change their state.
+   *
+   * @param validator The claim validator used to decode tokens, which must
+   * outlive the precheck. May be null to only check the size.
+   * @param limits The size and structure limits of tokens.
+   */
+  explicit Precheck(const ClaimValidator *validator,
+                    const DecodeLimits &limits = DecodeLimits());
+
+  /**
+   * @throw InvalidClaimError if any of the selected checks rejects
+   */
+  void CheckClaims(const json &payload) const;
+
+  inline const std::vector<const ClaimValidator *> &checks() const {
+    return checks_;
+  }
+
+  inline const DecodeLimits &limits() const { return limits_; }
+
+private:
+  void Select(const ClaimValidator *validator);
+
+  std::vector<const ClaimValidator *> checks_;
+  DecodeLimits limits_;
+};
+
+#endif // SRC_INCLUDE_JWT_PRECHECK_H_
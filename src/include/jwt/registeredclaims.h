@@ -0,0 +1,161 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_REGISTEREDCLAIMS_H_
+#define SRC_INCLUDE_JWT_REGISTEREDCLAIMS_H_
+
+#include "jwt/json.hpp"
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+template <typename T> class ClaimFields;
+
+/**
+ * The registered claims of a payload as typed fields. A claim that is absent,
+ * or does not have the type the spec requires, is not present. Strings in aud
+ * are kept and other elements are dropped, a single string becomes a list of
+ * one.
+ *
+ * Derive from this to decode a payload straight into a struct with
+ * JWT::Decode<T>, and list the other members in a static Describe method:
+ *
+ *   struct Session : RegisteredClaims {
+ *     std::string name;
+ *     bool admin = false;
+ *     static void Describe(ClaimFields<Session> *fields) {
+ *       fields->Add("name", &Session::name).Add("admin", &Session::admin);
+ *     }
+ *   };
+ */
+class RegisteredClaims {
+public:
+  enum Claim : uint32_t {
+    kIss = 1 << 0,
+    kSub = 1 << 1,
+    kAud = 1 << 2,
+    kExp = 1 << 3,
+    kNbf = 1 << 4,
+    kIat = 1 << 5,
+    kJti = 1 << 6
+  };
+
+  RegisteredClaims() : exp(0), nbf(0), iat(0), present(0) {}
+
+  inline bool has(Claim claim) const { return (present & claim) != 0; }
+
+  /**
+   * The claim for the given registered name, 0 if the name is not registered.
+   */
+  static Claim Find(const std::string &name);
+
+  /**
+   * A type without other members has nothing to describe.
+   */
+  template <typename T> static void Describe(ClaimFields<T> *) {}
+
+  std::string iss;
+  std::string sub;
+  std::vector<std::string> aud;
+  int64_t exp;
+  int64_t nbf;
+  int64_t iat;
+  std::string jti;
+  uint32_t present;
+};
+
+/**
+ * The members of a type besides its registered claims, with the top level
+ * claims they are decoded from. This is the type erased part, see ClaimFields.
+ */
+class ClaimFieldsBase {
+public:
+  enum Kind { kString, kInteger, kNumber, kBoolean, kStrings, kJson };
+
+  struct Field {
+    std::string name;
+    Kind kind;
+    // Returns the address of the member in the object.
+    std::function<void *(void *)> address;
+  };
+
+  /**
+   * The field decoded from the given claim, or nullptr.
+   */
+  const Field *Find(const std::string &name) const;
+
+  inline const std::vector<Field> &fields() const { return fields_; }
+
+protected:
+  /**
+   * @throw std::logic_error if the claim is registered or already added
+   */
+  void Insert(const std::string &name, Kind kind,
+              std::function<void *(void *)> address);
+
+  std::vector<Field> fields_;
+};
+
+/**
+ * Describes the members of T that JWT::Decode<T> fills. A member is filled if
+ * its claim is present, and the token is rejected if the claim has another
+ * type. Members of any other type can be decoded as json.
+ */
+template <typename T> class ClaimFields : public ClaimFieldsBase {
+public:
+  /**
+   * Collects the fields T lists in its Describe method.
+   */
+  ClaimFields() { T::Describe(this); }
+
+  ClaimFields &Add(const std::string &name, std::string T::*field) {
+    return Add(name, kString, field);
+  }
+  ClaimFields &Add(const std::string &name, int64_t T::*field) {
+    return Add(name, kInteger, field);
+  }
+  ClaimFields &Add(const std::string &name, double T::*field) {
+    return Add(name, kNumber, field);
+  }
+  ClaimFields &Add(const std::string &name, bool T::*field) {
+    return Add(name, kBoolean, field);
+  }
+  ClaimFields &Add(const std::string &name,
+                   std::vector<std::string> T::*field) {
+    return Add(name, kStrings, field);
+  }
+  ClaimFields &Add(const std::string &name, nlohmann::json T::*field) {
+    return Add(name, kJson, field);
+  }
+
+private:
+  template <typename M>
+  ClaimFields &Add(const std::string &name, Kind kind, M T::*field) {
+    Insert(name, kind, [field](void *object) -> void * {
+      return &(static_cast<T *>(object)->*field);
+    });
+    return *this;
+  }
+};
+
+#endif // SRC_INCLUDE_JWT_REGISTEREDCLAIMS_H_
@@ -0,0 +1,118 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_REVOCATIONVALIDATOR_H_
+#define SRC_INCLUDE_JWT_REVOCATIONVALIDATOR_H_
+
+#include "jwt/claimvalidator.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class FileWatcher;
+
+/**
+ * A RevocationValidator rejects tokens whose claims, usually jti or sub, are
+ * listed in a revocation file (see RevocationWriter).
+ *
+ * The file is memory mapped. It starts with a blocked bloom filter, so a
+ * value that is not revoked costs a single cache line of the filter. Hits are
+ * confirmed against the exact list of revoked values that follows the filter.
+ *
+ * The file is watched, and a new revocation list is swapped in atomically
+ * when it changes. The current list is kept if the new file cannot be read.
+ * As the file is mapped it must be replaced with a rename, the way
+ * RevocationWriter does, and never be rewritten in place.
+ */
+class RevocationValidator : public ClaimValidator {
+public:
+  /**
+   * Opens the given revocation file.
+   *
+   * @param path The revocation file, created by RevocationWriter
+   * @param claims The claims that are checked against the file, top level
+   * names or JSON pointers
+   * @param watch True if the file should be reloaded when it changes
+   * @throw std::logic_error if the file cannot be read or is not a revocation
+   * file
+   */
+  RevocationValidator(const std::string &path,
+                      const std::vector<std::string> &claims,
+                      bool watch = true);
+  ~RevocationValidator();
+
+  bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+  inline Cost cost() const { return kExpensive; }
+  bool ListClaims(std::vector<std::string> *claims) const;
+  std::string toJson() const;
+
+  /**
+   * Reads the revocation file again.
+   *
+   * @return true if the revocation list was replaced
+   */
+  bool Reload();
+
+  /**
+   * The number of revoked values in the current revocation list.
+   */
+  size_t size() const;
+
+private:
+  class Revocations;
+
+  std::string path_;
+  std::vector<std::string> claims_;
+  std::vector<ClaimPath> paths_;
+  std::vector<uint64_t> prefixes_;
+  std::shared_ptr<const Revocations> revocations_;
+  std::unique_ptr<FileWatcher> watcher_;
+};
+
+/**
+ * Creates the revocation file used by the RevocationValidator.
+ */
+class RevocationWriter {
+public:
+  /**
+   * Revokes tokens where the claim has the given value.
+   */
+  void Add(const std::string &claim, const std::string &value);
+
+  /**
+   * Writes the revocation file. The file is written next to the path and
+   * renamed into place, so readers never observe a partial file.
+   *
+   * @throw std::logic_error if the file cannot be written
+   */
+  void Write(const std::string &path) const;
+
+private:
+  std::set<std::pair<std::string, std::string>> revoked_;
+};
+
+#endif // SRC_INCLUDE_JWT_REVOCATIONVALIDATOR_H_
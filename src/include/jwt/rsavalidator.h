@@ -39,6 +39,12 @@ public:
   explicit RSAValidator(const std::string &algorithm, const EVP_MD *md,
                         const std::string &public_key,
                         const std::string &private_key);
+  /**
+   * Creates a validator for an already materialized public key. The validator
+   * takes its own reference on the key.
+   */
+  explicit RSAValidator(const std::string &algorithm, const EVP_MD *md,
+                        EVP_PKEY *public_key);
   virtual ~RSAValidator();
 
   bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
@@ -46,13 +52,31 @@ public:
   bool Sign(const uint8_t *header, size_t num_header, uint8_t *signature,
             size_t *num_signature) const override;
 
+  /**
+   * Verifies the signature against an already computed digest of the
+   * signing input. This allows the digest to be shared when trying several
+   * keys.
+   *
+   * @param digest The digest of the header, computed with md()
+   * @param num_digest The size of the digest
+   * @param signature The binary signature
+   * @param num_signature The length of the signature
+   */
+  bool VerifyDigest(const uint8_t *digest, size_t num_digest,
+                    const uint8_t *signature, size_t num_signature) const;
+
+  /**
+   * The digest used by this validator.
+   */
+  inline const EVP_MD *md() const { return md_; }
+
   inline std::string algorithm() const override { return algorithm_; }
+  inline Algorithm algorithm_id() const override { return algorithm_id_; }
   std::string toJson() const override;
 
 private:
-  EVP_PKEY *LoadKey(const char *key, bool public_key);
-
   std::string algorithm_;
+  Algorithm algorithm_id_;
   EVP_PKEY *private_key_;
   EVP_PKEY *public_key_;
   const EVP_MD *md_;
@@ -68,6 +92,8 @@ public:
   explicit RS256Validator(const std::string &public_key,
                           const std::string &private_key)
       : RSAValidator("RS256", EVP_sha256(), public_key, private_key) {}
+  explicit RS256Validator(EVP_PKEY *public_key)
+      : RSAValidator("RS256", EVP_sha256(), public_key) {}
 };
 
 /**
@@ -80,6 +106,8 @@ public:
   explicit RS384Validator(const std::string &public_key,
                           const std::string &private_key)
       : RSAValidator("RS384", EVP_sha384(), public_key, private_key) {}
+  explicit RS384Validator(EVP_PKEY *public_key)
+      : RSAValidator("RS384", EVP_sha384(), public_key) {}
 };
 
 /**
@@ -92,5 +120,7 @@ public:
   explicit RS512Validator(const std::string &public_key,
                           const std::string &private_key)
       : RSAValidator("RS512", EVP_sha512(), public_key, private_key) {}
+  explicit RS512Validator(EVP_PKEY *public_key)
+      : RSAValidator("RS512", EVP_sha512(), public_key) {}
 };
 #endif // SRC_INCLUDE_JWT_RSAVALIDATOR_H_
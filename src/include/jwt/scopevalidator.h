@@ -0,0 +1,75 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_SCOPEVALIDATOR_H_
+#define SRC_INCLUDE_JWT_SCOPEVALIDATOR_H_
+
+#include "jwt/claimvalidator.h"
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+class StringSet;
+
+/**
+ * A ScopeValidator checks that a scope or roles claim grants the required
+ * permissions. The claim is either a space separated string, as in the
+ * OAuth scope claim, or an array of strings.
+ *
+ * The scopes the validator knows about are interned into bit positions when
+ * it is constructed. A token's claim is converted into a bitset in a single
+ * pass, after which the required and any of masks are checked a word at a
+ * time. Scopes the validator does not know about are ignored.
+ */
+class ScopeValidator : public ClaimValidator {
+public:
+  /**
+   * @param property The claim holding the scopes, usually scope or roles
+   * @param required The scopes that must all be present
+   * @param any_of At least one of these scopes must be present, if not empty
+   */
+  ScopeValidator(const std::string &property,
+                 const std::vector<std::string> &required,
+                 const std::vector<std::string> &any_of);
+  ~ScopeValidator();
+
+  bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return ListOwnClaim(claims);
+  }
+  std::string toJson() const;
+
+private:
+  static const size_t kInlineWords = 4;
+
+  void Set(const char *scope, size_t len, uint64_t *granted) const;
+
+  std::vector<std::string> required_;
+  std::vector<std::string> any_of_;
+  std::unique_ptr<StringSet> scopes_;
+  std::vector<uint64_t> required_mask_;
+  std::vector<uint64_t> any_mask_;
+};
+
+#endif // SRC_INCLUDE_JWT_SCOPEVALIDATOR_H_
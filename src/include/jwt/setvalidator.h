@@ -32,7 +32,11 @@
 
 /**
  * A validator that delegates to a set of registered
- * validators.
+ * validators, one for every algorithm.
+ *
+ * Known algorithms are dispatched through a table indexed by the
+ * Algorithm enum, only validators for other algorithms are looked up by
+ * name.
  */
 class SetValidator : public MessageValidator {
 public:
@@ -40,11 +44,15 @@ public:
   bool Verify(const json &jsonHeader, const uint8_t *header, size_t cHeader,
               const uint8_t *signature, size_t cSignature) const override;
   std::string algorithm() const override { return "SET"; }
+  Algorithm algorithm_id() const override { return Algorithm::UNKNOWN; }
   std::string toJson() const override;
   bool Accepts(const json &jose) const override;
 
 private:
-  std::map<std::string, MessageValidator *> validator_map_;
+  MessageValidator *Find(const json &jose) const;
+
+  MessageValidator *validators_[Algorithms::kCount];
+  std::map<std::string, MessageValidator *> unknown_;
 };
 
 #endif // SRC_INCLUDE_JWT_SETVALIDATOR_H_
@@ -0,0 +1,371 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_JWT_STATICPOLICY_H_
+#define SRC_INCLUDE_JWT_STATICPOLICY_H_
+
+#include "jwt/claimvalidator.h"
+#include "jwt/timevalidator.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/**
+ * Claim policies that are known at compile time can be composed from
+ * templates instead of being built by the ClaimValidatorFactory. The checks
+ * are resolved by the compiler, so validating allocates nothing and makes no
+ * virtual calls, apart from reading the clock once:
+ *
+ *   JWT_CLAIM_VALUES(Issuers, "a", "b");
+ *   JWT_CLAIM_VALUES(Audience, "api");
+ *   policy::Policy<policy::All<policy::Exp<30>, policy::Iss<Issuers>,
+ *                              policy::Aud<Audience>>> validator;
+ *
+ * A Policy is a ClaimValidator, and its toJson describes the equivalent
+ * validator for the ClaimValidatorFactory.
+ */
+
+/**
+ * Declares a type holding the accepted values of an iss, sub or aud check.
+ * The values are string literals, they are matched against a constant array
+ * that is laid out by the compiler.
+ */
+#define JWT_CLAIM_VALUES(name, ...)                                           \
+  struct name {                                                               \
+    static bool Contains(const std::string &value) {                         \
+      static const policy::Literal literals[] = {__VA_ARGS__};                \
+      return policy::Contains(literals, value);                               \
+    }                                                                         \
+    static const std::vector<std::string> &values() {                        \
+      static const std::vector<std::string> values = {__VA_ARGS__};           \
+      return values;                                                          \
+    }                                                                         \
+  }
+
+namespace policy {
+
+using json = nlohmann::json;
+
+/**
+ * A string literal and its length.
+ */
+struct Literal {
+  template <size_t N>
+  constexpr Literal(const char (&value)[N]) : data(value), size(N - 1) {}
+
+  const char *data;
+  size_t size;
+};
+
+template <size_t N>
+inline bool Contains(const Literal (&literals)[N], const std::string &value) {
+  for (const auto &literal : literals) {
+    if (literal.size == value.size() &&
+        memcmp(literal.data, value.data(), literal.size) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+constexpr ClaimValidator::Cost MaxCost(ClaimValidator::Cost a,
+                                       ClaimValidator::Cost b) {
+  return a < b ? b : a;
+}
+
+#define JWT_POLICY_CLAIM(type, claim)                                         \
+  struct type {                                                               \
+    static const std::string &name() {                                        \
+      static const std::string name(claim);                                   \
+      return name;                                                            \
+    }                                                                         \
+  }
+JWT_POLICY_CLAIM(IssClaim, "iss");
+JWT_POLICY_CLAIM(SubClaim, "sub");
+JWT_POLICY_CLAIM(AudClaim, "aud");
+JWT_POLICY_CLAIM(ExpClaim, "exp");
+JWT_POLICY_CLAIM(NbfClaim, "nbf");
+JWT_POLICY_CLAIM(IatClaim, "iat");
+#undef JWT_POLICY_CLAIM
+
+template <typename Claim>
+inline const json *FindClaim(const json &claims) {
+  if (!claims.is_object()) {
+    return nullptr;
+  }
+  auto found = claims.find(Claim::name());
+  return found == claims.end() ? nullptr : &*found;
+}
+
+/**
+ * A timestamp check, with the semantics of the TimeValidator.
+ */
+template <typename Claim, bool Sign, uint64_t Leeway>
+struct TimeCheck {
+  static const bool kUsesTime = true;
+  static const ClaimValidator::Cost kCost = ClaimValidator::kCheap;
+
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    claims->push_back(Claim::name());
+  }
+
+  static inline const json *Find(const json &claims) {
+    return FindClaim<Claim>(claims);
+  }
+
+  static inline ClaimStatus Check(const json &claims, uint64_t now) {
+    const json *value = Find(claims);
+    if (!value) {
+      return Failure(ClaimStatus::kMissing);
+    }
+    if (!value->is_number()) {
+      return Failure(ClaimStatus::kWrongType, value);
+    }
+    int64_t time = value->get<int64_t>();
+    if (time < 0) {
+      return Failure(ClaimStatus::kNegative);
+    }
+    return TimeValidator::Accepts(time, now, Sign, Leeway)
+               ? ClaimStatus()
+               : Failure(ClaimStatus::kInvalid);
+  }
+
+  static inline ClaimStatus Failure(ClaimStatus::Code code,
+                                    const json *value = nullptr) {
+    return ClaimStatus(code, &Claim::name(), value, ClaimStatus::kTime);
+  }
+
+  static json ToJson(IClock *clock) {
+    if (clock == TimeValidator::coarse_clock()) {
+      return json({{Claim::name(), {{"leeway", Leeway}, {"clock", "coarse"}}}});
+    }
+    json leeway = Leeway ? json({{"leeway", Leeway}}) : json();
+    return json({{Claim::name(), leeway}});
+  }
+};
+
+template <uint64_t Leeway = 0>
+using Exp = TimeCheck<ExpClaim, false, Leeway>;
+template <uint64_t Leeway = 0>
+using Nbf = TimeCheck<NbfClaim, true, Leeway>;
+template <uint64_t Leeway = 0>
+using Iat = TimeCheck<IatClaim, true, Leeway>;
+
+/**
+ * A string claim that must be one of the values, with the semantics of the
+ * ListClaimValidator. An aud claim may also be an array of strings.
+ */
+template <typename Claim, typename Values, bool AllowArray>
+struct ListCheck {
+  static const bool kUsesTime = false;
+  static const ClaimValidator::Cost kCost = ClaimValidator::kCheap;
+
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    claims->push_back(Claim::name());
+  }
+
+  static inline const json *Find(const json &claims) {
+    return FindClaim<Claim>(claims);
+  }
+
+  static inline ClaimStatus Check(const json &claims, uint64_t) {
+    const json *value = Find(claims);
+    if (!value) {
+      return Failure(ClaimStatus::kMissing);
+    }
+    if (value->is_string()) {
+      return Values::Contains(value->get_ref<const std::string &>())
+                 ? ClaimStatus()
+                 : Failure(ClaimStatus::kInvalid);
+    }
+    if (!AllowArray || !value->is_array()) {
+      return Failure(ClaimStatus::kWrongType, value);
+    }
+    for (const auto &element : *value) {
+      if (element.is_string() &&
+          Values::Contains(element.get_ref<const std::string &>())) {
+        return ClaimStatus();
+      }
+    }
+    return Failure(ClaimStatus::kInvalid, value);
+  }
+
+  static inline ClaimStatus Failure(ClaimStatus::Code code,
+                                    const json *value = nullptr) {
+    return ClaimStatus(code, &Claim::name(), value,
+                       AllowArray ? ClaimStatus::kAud : ClaimStatus::kList);
+  }
+
+  static json ToJson(IClock *) {
+    return json({{Claim::name(), Values::values()}});
+  }
+};
+
+template <typename Values>
+using Iss = ListCheck<IssClaim, Values, false>;
+template <typename Values>
+using Sub = ListCheck<SubClaim, Values, false>;
+template <typename Values>
+using Aud = ListCheck<AudClaim, Values, true>;
+
+/**
+ * Accepts if the claim of the wrapped check is missing, or the check accepts.
+ */
+template <typename Inner>
+struct Optional {
+  static const bool kUsesTime = Inner::kUsesTime;
+  static const ClaimValidator::Cost kCost = Inner::kCost;
+
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    Inner::ListClaims(claims);
+  }
+
+  static inline ClaimStatus Check(const json &claims, uint64_t now) {
+    return Inner::Find(claims) ? Inner::Check(claims, now) : ClaimStatus();
+  }
+
+  static json ToJson(IClock *clock) {
+    return json({{"optional", Inner::ToJson(clock)}});
+  }
+};
+
+template <typename... Checks>
+struct Sequence;
+
+template <>
+struct Sequence<> {
+  static const bool kUsesTime = false;
+  static const ClaimValidator::Cost kCost = ClaimValidator::kCheap;
+
+  static inline ClaimStatus All(const json &, uint64_t) {
+    return ClaimStatus();
+  }
+  static inline bool Any(const json &, uint64_t) { return false; }
+  static inline void ListClaims(std::vector<std::string> *) {}
+  static inline void ToJson(IClock *, json *) {}
+};
+
+template <typename First, typename... Rest>
+struct Sequence<First, Rest...> {
+  static const bool kUsesTime = First::kUsesTime || Sequence<Rest...>::kUsesTime;
+  static const ClaimValidator::Cost kCost =
+      MaxCost(First::kCost, Sequence<Rest...>::kCost);
+
+  static inline ClaimStatus All(const json &claims, uint64_t now) {
+    ClaimStatus status = First::Check(claims, now);
+    return status ? Sequence<Rest...>::All(claims, now) : status;
+  }
+  static inline bool Any(const json &claims, uint64_t now) {
+    return First::Check(claims, now).valid() ||
+           Sequence<Rest...>::Any(claims, now);
+  }
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    First::ListClaims(claims);
+    Sequence<Rest...>::ListClaims(claims);
+  }
+  static inline void ToJson(IClock *clock, json *list) {
+    list->push_back(First::ToJson(clock));
+    Sequence<Rest...>::ToJson(clock, list);
+  }
+};
+
+/**
+ * Accepts if all of the checks accept.
+ */
+template <typename... Checks>
+struct All {
+  static const bool kUsesTime = Sequence<Checks...>::kUsesTime;
+  static const ClaimValidator::Cost kCost = Sequence<Checks...>::kCost;
+
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    Sequence<Checks...>::ListClaims(claims);
+  }
+
+  static inline ClaimStatus Check(const json &claims, uint64_t now) {
+    return Sequence<Checks...>::All(claims, now);
+  }
+
+  static json ToJson(IClock *clock) {
+    json list = json::array();
+    Sequence<Checks...>::ToJson(clock, &list);
+    return json({{"all", list}});
+  }
+};
+
+/**
+ * Accepts if at least one of the checks accepts.
+ */
+template <typename... Checks>
+struct Any {
+  static const bool kUsesTime = Sequence<Checks...>::kUsesTime;
+  static const ClaimValidator::Cost kCost = Sequence<Checks...>::kCost;
+
+  static inline void ListClaims(std::vector<std::string> *claims) {
+    Sequence<Checks...>::ListClaims(claims);
+  }
+
+  static inline ClaimStatus Check(const json &claims, uint64_t now) {
+    return Sequence<Checks...>::Any(claims, now)
+               ? ClaimStatus()
+               : ClaimStatus(ClaimStatus::kNoneValid, nullptr);
+  }
+
+  static json ToJson(IClock *clock) {
+    json list = json::array();
+    Sequence<Checks...>::ToJson(clock, &list);
+    return json({{"any", list}});
+  }
+};
+
+/**
+ * A ClaimValidator that validates the claims with the given check.
+ */
+template <typename Root>
+class Policy : public ClaimValidator {
+public:
+  explicit Policy(IClock *clock = TimeValidator::utc_clock())
+      : ClaimValidator(""), clock_(clock) {}
+
+  bool IsValid(const json &claimset) const {
+    return Check(claimset).ThrowIfInvalid();
+  }
+
+  ClaimStatus Check(const json &claimset) const {
+    uint64_t now = Root::kUsesTime ? TimeValidator::Now(clock_) : 0;
+    return Root::Check(claimset, now);
+  }
+
+  std::string toJson() const { return Root::ToJson(clock_).dump(); }
+  inline Cost cost() const { return Root::kCost; }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    Root::ListClaims(claims);
+    return true;
+  }
+
+private:
+  IClock *clock_;
+};
+
+}  // namespace policy
+
+#endif // SRC_INCLUDE_JWT_STATICPOLICY_H_
@@ -27,6 +27,7 @@
 #include <string>
 class IClock;
 class UtcClock;
+class CoarseClock;
 
 class TimeValidator : public ClaimValidator {
 public:
@@ -34,13 +35,74 @@ public:
   TimeValidator(const char *key, bool sign);
   TimeValidator(const char *key, bool sign, uint64_t leeway, IClock *clock);
   bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+
+  /**
+   * Checks a time that has already been decoded.
+   */
+  ClaimStatus CheckTime(int64_t time) const;
+
+  /**
+   * Checks a claim that has already been looked up, null if it is missing.
+   */
+  ClaimStatus CheckClaim(const json *claim) const;
+
+  /**
+   * The verdict of CheckClaim, without building a status.
+   */
+  bool AcceptsClaim(const json *claim) const;
+
+  /**
+   * The status of a claim that AcceptsClaim rejected.
+   */
+  ClaimStatus Failure(const json *claim) const;
+
+  /**
+   * The rule all time checks share: true if the timestamp is accepted at the
+   * given time by a check with the given sign and leeway.
+   */
+  static inline bool Accepts(int64_t time, int64_t now, bool sign,
+                             uint64_t leeway) {
+    if (time < 0) {
+      return false;
+    }
+    int64_t diff = now - time;
+    int64_t min = diff - leeway;
+    int64_t max = diff + leeway;
+    return sign ? (min >= 0 || max >= 0) : (min <= 0 || max <= 0);
+  }
+  inline Cost cost() const { return kCheap; }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return ListOwnClaim(claims);
+  }
   std::string toJson() const;
+  inline bool sign() const { return sign_; }
+  inline uint64_t leeway() const { return leeway_; }
+  inline IClock *clock() const { return clock_; }
+
+  /**
+   * The clock used by default, it converts the current time through the
+   * calendar functions of the C library.
+   */
+  static IClock *utc_clock();
+
+  /**
+   * A clock that reads a coarse timestamp without any calendar conversion.
+   * It can be selected with "clock" : "coarse" in the factory.
+   */
+  static IClock *coarse_clock();
+
+  /**
+   * The current time according to the given clock.
+   */
+  static uint64_t Now(IClock *clock);
 
 private:
   bool sign_;
   uint64_t leeway_;
   IClock *clock_;
   static UtcClock utc_clock_;
+  static CoarseClock coarse_clock_;
 };
 
 /**
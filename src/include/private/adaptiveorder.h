@@ -0,0 +1,91 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_ADAPTIVEORDER_H_
+#define SRC_INCLUDE_PRIVATE_ADAPTIVEORDER_H_
+
+#include "jwt/claimvalidator.h"
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * The order in which an adaptive all or any validator evaluates its children.
+ * Every child counts how often it was evaluated and how often it decided the
+ * outcome, that is rejected for an all or accepted for an any, with relaxed
+ * atomics. Every kInterval evaluations the children are sorted by how often
+ * they decide the outcome, weighed by their cost, and the counters are
+ * halved so the order follows the traffic.
+ *
+ * Stateful children keep their position, the children before and after them
+ * are sorted separately. The order is packed into a single word, four bits a
+ * child, so readers always see a complete permutation.
+ */
+class AdaptiveOrder {
+public:
+  using json = nlohmann::json;
+  static const size_t kMaxChildren = 16;
+  static const uint32_t kInterval = 1024;
+
+  /**
+   * @param children at most kMaxChildren validators, which must outlive this.
+   * @param decide_on the outcome of a child that decides the verdict, false
+   * for an all validator and true for an any validator.
+   */
+  AdaptiveOrder(const std::vector<ClaimValidator *> &children, bool decide_on);
+
+  /**
+   * The status of the first child that rejects, or valid if all accept.
+   */
+  ClaimStatus All(const json &claimset) const;
+
+  /**
+   * True if any of the children accepts.
+   */
+  bool Any(const json &claimset) const;
+
+  /**
+   * The child evaluated at the given position.
+   */
+  inline size_t At(size_t position) const {
+    return (order_.load(std::memory_order_acquire) >> (4 * position)) & 0xf;
+  }
+
+private:
+  struct Counters {
+    std::atomic<uint32_t> evaluated;
+    std::atomic<uint32_t> decided;
+  };
+
+  void Record(size_t child, bool valid) const;
+  void Reorder() const;
+
+  std::vector<ClaimValidator *> children_;
+  std::vector<uint32_t> weights_;
+  bool decide_on_;
+  std::unique_ptr<Counters[]> counters_;
+  mutable std::atomic<uint64_t> order_;
+  mutable std::atomic<uint32_t> calls_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_ADAPTIVEORDER_H_
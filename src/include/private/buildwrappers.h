@@ -25,7 +25,13 @@
 
 #include "jwt/claimvalidator.h"
 #include "jwt/messagevalidator.h"
+#include "private/filewatcher.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 class ParsedClaimvalidator : public ClaimValidator {
@@ -35,7 +41,19 @@ public:
   ~ParsedClaimvalidator();
 
   bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
   std::string toJson() const;
+  inline Cost cost() const { return root_->cost(); }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return root_->ListClaims(claims);
+  }
+  inline const ClaimValidator *root() const { return root_; }
+  inline Composition Children(const ClaimValidator *const **children,
+                              size_t *num_children) const {
+    *children = &root_;
+    *num_children = 1;
+    return kWrapper;
+  }
 
 private:
   json json_;
@@ -43,22 +61,121 @@ private:
   ClaimValidator *root_;
 };
 
+class LazyValidator;
+
 class ParsedMessagevalidator : public MessageValidator {
 public:
   ParsedMessagevalidator(const json &json,
                          const std::vector<MessageValidator *> &children,
-                         MessageValidator *root);
+                         MessageValidator *root,
+                         FileWatcher *watcher = nullptr);
   ~ParsedMessagevalidator();
 
   bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
               const uint8_t *signature, size_t num_signature) const;
   std::string algorithm() const;
+  Algorithm algorithm_id() const;
   bool Accepts(const json &jose) const;
   std::string toJson() const;
 
+  /**
+   * Materializes the given lazy validators on a background thread. The thread
+   * is stopped when this validator is destroyed.
+   */
+  void WarmUp(const std::vector<LazyValidator *> &lazy);
+
 private:
   json json_;
   std::vector<MessageValidator *> children_;
   MessageValidator *root_;
+  std::unique_ptr<FileWatcher> watcher_;
+  std::atomic<bool> stop_;
+  std::thread warmup_;
+};
+
+/**
+ * A validator whose secrets are read from watched files. The validator is
+ * rebuilt from its json description when one of the files changes, and
+ * swapped in atomically. In flight verifications finish on the old validator.
+ */
+class WatchedValidator : public MessageValidator {
+public:
+  typedef std::function<MessageValidator *()> Builder;
+
+  WatchedValidator(const json &json, Builder builder);
+
+  /**
+   * Rebuilds the validator. The current validator is kept if the new one
+   * cannot be constructed, for example when a key file is only partially
+   * written.
+   *
+   * @return true if the validator was replaced
+   */
+  bool Reload();
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
+              const uint8_t *signature, size_t num_signature) const;
+  std::string algorithm() const;
+  Algorithm algorithm_id() const;
+  bool Accepts(const json &jose) const;
+  std::string toJson() const;
+
+private:
+  json json_;
+  Builder builder_;
+  std::shared_ptr<MessageValidator> validator_;
+};
+
+/**
+ * A validator that keeps the json description of its key, and only parses
+ * the key on first use. A key is parsed once, even when the first
+ * verifications come in concurrently. A key that cannot be parsed is only
+ * tried once, after that Verify rejects every signature.
+ */
+class LazyValidator : public MessageValidator {
+public:
+  typedef std::function<MessageValidator *()> Builder;
+
+  LazyValidator(const json &json, Builder builder);
+
+  /**
+   * The materialized validator, or nullptr if the key cannot be parsed.
+   */
+  MessageValidator *Materialize() const;
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
+              const uint8_t *signature, size_t num_signature) const;
+  std::string algorithm() const;
+  Algorithm algorithm_id() const;
+  std::string toJson() const;
+
+private:
+  json json_;
+  Algorithm algorithm_id_;
+  Builder builder_;
+  mutable std::mutex lock_;
+  mutable bool failed_;
+  mutable std::atomic<MessageValidator *> materialized_;
+  mutable std::unique_ptr<MessageValidator> validator_;
+};
+
+/**
+ * The "lazy" and "warmup" declarations, they only exist so the validator can
+ * be serialized again.
+ */
+class LazyScope : public MessageValidator {
+public:
+  LazyScope(const std::string &property, MessageValidator *root);
+
+  bool Verify(const json &jsonHeader, const uint8_t *header, size_t num_header,
+              const uint8_t *signature, size_t num_signature) const;
+  std::string algorithm() const;
+  Algorithm algorithm_id() const;
+  bool Accepts(const json &jose) const;
+  std::string toJson() const;
+
+private:
+  std::string property_;
+  MessageValidator *root_;
 };
 #endif // SRC_INCLUDE_PRIVATE_BUILDWRAPPERS_H_
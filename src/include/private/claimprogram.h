@@ -0,0 +1,141 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_CLAIMPROGRAM_H_
+#define SRC_INCLUDE_PRIVATE_CLAIMPROGRAM_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "jwt/claimvalidator.h"
+
+/**
+ * A ClaimProgram is a ClaimValidator tree flattened into a contiguous array of
+ * instructions. Every claim the tree refers to, nested claims included, is
+ * looked up at most once into a slot, the first time an instruction needs it.
+ * The instructions hand the slots to the leaf validators and jump to a failure
+ * target when they are not accepted; a status is only built on failure.
+ * Validators the compiler does not know about are invoked through a call
+ * instruction.
+ */
+class ClaimProgram {
+public:
+  using json = nlohmann::json;
+
+  /**
+   * Compiles the given tree. The tree must outlive the program.
+   */
+  explicit ClaimProgram(const ClaimValidator *root);
+
+  /**
+   * Runs the program against the claimset.
+   *
+   * @param claimset The claims to validate
+   * @return the status of the last check that failed, or a valid status.
+   */
+  ClaimStatus Run(const json &claimset) const;
+
+  /**
+   * The number of instructions, used by the tests.
+   */
+  inline size_t size() const { return program_.size(); }
+
+  /**
+   * True if some claim is used by more than one instruction. Otherwise the
+   * program does the same lookups as the tree and is no faster.
+   */
+  bool SharesLookups() const;
+
+private:
+  enum Op : uint8_t {
+    kList,     // slot must be accepted by the ListClaimValidator leaves_[arg]
+    kAud,      // slot must be accepted by the AudValidator leaves_[arg]
+    kTime,     // slot must be accepted by the TimeValidator leaves_[arg]
+    kSkip,     // jump to target if slot is missing
+    kCall,     // calls_[arg] must accept the claimset
+    kJump,     // unconditional jump to target
+    kFail,     // all children of an any failed, jump to target
+    kAccept,
+    kReject
+  };
+
+  struct Instruction {
+    Op op;
+    uint32_t slot;
+    uint32_t arg;
+    uint32_t target;
+  };
+
+  void Emit(const ClaimValidator *node, uint32_t fail);
+  uint32_t Slot(const std::string &property);
+  uint32_t Label();
+  void Bind(uint32_t label);
+  void Add(Op op, uint32_t slot, uint32_t arg, uint32_t target);
+  const json *Load(const json **slots, uint32_t slot,
+                   const json &claimset) const;
+  ClaimStatus Failure(const Instruction &instruction, const json *value) const;
+
+  std::vector<Instruction> program_;
+  std::vector<std::string> slots_;
+  std::vector<ClaimPath> paths_;
+  std::vector<const ClaimValidator *> leaves_;
+  std::vector<const ClaimValidator *> calls_;
+  std::vector<uint32_t> labels_;
+};
+
+/**
+ * A ClaimValidator that owns a parsed tree and validates by running the
+ * ClaimProgram compiled from it.
+ */
+class CompiledClaimValidator : public ClaimValidator {
+public:
+  explicit CompiledClaimValidator(ClaimValidator *tree);
+
+  bool IsValid(const json &claimset) const;
+  ClaimStatus Check(const json &claimset) const;
+  std::string toJson() const;
+  inline Cost cost() const { return tree_->cost(); }
+  inline bool ListClaims(std::vector<std::string> *claims) const {
+    return tree_->ListClaims(claims);
+  }
+  inline const ClaimValidator *tree() const { return tree_.get(); }
+  inline const ClaimProgram &program() const { return program_; }
+  inline Composition Children(const ClaimValidator *const **children,
+                              size_t *num_children) const {
+    *children = &root_;
+    *num_children = 1;
+    return kWrapper;
+  }
+
+  /**
+   * Hands the tree to the caller, after which this validator is unusable.
+   */
+  inline ClaimValidator *Release() { return tree_.release(); }
+
+private:
+  std::unique_ptr<ClaimValidator> tree_;
+  // The tree, as the child of this validator.
+  const ClaimValidator *root_;
+  ClaimProgram program_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_CLAIMPROGRAM_H_
@@ -50,4 +50,22 @@ public:
 #endif
   }
 };
+
+/**
+ * A clock that reads the seconds since the epoch without any calendar
+ * conversion. Where available it uses CLOCK_REALTIME_COARSE, which is served
+ * from the cached kernel timestamp without a system call.
+ */
+class CoarseClock : public IClock {
+public:
+  uint64_t Now() {
+#ifdef CLOCK_REALTIME_COARSE
+    struct timespec now;
+    if (clock_gettime(CLOCK_REALTIME_COARSE, &now) == 0) {
+      return now.tv_sec;
+    }
+#endif
+    return time(nullptr);
+  }
+};
 #endif // SRC_INCLUDE_PRIVATE_CLOCK_H_
@@ -0,0 +1,109 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_FILEWATCHER_H_
+#define SRC_INCLUDE_PRIVATE_FILEWATCHER_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Watches a set of files and invokes a callback on a background thread when
+ * a file changes. Changes are detected from the device, inode, size and
+ * modification time of a file, the contents are never read.
+ *
+ * On linux inotify is used to watch the directories that contain the files,
+ * so files that are replaced by a rename or a symlink swap (as done for
+ * kubernetes secrets) are picked up as well. Only completed writes, a close
+ * after writing or a rename into place, are reported, so a callback never
+ * sees a partially written file. Files that cannot be watched are checked
+ * once every poll interval, and are reported once they did not change for a
+ * whole interval.
+ */
+class FileWatcher {
+public:
+  typedef std::function<void()> Callback;
+
+  explicit FileWatcher(int poll_interval_ms = 1000);
+  ~FileWatcher();
+
+  /**
+   * Invokes the callback when the given file changes. The callback is called
+   * on the watcher thread.
+   */
+  void Watch(const std::string &path, Callback callback);
+
+private:
+  FileWatcher(const FileWatcher &);
+  FileWatcher &operator=(const FileWatcher &);
+
+  struct Stamp {
+    bool exists;
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    uint64_t modified_ns;
+
+    bool operator==(const Stamp &other) const;
+    bool operator!=(const Stamp &other) const { return !(*this == other); }
+  };
+
+  struct Entry {
+    std::string path;
+    std::string name;
+    // The inotify watch of the directory, or -1 if the file is polled.
+    int watch;
+    Stamp seen;
+    Stamp pending;
+    Callback callback;
+  };
+
+  // A completed write reported by inotify.
+  struct Event {
+    int watch;
+    std::string name;
+    bool moved;
+  };
+
+  static Stamp Stat(const std::string &path);
+  static bool IsSymlink(const std::string &path);
+  void Run();
+  std::vector<Event> Wait();
+  void CheckAll(const std::vector<Event> &events);
+  bool Changed(Entry *entry, const std::vector<Event> &events);
+
+  std::vector<Entry> entries_;
+  int poll_interval_ms_;
+  bool stop_;
+  std::mutex lock_;
+  std::condition_variable wakeup_;
+  int inotify_fd_;
+  int wake_fd_[2];
+  std::thread thread_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_FILEWATCHER_H_
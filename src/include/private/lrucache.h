@@ -0,0 +1,138 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_LRUCACHE_H_
+#define SRC_INCLUDE_PRIVATE_LRUCACHE_H_
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * A thread safe, bounded cache that evicts the least recently used entry.
+ * Values are handed out as shared pointers, so an evicted value stays alive
+ * for as long as a caller is still using it.
+ *
+ * Larger caches are split in up to 16 shards by key hash, each with its own
+ * lock and recency order, so lookups of different keys on different threads
+ * rarely wait for each other. Eviction is least recently used per shard.
+ */
+template <typename K, typename V>
+class LruCache {
+public:
+  typedef std::shared_ptr<V> value_ptr;
+
+  explicit LruCache(size_t capacity) : capacity_(capacity ? capacity : 1) {
+    // Small caches are not split, so they keep an exact recency order.
+    const size_t max_shards = 16;
+    const size_t min_shard_size = 8;
+    size_t num_shards = std::min(
+        max_shards, std::max<size_t>(1, capacity_ / min_shard_size));
+    for (size_t i = 0; i < num_shards; i++) {
+      shards_.emplace_back(new Shard(capacity_ / num_shards +
+                                     (i < capacity_ % num_shards ? 1 : 0)));
+    }
+  }
+
+  /**
+   * The cached value, or null if there is no value for the given key.
+   */
+  value_ptr Get(const K &key) { return ShardOf(key)->Get(key); }
+
+  /**
+   * Adds the value to the cache, evicting the least recently used value of
+   * its shard if the shard is full. An existing value is kept and returned,
+   * so concurrent callers end up sharing the same value.
+   */
+  value_ptr Put(const K &key, value_ptr value) {
+    return ShardOf(key)->Put(key, value);
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (const auto &shard : shards_) {
+      size += shard->size();
+    }
+    return size;
+  }
+
+  size_t capacity() const { return capacity_; }
+
+private:
+  class Shard {
+  public:
+    explicit Shard(size_t capacity) : capacity_(capacity) {}
+
+    value_ptr Get(const K &key) {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto found = index_.find(key);
+      if (found == index_.end()) {
+        return value_ptr();
+      }
+      entries_.splice(entries_.begin(), entries_, found->second);
+      return found->second->second;
+    }
+
+    value_ptr Put(const K &key, value_ptr value) {
+      std::lock_guard<std::mutex> lock(lock_);
+      auto found = index_.find(key);
+      if (found != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, found->second);
+        return found->second->second;
+      }
+
+      entries_.push_front(std::make_pair(key, value));
+      index_[key] = entries_.begin();
+      if (entries_.size() > capacity_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+      }
+      return value;
+    }
+
+    size_t size() const {
+      std::lock_guard<std::mutex> lock(lock_);
+      return entries_.size();
+    }
+
+  private:
+    typedef std::list<std::pair<K, value_ptr>> List;
+
+    size_t capacity_;
+    List entries_;
+    std::unordered_map<K, typename List::iterator> index_;
+    mutable std::mutex lock_;
+  };
+
+  Shard *ShardOf(const K &key) {
+    return shards_[std::hash<K>()(key) % shards_.size()].get();
+  }
+
+  size_t capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+#endif // SRC_INCLUDE_PRIVATE_LRUCACHE_H_
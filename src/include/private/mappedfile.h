@@ -0,0 +1,77 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_MAPPEDFILE_H_
+#define SRC_INCLUDE_PRIVATE_MAPPEDFILE_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * A read only view of a file. The file is memory mapped where the platform
+ * supports it, and read into memory otherwise.
+ */
+class MappedFile {
+public:
+  /**
+   * Maps the given file.
+   *
+   * @throw std::logic_error if the file cannot be opened or is empty
+   */
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  MappedFile(const MappedFile &);
+  MappedFile &operator=(const MappedFile &);
+
+  const uint8_t *data_;
+  size_t size_;
+  std::string buffer_;
+};
+
+/**
+ * Little endian helpers for the binary file formats.
+ */
+inline uint32_t ReadU32(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+inline uint64_t ReadU64(const uint8_t *data) {
+  return ReadU32(data) | (static_cast<uint64_t>(ReadU32(data + 4)) << 32);
+}
+
+inline void WriteU32(std::string *out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+inline void WriteU64(std::string *out, uint64_t value) {
+  WriteU32(out, static_cast<uint32_t>(value));
+  WriteU32(out, static_cast<uint32_t>(value >> 32));
+}
+#endif // SRC_INCLUDE_PRIVATE_MAPPEDFILE_H_
@@ -0,0 +1,100 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_MEMBERSAX_H_
+#define SRC_INCLUDE_PRIVATE_MEMBERSAX_H_
+
+#include "jwt/decodelimits.h"
+#include "jwt/json.hpp"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * A SAX handler that builds json for the members of the root object that a
+ * subclass wants, one member at a time, and skips all others. A root that is
+ * not an object is built as a whole. The depth and member limits apply to the
+ * whole document.
+ */
+class MemberSax : public nlohmann::json_sax<nlohmann::json> {
+public:
+  using json = nlohmann::json;
+
+  explicit MemberSax(const DecodeLimits *limits);
+
+  /**
+   * Parses the json, calling Member for every wanted member.
+   *
+   * @throw TokenFormatError if the json is invalid or exceeds the limits
+   */
+  void Parse(const char *str, size_t num_str);
+
+  bool null();
+  bool boolean(bool val);
+  bool number_integer(number_integer_t val);
+  bool number_unsigned(number_unsigned_t val);
+  bool number_float(number_float_t val, const string_t &);
+  bool string(string_t &val);
+  bool start_object(std::size_t);
+  bool start_array(std::size_t);
+  bool end_object();
+  bool end_array();
+  bool key(string_t &val);
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex);
+
+protected:
+  /**
+   * True if the member of the root object should be built.
+   */
+  virtual bool Wants(const std::string &key) = 0;
+
+  /**
+   * Receives a wanted member of the root object once it is complete.
+   */
+  virtual void Member(const std::string &key, json &&value) = 0;
+
+  /**
+   * Receives the root if it is not an object.
+   */
+  virtual void Root(json &&value) = 0;
+
+private:
+  json *Slot();
+  bool Value(json &&value);
+  bool Start(json &&container);
+  bool End();
+  void Complete();
+  void Count();
+
+  const DecodeLimits *limits_;
+  std::string key_;
+  json value_;
+  json *target_;
+  std::vector<json *> stack_;
+  size_t depth_;
+  size_t members_;
+  bool root_object_;
+  bool capturing_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_MEMBERSAX_H_
@@ -0,0 +1,125 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_PAYLOADDECODER_H_
+#define SRC_INCLUDE_PRIVATE_PAYLOADDECODER_H_
+
+#include "jwt/claimprojection.h"
+#include "jwt/claimvalidator.h"
+#include "jwt/decodelimits.h"
+#include "jwt/json.hpp"
+#include "jwt/precheck.h"
+#include "jwt/registeredclaims.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * Turns the decoded payload of a token into what JWT::Decode returns, and
+ * checks the claims on that.
+ */
+class PayloadDecoder {
+public:
+  using json = nlohmann::json;
+  virtual ~PayloadDecoder() {}
+
+  /**
+   * Parses the \0 terminated payload.
+   *
+   * @throw TokenFormatError if the payload cannot be parsed
+   */
+  virtual void Parse(const char *str, size_t num_str,
+                     const DecodeLimits *limits) = 0;
+
+  /**
+   * @throw InvalidClaimError if the precheck rejects the payload
+   */
+  virtual void CheckUnverified(const Precheck &precheck) const = 0;
+
+  /**
+   * @throw InvalidClaimError if the validator rejects the payload
+   */
+  virtual void Validate(ClaimValidator *validator) const = 0;
+};
+
+/**
+ * Decodes the payload as json, optionally projected.
+ */
+class JsonPayloadDecoder : public PayloadDecoder {
+public:
+  explicit JsonPayloadDecoder(const ClaimProjection *projection)
+      : projection_(projection) {}
+
+  void Parse(const char *str, size_t num_str, const DecodeLimits *limits);
+  void CheckUnverified(const Precheck &precheck) const;
+  void Validate(ClaimValidator *validator) const;
+
+  inline json &payload() { return payload_; }
+
+private:
+  const ClaimProjection *projection_;
+  json payload_;
+};
+
+/**
+ * Decodes the payload into RegisteredClaims and the fields of a type. The
+ * built in time, iss, sub and aud validators check the typed claims, all
+ * other validators check json that only holds the claims they read.
+ */
+class TypedPayloadDecoder : public PayloadDecoder {
+public:
+  /**
+   * @param object The object the fields belong to, claims is its base.
+   * @param validator The claim validator, may be null.
+   * @param precheck The precheck, may be null.
+   */
+  TypedPayloadDecoder(const ClaimFieldsBase &fields, RegisteredClaims *claims,
+                      void *object, const ClaimValidator *validator,
+                      const Precheck *precheck);
+
+  void Parse(const char *str, size_t num_str, const DecodeLimits *limits);
+  void CheckUnverified(const Precheck &precheck) const;
+  void Validate(ClaimValidator *validator) const;
+
+  /**
+   * The claims that are kept as json.
+   */
+  inline const json &untyped() const { return untyped_; }
+
+private:
+  class Reader;
+
+  void Select(const ClaimValidator *validator);
+  ClaimStatus Check(const ClaimValidator *validator) const;
+  ClaimStatus CheckTyped(const ClaimValidator *validator,
+                         RegisteredClaims::Claim claim) const;
+  bool KeepsUntyped(const std::string &claim) const;
+
+  const ClaimFieldsBase &fields_;
+  RegisteredClaims *claims_;
+  void *object_;
+  std::vector<std::string> untyped_claims_;
+  bool keeps_all_;
+  json untyped_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_PAYLOADDECODER_H_
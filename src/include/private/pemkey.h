@@ -0,0 +1,56 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_PEMKEY_H_
+#define SRC_INCLUDE_PRIVATE_PEMKEY_H_
+
+#include <openssl/evp.h>
+#include <string>
+
+/**
+ * Helpers shared by the validators that are backed by an openssl EVP_PKEY.
+ */
+class PemKey {
+public:
+  /**
+   * Reads a PEM encoded key.
+   *
+   * @param key The PEM block, an empty or null key results in a null key
+   * @param public_key True if this is a public key, false for a private key
+   * @return The key, to be released with EVP_PKEY_free
+   * @throw InvalidValidatorError if the PEM block cannot be parsed
+   */
+  static EVP_PKEY *Load(const char *key, bool public_key);
+
+  /**
+   * Writes the key as a PEM block.
+   */
+  static std::string Write(EVP_PKEY *key, bool public_key);
+
+  /**
+   * Creates the json representation used by the MessageValidatorFactory:
+   * { "alg" : { "public" : "PEM", "private" : "PEM" } }
+   */
+  static std::string ToJson(const std::string &algorithm, EVP_PKEY *public_key,
+                            EVP_PKEY *private_key);
+};
+#endif // SRC_INCLUDE_PRIVATE_PEMKEY_H_
@@ -1,10 +1,46 @@
+#ifndef SRC_INCLUDE_PRIVATE_SSL_COMPAT_H_
+#define SRC_INCLUDE_PRIVATE_SSL_COMPAT_H_
 #include <openssl/opensslv.h>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
 #include <openssl/err.h>
 #include <openssl/pem.h>
 #include <openssl/hmac.h>
+#include <openssl/rsa.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+#endif
 
 #if OPENSSL_VERSION_NUMBER < 0x10100000L
 // ssl < 1.1
+inline int EVP_PKEY_up_ref(EVP_PKEY *pkey) {
+  CRYPTO_add(&pkey->references, 1, CRYPTO_LOCK_EVP_PKEY);
+  return 1;
+}
+
+inline int RSA_set0_key(RSA *rsa, BIGNUM *n, BIGNUM *e, BIGNUM *d) {
+  rsa->n = n;
+  rsa->e = e;
+  rsa->d = d;
+  return 1;
+}
+
+inline int ECDSA_SIG_set0(ECDSA_SIG *sig, BIGNUM *r, BIGNUM *s) {
+  BN_free(sig->r);
+  BN_free(sig->s);
+  sig->r = r;
+  sig->s = s;
+  return 1;
+}
+
+inline void ECDSA_SIG_get0(const ECDSA_SIG *sig, const BIGNUM **r,
+                           const BIGNUM **s) {
+  *r = sig->r;
+  *s = sig->s;
+}
+
 class EvpMdCtx {
  public:
   EvpMdCtx() { EVP_MD_CTX_init(&ctx_); }
@@ -54,4 +90,94 @@ class HMacCtx {
 };
 #endif
 
-
+// Builds an RSA public key from its modulus and exponent, which are not
+// consumed. Returns NULL on failure.
+inline EVP_PKEY *NewRsaPublicKey(const BIGNUM *n, const BIGNUM *e) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_PKEY *pkey = NULL;
+  OSSL_PARAM *params = NULL;
+  OSSL_PARAM_BLD *bld = OSSL_PARAM_BLD_new();
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(NULL, "RSA", NULL);
+  if (bld != NULL && ctx != NULL &&
+      OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_N, n) == 1 &&
+      OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_E, e) == 1 &&
+      (params = OSSL_PARAM_BLD_to_param(bld)) != NULL &&
+      EVP_PKEY_fromdata_init(ctx) == 1) {
+    EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params);
+  }
+  OSSL_PARAM_free(params);
+  OSSL_PARAM_BLD_free(bld);
+  EVP_PKEY_CTX_free(ctx);
+  return pkey;
+#else
+  RSA *rsa = RSA_new();
+  BIGNUM *rsa_n = BN_dup(n);
+  BIGNUM *rsa_e = BN_dup(e);
+  if (rsa == NULL || rsa_n == NULL || rsa_e == NULL ||
+      RSA_set0_key(rsa, rsa_n, rsa_e, NULL) != 1) {
+    BN_free(rsa_n);
+    BN_free(rsa_e);
+    RSA_free(rsa);
+    return NULL;
+  }
+  EVP_PKEY *pkey = EVP_PKEY_new();
+  if (pkey == NULL || EVP_PKEY_assign_RSA(pkey, rsa) != 1) {
+    EVP_PKEY_free(pkey);
+    RSA_free(rsa);
+    return NULL;
+  }
+  return pkey;
+#endif
+}
+
+// Builds an EC public key on the named curve from its affine coordinates,
+// which are not consumed. Returns NULL if the point is not on the curve.
+inline EVP_PKEY *NewEcPublicKey(int nid, const BIGNUM *x, const BIGNUM *y) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  EVP_PKEY *pkey = NULL;
+  unsigned char *point_data = NULL;
+  size_t num_point_data = 0;
+  OSSL_PARAM *params = NULL;
+  EC_GROUP *group = EC_GROUP_new_by_curve_name(nid);
+  EC_POINT *point = group != NULL ? EC_POINT_new(group) : NULL;
+  OSSL_PARAM_BLD *bld = OSSL_PARAM_BLD_new();
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(NULL, "EC", NULL);
+  if (point != NULL && bld != NULL && ctx != NULL &&
+      EC_POINT_set_affine_coordinates(group, point, x, y, NULL) == 1 &&
+      EC_POINT_is_on_curve(group, point, NULL) == 1 &&
+      (num_point_data = EC_POINT_point2buf(group, point,
+                                           POINT_CONVERSION_UNCOMPRESSED,
+                                           &point_data, NULL)) != 0 &&
+      OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME,
+                                      OBJ_nid2sn(nid), 0) == 1 &&
+      OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY,
+                                       point_data, num_point_data) == 1 &&
+      (params = OSSL_PARAM_BLD_to_param(bld)) != NULL &&
+      EVP_PKEY_fromdata_init(ctx) == 1) {
+    EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params);
+  }
+  OSSL_PARAM_free(params);
+  OSSL_PARAM_BLD_free(bld);
+  EVP_PKEY_CTX_free(ctx);
+  OPENSSL_free(point_data);
+  EC_POINT_free(point);
+  EC_GROUP_free(group);
+  return pkey;
+#else
+  EC_KEY *ec = EC_KEY_new_by_curve_name(nid);
+  if (ec == NULL ||
+      EC_KEY_set_public_key_affine_coordinates(ec, const_cast<BIGNUM *>(x),
+                                               const_cast<BIGNUM *>(y)) != 1) {
+    EC_KEY_free(ec);
+    return NULL;
+  }
+  EVP_PKEY *pkey = EVP_PKEY_new();
+  if (pkey == NULL || EVP_PKEY_assign_EC_KEY(pkey, ec) != 1) {
+    EVP_PKEY_free(pkey);
+    EC_KEY_free(ec);
+    return NULL;
+  }
+  return pkey;
+#endif
+}
+#endif  // SRC_INCLUDE_PRIVATE_SSL_COMPAT_H_
@@ -0,0 +1,69 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_STRINGSET_H_
+#define SRC_INCLUDE_PRIVATE_STRINGSET_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * An immutable set of strings, built once and then only queried. The strings
+ * are stored in an open addressing table that is kept at most half full, so
+ * a lookup hashes the candidate once and usually compares a single entry.
+ * Lookups never allocate.
+ */
+class StringSet {
+public:
+  explicit StringSet(const std::vector<std::string> &values);
+
+  /**
+   * The position of the string among the distinct values, in the order they
+   * were given, or -1 if the set does not contain the string.
+   */
+  int64_t Find(const char *str, size_t len) const;
+  inline int64_t Find(const std::string &str) const {
+    return Find(str.data(), str.size());
+  }
+
+  inline bool Contains(const char *str, size_t len) const {
+    return Find(str, len) >= 0;
+  }
+  inline bool Contains(const std::string &str) const {
+    return Find(str.data(), str.size()) >= 0;
+  }
+
+  inline size_t size() const { return values_.size(); }
+
+private:
+  struct Slot {
+    uint32_t hash;
+    uint32_t index;  // index + 1 in values_, 0 if the slot is empty
+  };
+
+  std::vector<std::string> values_;
+  std::vector<Slot> slots_;
+  uint64_t mask_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_STRINGSET_H_
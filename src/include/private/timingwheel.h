@@ -0,0 +1,159 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#ifndef SRC_INCLUDE_PRIVATE_TIMINGWHEEL_H_
+#define SRC_INCLUDE_PRIVATE_TIMINGWHEEL_H_
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+/**
+ * A hierarchical timing wheel with a resolution of one second. Every level
+ * has 64 slots, a slot on level n covers 64^n seconds, so four levels cover
+ * about 194 days. Expiries further out are kept aside, and placed on the wheel
+ * once they come within the horizon.
+ *
+ * Adding a value is O(1). Advancing the wheel costs O(1) per elapsed second
+ * plus the values that expire or move down a level, and every 64^3 seconds
+ * the values kept aside are revisited. The wheel is not thread safe.
+ */
+template <typename V>
+class TimingWheel {
+public:
+  static const int kBits = 6;
+  static const int kLevels = 4;
+  static const uint64_t kSlots = 1 << kBits;
+  static const uint64_t kHorizon = 1ULL << (kBits * kLevels);
+
+  explicit TimingWheel(uint64_t now) : now_(now), size_(0) {}
+
+  /**
+   * Schedules the value to expire at the given time. Returns false, and does
+   * not schedule the value, if that time is not in the future.
+   */
+  bool Add(V value, uint64_t expiry) {
+    if (expiry <= now_) {
+      return false;
+    }
+    Schedule(Entry(value, expiry));
+    size_++;
+    return true;
+  }
+
+  /**
+   * Advances the wheel to now, invoking expired(value) for every value whose
+   * expiry is at or before now.
+   */
+  template <typename F>
+  void Advance(uint64_t now, F expired) {
+    if (now <= now_) {
+      return;
+    }
+    if (size_ == 0 || now - now_ >= kHorizon) {
+      for (auto &level : levels_) {
+        for (auto &slot : level) {
+          for (auto &entry : slot) {
+            expired(entry.first);
+          }
+          slot.clear();
+        }
+      }
+      now_ = now;
+      size_ = 0;
+      std::vector<Entry> far;
+      far.swap(far_);
+      for (auto &entry : far) {
+        if (entry.second <= now_) {
+          expired(entry.first);
+        } else {
+          Schedule(entry);
+          size_++;
+        }
+      }
+      return;
+    }
+
+    while (now_ < now) {
+      now_++;
+      // Move the values of the slots that start at this second down a level.
+      for (int level = 1; level < kLevels; level++) {
+        if ((now_ & ((1ULL << (kBits * level)) - 1)) != 0) {
+          break;
+        }
+        std::vector<Entry> &slot =
+            levels_[level][(now_ >> (kBits * level)) & (kSlots - 1)];
+        std::vector<Entry> cascade;
+        cascade.swap(slot);
+        for (auto &entry : cascade) {
+          Place(entry);
+        }
+      }
+      if (!far_.empty() && (now_ & (kHorizon / kSlots - 1)) == 0) {
+        std::vector<Entry> far;
+        far.swap(far_);
+        for (auto &entry : far) {
+          Schedule(entry);
+        }
+      }
+
+      std::vector<Entry> &slot = levels_[0][now_ & (kSlots - 1)];
+      for (auto &entry : slot) {
+        expired(entry.first);
+      }
+      size_ -= slot.size();
+      slot.clear();
+    }
+  }
+
+  inline size_t size() const { return size_; }
+  inline uint64_t now() const { return now_; }
+
+private:
+  typedef std::pair<V, uint64_t> Entry;
+
+  void Schedule(const Entry &entry) {
+    if (entry.second - now_ >= kHorizon) {
+      far_.push_back(entry);
+    } else {
+      Place(entry);
+    }
+  }
+
+  void Place(const Entry &entry) {
+    uint64_t delta = entry.second - now_;
+    int level = 0;
+    while (level < kLevels - 1 && delta >= (1ULL << (kBits * (level + 1)))) {
+      level++;
+    }
+    levels_[level][(entry.second >> (kBits * level)) & (kSlots - 1)].push_back(
+        entry);
+  }
+
+  uint64_t now_;
+  size_t size_;
+  std::vector<Entry> levels_[kLevels][kSlots];
+  // Values that expire beyond the horizon.
+  std::vector<Entry> far_;
+};
+
+#endif // SRC_INCLUDE_PRIVATE_TIMINGWHEEL_H_
@@ -0,0 +1,550 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/bundle.h"
+#include <openssl/x509.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "jwt/claimvalidatorfactory.h"
+#include "jwt/ecdsavalidator.h"
+#include "jwt/eddsavalidator.h"
+#include "jwt/hmacvalidator.h"
+#include "jwt/kidvalidator.h"
+#include "jwt/listclaimvalidator.h"
+#include "jwt/messagevalidatorfactory.h"
+#include "jwt/multikeyvalidator.h"
+#include "jwt/nonevalidator.h"
+#include "jwt/rsavalidator.h"
+#include "jwt/setvalidator.h"
+#include "jwt/timevalidator.h"
+#include "private/buildwrappers.h"
+#include "private/mappedfile.h"
+#include "private/pemkey.h"
+
+using json = nlohmann::json;
+
+// Version 2 added kMulti, kCoarseTime, kClaimList and the adaptive flag of
+// kAll and kAny.
+const uint32_t Bundle::kVersion = 2;
+
+namespace {
+
+const char kMagic[] = {'J', 'W', 'T', 'B'};
+
+// Validators are read recursively, so a crafted bundle could exhaust the stack.
+const uint32_t kMaxDepth = 64;
+
+// Every node is stored as three integers: op, a and b.
+enum Op {
+    // Validators
+    kNone = 1,      // none
+    kSecret = 2,    // a: algorithm, b: secret
+    kPublicKey = 3, // a: algorithm, b: DER encoded public key
+    kSet = 4,       // a: number of children
+    kKid = 5,       // a: number of kKidEntry children
+    kKidEntry = 6,  // a: kid, followed by its validator
+    kMulti = 7,     // a: number of children
+    // Claims
+    kNoClaims = 16, // No claim validator
+    kList = 17,     // a: claim, b: number of kString children
+    kString = 18,   // a: string
+    kTime = 19,     // a: claim, b: leeway
+    kAll = 20,      // a: number of children, b: 1 if adaptive
+    kAny = 21,      // a: number of children, b: 1 if adaptive
+    kOptional = 22, // followed by the optional validator
+    kCoarseTime = 23, // a: claim, b: leeway, read from the coarse clock
+    kClaimList = 24,  // a: claim path, b: number of kString children
+};
+
+bool IsHmac(const std::string &alg) {
+    return alg == "HS256" || alg == "HS384" || alg == "HS512";
+}
+
+bool IsPublicKey(const std::string &alg) {
+    return alg == "RS256" || alg == "RS384" || alg == "RS512" ||
+           alg == "ES256" || alg == "ES384" || alg == "ES512" ||
+           alg == "EdDSA";
+}
+
+const json &Single(const json &j) {
+    if (!j.is_object() || j.size() != 1) {
+        throw std::logic_error("Expected a single property at: " + j.dump());
+    }
+    return j.begin().value();
+}
+
+class BundleWriter {
+public:
+    uint32_t Intern(const std::string &str) {
+        auto found = index_.find(str);
+        if (found != index_.end()) {
+            return found->second;
+        }
+        uint32_t idx = static_cast<uint32_t>(strings_.size());
+        strings_.push_back(str);
+        index_[str] = idx;
+        return idx;
+    }
+
+    void Node(uint32_t op, uint32_t a, uint32_t b) {
+        WriteU32(&nodes_, op);
+        WriteU32(&nodes_, a);
+        WriteU32(&nodes_, b);
+    }
+
+    void Validator(const json &j, const std::string &secret) {
+        const json &value = Single(j);
+        const std::string &alg = j.begin().key();
+        // Intern in a fixed order, so bundles are reproducible.
+        if (alg == "none") {
+            Node(kNone, 0, 0);
+        } else if (IsHmac(alg)) {
+            uint32_t algorithm = Intern(alg);
+            Node(kSecret, algorithm, Intern(secret));
+        } else if (IsPublicKey(alg)) {
+            uint32_t algorithm = Intern(alg);
+            Node(kPublicKey, algorithm, Intern(ToDer(secret)));
+        } else {
+            std::ostringstream msg;
+            msg << "Cannot bundle validator at: " << value;
+            throw std::logic_error(msg.str());
+        }
+    }
+
+    void Claim(const json &j, bool adaptive = false) {
+        const json &value = Single(j);
+        const std::string &claim = j.begin().key();
+        if (claim == "iss" || claim == "sub" || claim == "aud") {
+            Node(kList, Intern(claim), static_cast<uint32_t>(value.size()));
+            for (auto &str : value) {
+                Node(kString, Intern(str.get<std::string>()), 0);
+            }
+        } else if (claim == "claim") {
+            const json &accepted = value.at("accepted");
+            Node(kClaimList, Intern(value.at("path").get<std::string>()),
+                 static_cast<uint32_t>(accepted.size()));
+            for (auto &str : accepted) {
+                Node(kString, Intern(str.get<std::string>()), 0);
+            }
+        } else if (claim == "exp" || claim == "nbf" || claim == "iat") {
+            auto leeway = value.find("leeway");
+            auto clock = value.find("clock");
+            bool coarse = clock != value.end() && *clock == "coarse";
+            Node(coarse ? kCoarseTime : kTime, Intern(claim),
+                 leeway == value.end() || leeway->is_null()
+                     ? 0
+                     : leeway->get<uint32_t>());
+        } else if (claim == "all" || claim == "any") {
+            Node(claim == "all" ? kAll : kAny,
+                 static_cast<uint32_t>(value.size()), adaptive ? 1 : 0);
+            for (auto &child : value) {
+                Claim(child);
+            }
+        } else if (claim == "adaptive" && !adaptive &&
+                   (value.count("all") || value.count("any"))) {
+            Claim(value, true);
+        } else if (claim == "optional") {
+            Node(kOptional, 0, 0);
+            Claim(value);
+        } else {
+            throw std::logic_error("Cannot bundle claim at: " + j.dump());
+        }
+    }
+
+    std::string Finish() const {
+        std::string bundle(kMagic, sizeof(kMagic));
+        WriteU32(&bundle, Bundle::kVersion);
+        WriteU32(&bundle, static_cast<uint32_t>(strings_.size()));
+        for (auto &str : strings_) {
+            WriteU32(&bundle, static_cast<uint32_t>(str.size()));
+            bundle += str;
+        }
+        return bundle + nodes_;
+    }
+
+private:
+    static std::string ToDer(const std::string &pem) {
+        EVP_PKEY *key = PemKey::Load(pem.c_str(), true);
+        int len = i2d_PUBKEY(key, nullptr);
+        std::string der(len > 0 ? len : 0, '\0');
+        unsigned char *out = reinterpret_cast<unsigned char *>(&der[0]);
+        if (len <= 0 || i2d_PUBKEY(key, &out) != len) {
+            EVP_PKEY_free(key);
+            throw std::logic_error("Unable to encode public key");
+        }
+        EVP_PKEY_free(key);
+        return der;
+    }
+
+    std::vector<std::string> strings_;
+    std::unordered_map<std::string, uint32_t> index_;
+    std::string nodes_;
+};
+
+class BundleReader {
+public:
+    BundleReader(const uint8_t *data, size_t size)
+        : data_(data), end_(data + size), depth_(0) {}
+
+    void Header() {
+        if (Remaining() < sizeof(kMagic) ||
+            memcmp(data_, kMagic, sizeof(kMagic)) != 0) {
+            throw std::logic_error("Not a validator bundle");
+        }
+        data_ += sizeof(kMagic);
+        uint32_t version = U32();
+        if (version != Bundle::kVersion) {
+            std::ostringstream msg;
+            msg << "Unsupported bundle version: " << version;
+            throw std::logic_error(msg.str());
+        }
+        uint32_t count = U32();
+        strings_.reserve(std::min<size_t>(count, Remaining() / 4));
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t len = U32();
+            if (Remaining() < len) {
+                throw std::logic_error("Truncated bundle");
+            }
+            strings_.push_back(std::make_pair(data_, len));
+            data_ += len;
+        }
+    }
+
+    MessageValidator *Validator(std::vector<MessageValidator *> *build) {
+        Nested nested(&depth_);
+        uint32_t op = U32(), a = U32(), b = U32();
+        MessageValidator *constructed = nullptr;
+        switch (op) {
+            case kNone:
+                constructed = new NoneValidator();
+                break;
+            case kSecret:
+                constructed = Hmac(String(a), String(b));
+                break;
+            case kPublicKey:
+                constructed = PublicKey(String(a), Bytes(b));
+                break;
+            case kSet:
+            case kMulti: {
+                std::vector<MessageValidator *> children;
+                for (uint32_t i = 0; i < a; i++) {
+                    children.push_back(Validator(build));
+                }
+                if (op == kSet) {
+                    constructed = new SetValidator(children);
+                } else {
+                    constructed = new MultiKeyValidator(children);
+                }
+                break;
+            }
+            case kKid: {
+                KidValidator::KidMap validators;
+                for (uint32_t i = 0; i < a; i++) {
+                    Expect(kKidEntry);
+                    std::string kid = String(U32());
+                    U32();
+                    std::shared_ptr<MessageValidator> validator(
+                        Validator(build), [](MessageValidator *) {});
+                    validators[kid] = validator;
+                }
+                constructed = new KidValidator(validators);
+                break;
+            }
+        }
+
+        if (constructed == nullptr) {
+            throw std::logic_error("Invalid validator in bundle");
+        }
+        build->push_back(constructed);
+        return constructed;
+    }
+
+    ClaimValidator *Claim(std::vector<ClaimValidator *> *build) {
+        Nested nested(&depth_);
+        uint32_t op = U32(), a = U32(), b = U32();
+        ClaimValidator *constructed = nullptr;
+        switch (op) {
+            case kNoClaims:
+                return nullptr;
+            case kList:
+            case kClaimList: {
+                std::string claim = String(a);
+                std::vector<std::string> accepted;
+                for (uint32_t i = 0; i < b; i++) {
+                    Expect(kString);
+                    accepted.push_back(String(U32()));
+                    U32();
+                }
+                if (op == kClaimList) {
+                    constructed = new ListClaimValidator(claim, accepted);
+                } else if (claim == "iss") {
+                    constructed = new IssValidator(accepted);
+                } else if (claim == "sub") {
+                    constructed = new SubValidator(accepted);
+                } else if (claim == "aud") {
+                    constructed = new AudValidator(accepted);
+                } else {
+                    constructed = new ListClaimValidator(claim, accepted);
+                }
+                break;
+            }
+            case kTime:
+            case kCoarseTime: {
+                std::string claim = String(a);
+                IClock *clock = op == kCoarseTime
+                                    ? TimeValidator::coarse_clock()
+                                    : TimeValidator::utc_clock();
+                if (claim == "exp") {
+                    constructed = new ExpValidator(b, clock);
+                } else if (claim == "nbf") {
+                    constructed = new NbfValidator(b, clock);
+                } else if (claim == "iat") {
+                    constructed = new IatValidator(b, clock);
+                }
+                break;
+            }
+            case kAll:
+            case kAny: {
+                if (b > 1) {
+                    throw std::logic_error("Invalid claim in bundle");
+                }
+                std::vector<ClaimValidator *> children;
+                for (uint32_t i = 0; i < a; i++) {
+                    ClaimValidator *child = Claim(build);
+                    if (child == nullptr) {
+                        throw std::logic_error("Invalid claim in bundle");
+                    }
+                    children.push_back(child);
+                }
+                if (op == kAll) {
+                    constructed = new AllClaimValidator(children, b != 0);
+                } else {
+                    constructed = new AnyClaimValidator(children, b != 0);
+                }
+                break;
+            }
+            case kOptional: {
+                ClaimValidator *inner = Claim(build);
+                if (inner != nullptr) {
+                    constructed = new OptionalClaimValidator(inner);
+                }
+                break;
+            }
+        }
+
+        if (constructed == nullptr) {
+            throw std::logic_error("Invalid claim in bundle");
+        }
+        build->push_back(constructed);
+        return constructed;
+    }
+
+    size_t Remaining() const { return end_ - data_; }
+
+private:
+    // Counts the nodes that are being read, from the root down.
+    class Nested {
+    public:
+        explicit Nested(uint32_t *depth) : depth_(depth) {
+            if (++*depth_ > kMaxDepth) {
+                throw std::logic_error("Bundle is nested too deeply");
+            }
+        }
+        ~Nested() { --*depth_; }
+
+    private:
+        uint32_t *depth_;
+    };
+
+    uint32_t U32() {
+        if (Remaining() < 4) {
+            throw std::logic_error("Truncated bundle");
+        }
+        uint32_t value = ReadU32(data_);
+        data_ += 4;
+        return value;
+    }
+
+    void Expect(uint32_t op) {
+        if (U32() != op) {
+            throw std::logic_error("Invalid node in bundle");
+        }
+    }
+
+    const std::pair<const uint8_t *, uint32_t> &Bytes(uint32_t idx) const {
+        if (idx >= strings_.size()) {
+            throw std::logic_error("Invalid string in bundle");
+        }
+        return strings_[idx];
+    }
+
+    std::string String(uint32_t idx) const {
+        auto &bytes = Bytes(idx);
+        return std::string(reinterpret_cast<const char *>(bytes.first),
+                           bytes.second);
+    }
+
+    static MessageValidator *Hmac(const std::string &alg,
+                                  const std::string &secret) {
+        if (alg == "HS256") {
+            return new HS256Validator(secret);
+        } else if (alg == "HS384") {
+            return new HS384Validator(secret);
+        } else if (alg == "HS512") {
+            return new HS512Validator(secret);
+        }
+        return nullptr;
+    }
+
+    static MessageValidator *PublicKey(
+        const std::string &alg, const std::pair<const uint8_t *, uint32_t> &der) {
+        const unsigned char *in = der.first;
+        EVP_PKEY *key = d2i_PUBKEY(nullptr, &in, der.second);
+        if (key == nullptr) {
+            throw std::logic_error("Invalid public key in bundle");
+        }
+
+        std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> owned(
+            key, EVP_PKEY_free);
+        if (alg == "RS256") {
+            return new RS256Validator(key);
+        } else if (alg == "RS384") {
+            return new RS384Validator(key);
+        } else if (alg == "RS512") {
+            return new RS512Validator(key);
+        } else if (alg == "ES256") {
+            return new ES256Validator(key);
+        } else if (alg == "ES384") {
+            return new ES384Validator(key);
+        } else if (alg == "ES512") {
+            return new ES512Validator(key);
+        } else if (alg == "EdDSA") {
+            return new EdDSAValidator(key);
+        }
+        return nullptr;
+    }
+
+    const uint8_t *data_;
+    const uint8_t *end_;
+    uint32_t depth_;
+    std::vector<std::pair<const uint8_t *, uint32_t>> strings_;
+};
+
+}  // namespace
+
+// Resolves the secrets through the factory, so fromfile is handled the same
+// way as when building from json.
+class BundleCompiler {
+public:
+    static void Validator(BundleWriter *writer, const json &j) {
+        const json &value = Single(j);
+        const std::string &alg = j.begin().key();
+        if (alg == "set" || alg == "multi") {
+            writer->Node(alg == "set" ? kSet : kMulti,
+                         static_cast<uint32_t>(value.size()), 0);
+            for (auto &child : value) {
+                Validator(writer, child);
+            }
+        } else if (alg == "kid") {
+            writer->Node(kKid, static_cast<uint32_t>(value.size()), 0);
+            for (auto it = value.begin(); it != value.end(); ++it) {
+                writer->Node(kKidEntry, writer->Intern(it.key()), 0);
+                Validator(writer, it.value());
+            }
+        } else if (alg == "lazy" || alg == "warmup") {
+            Validator(writer, value);
+        } else if (IsHmac(alg)) {
+            writer->Validator(
+                j, MessageValidatorFactory::ParseSecret("secret", value));
+        } else if (IsPublicKey(alg)) {
+            writer->Validator(
+                j, MessageValidatorFactory::ParseSecret("public", value));
+        } else {
+            writer->Validator(j, "");
+        }
+    }
+};
+
+Bundle::Bundle(MessageValidator *validator, ClaimValidator *claims)
+    : validator_(validator), claims_(claims) {}
+
+std::string Bundle::Compile(const json &validator, const json &claims) {
+    // Building the configuration reports errors exactly like the factories.
+    validator_ptr check(MessageValidatorFactory::Build(validator));
+    if (!claims.is_null()) {
+        std::unique_ptr<ClaimValidator> claim_check(
+            ClaimValidatorFactory::Build(claims));
+    }
+
+    BundleWriter writer;
+    BundleCompiler::Validator(&writer, validator);
+    if (claims.is_null()) {
+        writer.Node(kNoClaims, 0, 0);
+    } else {
+        writer.Claim(claims);
+    }
+    return writer.Finish();
+}
+
+Bundle *Bundle::Parse(const uint8_t *data, size_t size) {
+    BundleReader reader(data, size);
+    std::vector<MessageValidator *> validators;
+    std::vector<ClaimValidator *> claims;
+    try {
+        reader.Header();
+        MessageValidator *root = reader.Validator(&validators);
+        ClaimValidator *claim_root = reader.Claim(&claims);
+        if (reader.Remaining() != 0) {
+            throw std::logic_error("Trailing data in bundle");
+        }
+
+        validator_ptr validator(
+            new ParsedMessagevalidator(json(), validators, root));
+        validators.clear();
+        claim_ptr claim;
+        if (claim_root != nullptr) {
+            claim.reset(new ParsedClaimvalidator(json(), claims, claim_root));
+            claims.clear();
+        }
+        Bundle *bundle = new Bundle(validator.get(), claim.get());
+        validator.release();
+        claim.release();
+        return bundle;
+    } catch (...) {
+        for (auto validator : validators) {
+            delete validator;
+        }
+        for (auto claim : claims) {
+            delete claim;
+        }
+        throw;
+    }
+}
+
+Bundle *Bundle::Load(const std::string &path) {
+    MappedFile file(path);
+    return Parse(file.data(), file.size());
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/claimprojection.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "private/membersax.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// Builds json for the kept members of the root object, and for all of a root
+// that is not an object.
+class Projector : public MemberSax {
+public:
+    Projector(const ClaimProjection &projection, const DecodeLimits *limits,
+              json *result)
+        : MemberSax(limits), projection_(projection), result_(result) {
+        *result_ = json::object();
+    }
+
+protected:
+    bool Wants(const std::string &key) { return projection_.Keeps(key); }
+
+    void Member(const std::string &key, json &&value) {
+        (*result_)[key] = std::move(value);
+    }
+
+    void Root(json &&value) { *result_ = std::move(value); }
+
+private:
+    const ClaimProjection &projection_;
+    json *result_;
+};
+
+}  // namespace
+
+ClaimProjection::ClaimProjection(const std::vector<std::string> &claims,
+                                 const ClaimValidator *validator)
+    : claims_(claims), keeps_all_(false) {
+    if (validator) {
+        keeps_all_ = !validator->ListClaims(&claims_);
+    }
+    std::sort(claims_.begin(), claims_.end());
+    claims_.erase(std::unique(claims_.begin(), claims_.end()), claims_.end());
+}
+
+bool ClaimProjection::Keeps(const std::string &claim) const {
+    return keeps_all_ ||
+           std::binary_search(claims_.begin(), claims_.end(), claim);
+}
+
+json ClaimProjection::Parse(const char *str, size_t num_str,
+                            const DecodeLimits *limits) const {
+    json result;
+    Projector projector(*this, limits, &result);
+    projector.Parse(str, num_str);
+    return result;
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/decodelimits.h"
+#include <algorithm>
+#include <string>
+#include "jwt/jwt_error.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+void CheckSize(const char *what, size_t size, size_t max) {
+    if (max != 0 && size > max) {
+        throw TokenFormatError(std::string(what) + " is larger than " +
+                               std::to_string(max) + " bytes");
+    }
+}
+
+// The larger of two limits, where 0 is no limit.
+size_t Looser(size_t a, size_t b) {
+    return a == 0 || b == 0 ? 0 : std::max(a, b);
+}
+
+}  // namespace
+
+DecodeLimits::DecodeLimits()
+    : max_token(0), max_sections({0, 0, 0}), max_depth(0), max_members(0) {}
+
+void DecodeLimits::CheckToken(size_t num_token) const {
+    CheckSize("Token", num_token, max_token);
+}
+
+void DecodeLimits::CheckSections(size_t num_header, size_t num_payload,
+                                 size_t num_signature) const {
+    Sections loosest = max_sections;
+    for (auto &alg : max_sections_by_alg) {
+        loosest.header = Looser(loosest.header, alg.second.header);
+        loosest.payload = Looser(loosest.payload, alg.second.payload);
+        loosest.signature = Looser(loosest.signature, alg.second.signature);
+    }
+    CheckSize("Header", num_header, loosest.header);
+    CheckSize("Payload", num_payload, loosest.payload);
+    CheckSize("Signature", num_signature, loosest.signature);
+}
+
+void DecodeLimits::CheckSections(const std::string &alg, size_t num_header,
+                                 size_t num_payload,
+                                 size_t num_signature) const {
+    auto found = max_sections_by_alg.find(alg);
+    const Sections &max =
+        found == max_sections_by_alg.end() ? max_sections : found->second;
+    CheckSize("Header", num_header, max.header);
+    CheckSize("Payload", num_payload, max.payload);
+    CheckSize("Signature", num_signature, max.signature);
+}
+
+json DecodeLimits::Parse(const char *str) const {
+    if (max_depth == 0 && max_members == 0) {
+        return json::parse(str);
+    }
+
+    size_t members = 0;
+    size_t max_depth = this->max_depth, max_members = this->max_members;
+    return json::parse(str, [&members, max_depth, max_members](
+                                int depth, json::parse_event_t event, json &) {
+        if (event == json::parse_event_t::object_end ||
+            event == json::parse_event_t::array_end) {
+            return true;
+        }
+        // Objects and arrays report the depth they are opened at.
+        if (max_depth != 0 &&
+            (event == json::parse_event_t::object_start ||
+             event == json::parse_event_t::array_start) &&
+            static_cast<size_t>(depth) >= max_depth) {
+            throw TokenFormatError("json is nested deeper than " +
+                                   std::to_string(max_depth));
+        }
+        if (max_members != 0 && ++members > max_members) {
+            throw TokenFormatError("json has more than " +
+                                   std::to_string(max_members) + " members");
+        }
+        return true;
+    });
+}
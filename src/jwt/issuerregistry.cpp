@@ -0,0 +1,258 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/issuerregistry.h"
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include "jwt/allocators.h"
+#include "jwt/claimvalidatorfactory.h"
+#include "jwt/jwt.h"
+#include "jwt/jwt_error.h"
+#include "jwt/messagevalidatorfactory.h"
+#include "jwt/precheck.h"
+#include "private/base64.h"
+#include "private/hash.h"
+
+using json = nlohmann::json;
+
+struct IssuerRegistry::Issuer {
+    validator_ptr validator;
+    claim_ptr claims;
+    // Refers to the claims, only set if the registry has limits.
+    std::unique_ptr<Precheck> precheck;
+};
+
+namespace {
+
+// Captures the string value of a single top level property and stops parsing
+// as soon as it has been seen. Nested objects and arrays are skipped.
+class TopLevelString : public nlohmann::json_sax<json> {
+public:
+    TopLevelString(const std::string &property, std::string *value)
+        : property_(property), value_(value), depth_(0), match_(false),
+          error_(false) {}
+
+    bool null() { return !match_; }
+    bool boolean(bool) { return !match_; }
+    bool number_integer(number_integer_t) { return !match_; }
+    bool number_unsigned(number_unsigned_t) { return !match_; }
+    bool number_float(number_float_t, const string_t &) { return !match_; }
+
+    bool string(string_t &val) {
+        if (match_) {
+            *value_ = val;
+            return false;
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        depth_++;
+        return !match_;
+    }
+
+    bool key(string_t &val) {
+        match_ = depth_ == 1 && val == property_;
+        return true;
+    }
+
+    bool end_object() {
+        depth_--;
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        depth_++;
+        return !match_;
+    }
+
+    bool end_array() {
+        depth_--;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &,
+                     const nlohmann::detail::exception &) {
+        error_ = true;
+        return false;
+    }
+
+    bool error() const { return error_; }
+
+private:
+    const std::string &property_;
+    std::string *value_;
+    int depth_;
+    bool match_;
+    bool error_;
+};
+
+// Finds the ends of the header and the payload.
+void Split(const char *token, size_t num_token, const char **header_end,
+           const char **payload_end) {
+    const char *end = token + num_token;
+    *header_end = std::find(token, end, '.');
+    *payload_end =
+        *header_end == end ? end : std::find(*header_end + 1, end, '.');
+    if (*payload_end == end) {
+        throw TokenFormatError("Invalid number of header sections.");
+    }
+}
+
+void PeekSection(const char *section, size_t num_section,
+                 const std::string &property, std::string *value) {
+    size_t num_decoded = Base64Encode::DecodeBytesNeeded(num_section);
+    str_ptr decoded(new char[num_decoded]);
+    if (Base64Encode::DecodeUrl(section, num_section, decoded.get(),
+                                &num_decoded) != 0) {
+        throw TokenFormatError("invalid base64 char.");
+    }
+
+    TopLevelString handler(property, value);
+    json::sax_parse(decoded.get(), decoded.get() + num_decoded, &handler);
+    if (handler.error()) {
+        throw TokenFormatError("token contains invalid json");
+    }
+}
+
+}  // namespace
+
+IssuerRegistry::IssuerRegistry() : shards_(new Shard[kShards]) {}
+
+IssuerRegistry::IssuerRegistry(const DecodeLimits &limits)
+    : shards_(new Shard[kShards]), limits_(new DecodeLimits(limits)) {}
+
+IssuerRegistry::~IssuerRegistry() {}
+
+IssuerRegistry::Shard &IssuerRegistry::ShardFor(
+    const std::string &issuer) const {
+    return shards_[Fnv1a(issuer.data(), issuer.size()) % kShards];
+}
+
+void IssuerRegistry::Register(const std::string &issuer,
+                              MessageValidator *validator,
+                              ClaimValidator *claims) {
+    std::shared_ptr<Issuer> entry(new Issuer());
+    entry->validator.reset(validator);
+    entry->claims.reset(claims);
+    if (limits_) {
+        entry->precheck.reset(new Precheck(claims, *limits_));
+    }
+
+    Shard &shard = ShardFor(issuer);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    shard.issuers[issuer] = entry;
+}
+
+void IssuerRegistry::Register(const std::string &issuer, const json &validator,
+                              const json &claims) {
+    validator_ptr message(MessageValidatorFactory::Build(validator));
+    ClaimValidator *claim =
+        claims.is_null() ? nullptr : ClaimValidatorFactory::Build(claims);
+    Register(issuer, message.release(), claim);
+}
+
+void IssuerRegistry::Load(const json &issuers) {
+    if (!issuers.is_object()) {
+        throw std::logic_error(issuers.dump() + " is not an object!");
+    }
+    for (auto it = issuers.begin(); it != issuers.end(); ++it) {
+        const json &issuer = it.value();
+        if (!issuer.is_object() || !issuer.count("validator")) {
+            throw std::logic_error("No validator declared for issuer: " +
+                                   it.key());
+        }
+        Register(it.key(), issuer["validator"],
+                 issuer.count("claims") ? issuer["claims"] : json());
+    }
+}
+
+bool IssuerRegistry::Remove(const std::string &issuer) {
+    Shard &shard = ShardFor(issuer);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.issuers.erase(issuer) != 0;
+}
+
+size_t IssuerRegistry::size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < kShards; i++) {
+        std::lock_guard<std::mutex> guard(shards_[i].lock);
+        size += shards_[i].issuers.size();
+    }
+    return size;
+}
+
+std::tuple<json, json> IssuerRegistry::Decode(const std::string &token) const {
+    if (limits_) {
+        limits_->CheckToken(token.size());
+    }
+    const char *header_end, *payload_end;
+    Split(token.data(), token.size(), &header_end, &payload_end);
+    if (limits_) {
+        limits_->CheckSections(header_end - token.data(),
+                               payload_end - header_end - 1,
+                               token.data() + token.size() - payload_end - 1);
+    }
+
+    // The kid is not needed to find the issuer, so the header is left to
+    // JWT::Decode.
+    std::string iss;
+    PeekSection(header_end + 1, payload_end - header_end - 1, "iss", &iss);
+
+    std::shared_ptr<const Issuer> issuer;
+    {
+        Shard &shard = ShardFor(iss);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.issuers.find(iss);
+        if (found != shard.issuers.end()) {
+            issuer = found->second;
+        }
+    }
+    if (!issuer) {
+        throw InvalidSignatureError("No validator for issuer: " + iss);
+    }
+
+    auto decoded = JWT::Decode(token, issuer->validator.get(),
+                               issuer->claims.get(), issuer->precheck.get());
+
+    // The peek reads the first iss claim, a full parse keeps the last one.
+    const json &payload = std::get<1>(decoded);
+    auto found = payload.find("iss");
+    if (found == payload.end() || *found != iss) {
+        throw InvalidClaimError("Ambiguous iss claim");
+    }
+    return decoded;
+}
+
+void IssuerRegistry::Peek(const char *token, size_t num_token,
+                          std::string *kid, std::string *iss) {
+    const char *header_end, *payload_end;
+    Split(token, num_token, &header_end, &payload_end);
+
+    iss->clear();
+    if (kid) {
+        kid->clear();
+        PeekSection(token, header_end - token, "kid", kid);
+    }
+    PeekSection(header_end + 1, payload_end - header_end - 1, "iss", iss);
+}
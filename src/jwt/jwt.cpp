@@ -23,9 +23,12 @@
 #include "jwt/jwt.h"
 #include <exception>
 #include <string>
+#include <utility>
 #include "jwt/allocators.h"
 #include "jwt/jwt_error.h"
+#include "jwt/precheck.h"
 #include "private/base64.h"
+#include "private/payloaddecoder.h"
 
 using json = nlohmann::json;
 
@@ -41,13 +44,50 @@ std::string JWT::Encode(const MessageSigner &validator, const json &payload, jso
 
 std::tuple<json, json> JWT::Decode(const std::string &jwsToken,
                                 MessageValidator *verifier,
-                                ClaimValidator *validator) {
-    return Decode(jwsToken.c_str(), jwsToken.size(), verifier, validator);
+                                ClaimValidator *validator,
+                                const Precheck *precheck) {
+    return Decode(jwsToken.c_str(), jwsToken.size(), verifier, validator,
+                  precheck);
+}
+
+std::tuple<json, json> JWT::Decode(const std::string &jwsToken,
+                                   const ClaimProjection &projection,
+                                   MessageValidator *verifier,
+                                   ClaimValidator *validator,
+                                   const Precheck *precheck) {
+    JsonPayloadDecoder decoder(&projection);
+    json header = Decode(jwsToken.c_str(), jwsToken.size(), verifier,
+                         validator, precheck, &decoder);
+    return std::make_tuple(std::move(header), std::move(decoder.payload()));
 }
 
 std::tuple<json, json> JWT::Decode(const char *jws_token, size_t num_jws_token,
                                    MessageValidator *verifier,
-                                   ClaimValidator *validator) {
+                                   ClaimValidator *validator,
+                                   const Precheck *precheck) {
+    JsonPayloadDecoder decoder(nullptr);
+    json header = Decode(jws_token, num_jws_token, verifier, validator,
+                         precheck, &decoder);
+    return std::make_tuple(std::move(header), std::move(decoder.payload()));
+}
+
+json JWT::DecodeTyped(const char *jws_token, size_t num_jws_token,
+                      MessageValidator *verifier, ClaimValidator *validator,
+                      const Precheck *precheck, const ClaimFieldsBase &fields,
+                      RegisteredClaims *claims, void *object) {
+    TypedPayloadDecoder decoder(fields, claims, object, validator, precheck);
+    return Decode(jws_token, num_jws_token, verifier, validator, precheck,
+                  &decoder);
+}
+
+json JWT::Decode(const char *jws_token, size_t num_jws_token,
+                 MessageValidator *verifier, ClaimValidator *validator,
+                 const Precheck *precheck, PayloadDecoder *decoder) {
+    const DecodeLimits *limits = precheck ? &precheck->limits() : nullptr;
+    if (limits) {
+        limits->CheckToken(num_jws_token);
+    }
+
     int idx = 0;
     const char *header = jws_token, *payload = jws_token,
                *signature = jws_token, *it = jws_token;
@@ -66,6 +106,10 @@ std::tuple<json, json> JWT::Decode(const char *jws_token, size_t num_jws_token,
                 num_payload = (it - payload);
                 num_signature = num_jws_token - (it - jws_token) - 1;
                 signature = it + 1;
+                if (limits) {
+                    limits->CheckSections(num_header, num_payload,
+                                          num_signature);
+                }
             }
         } else if (!Base64Encode::IsValidBase64Char(*it)) {
             throw TokenFormatError("invalid base64 char.");
@@ -93,30 +137,43 @@ std::tuple<json, json> JWT::Decode(const char *jws_token, size_t num_jws_token,
 
     json header_claims;
     try {
-        header_claims = json::parse(dec_header.get());
+        header_claims = limits ? limits->Parse(dec_header.get())
+                               : json::parse(dec_header.get());
     } catch (std::exception &e) {
         throw TokenFormatError(std::string("header contains invalid json: ") +
                                e.what());
     }
 
-    json payload_claims;
+    if (limits) {
+        auto alg = header_claims.find("alg");
+        limits->CheckSections(
+            alg != header_claims.end() && alg->is_string() ? alg->get<std::string>()
+                                                           : "",
+            num_header, num_payload, num_signature);
+    }
+
     try {
-        payload_claims = ExtractPayload(payload, num_payload);
+        ExtractPayload(payload, num_payload, limits, decoder);
     } catch (std::exception &e) {
         throw TokenFormatError(std::string("payload contains invalid json: ") +
                                e.what());
     }
 
+    if (precheck) {
+        decoder->CheckUnverified(*precheck);
+    }
+
     VerifySignature(header_claims, header, num_header + num_payload + 1,
                     signature, num_signature, verifier);
     if (validator) {
-        validator->IsValid(payload_claims);
+        decoder->Validate(validator);
     }
 
-    return std::make_tuple(header_claims, payload_claims);
+    return header_claims;
 }
 
-json JWT::ExtractPayload(const char *payload, size_t num_payload) {
+void JWT::ExtractPayload(const char *payload, size_t num_payload,
+                         const DecodeLimits *limits, PayloadDecoder *decoder) {
     size_t num_dec_payload = Base64Encode::DecodeBytesNeeded(num_payload);
     str_ptr dec_payload(new char[num_dec_payload]);
 
@@ -128,7 +185,7 @@ json JWT::ExtractPayload(const char *payload, size_t num_payload) {
 
     // Make sure we have a proper \0 termination
     dec_payload.get()[num_dec_payload] = 0;
-    return json::parse(dec_payload.get());
+    decoder->Parse(dec_payload.get(), num_dec_payload, limits);
 }
 
 bool JWT::VerifySignature(const json &header_claims_, const char *header,
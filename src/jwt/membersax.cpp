@@ -0,0 +1,150 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/membersax.h"
+#include <string>
+#include <utility>
+#include "jwt/jwt_error.h"
+
+using json = nlohmann::json;
+
+MemberSax::MemberSax(const DecodeLimits *limits)
+    : limits_(limits), target_(nullptr), depth_(0), members_(0),
+      root_object_(false), capturing_(false) {}
+
+void MemberSax::Parse(const char *str, size_t num_str) {
+    json::sax_parse(str, str + num_str, this);
+}
+
+bool MemberSax::null() { return Value(json()); }
+bool MemberSax::boolean(bool val) { return Value(json(val)); }
+bool MemberSax::number_integer(number_integer_t val) {
+    return Value(json(val));
+}
+bool MemberSax::number_unsigned(number_unsigned_t val) {
+    return Value(json(val));
+}
+bool MemberSax::number_float(number_float_t val, const string_t &) {
+    return Value(json(val));
+}
+bool MemberSax::string(string_t &val) { return Value(json(std::move(val))); }
+bool MemberSax::start_object(std::size_t) { return Start(json::object()); }
+bool MemberSax::start_array(std::size_t) { return Start(json::array()); }
+bool MemberSax::end_object() { return End(); }
+bool MemberSax::end_array() { return End(); }
+
+bool MemberSax::key(string_t &val) {
+    Count();
+    if (depth_ == 1 && root_object_) {
+        capturing_ = Wants(val);
+        if (capturing_) {
+            key_ = val;
+            value_ = json();
+            target_ = &value_;
+        }
+    } else if (capturing_) {
+        target_ = &(*stack_.back())[val];
+    }
+    return true;
+}
+
+bool MemberSax::parse_error(std::size_t, const std::string &,
+                            const nlohmann::detail::exception &ex) {
+    throw TokenFormatError(ex.what());
+}
+
+json *MemberSax::Slot() {
+    if (depth_ == 0) {
+        capturing_ = true;
+        value_ = json();
+        return &value_;
+    }
+    if (!capturing_) {
+        return nullptr;
+    }
+    if (!stack_.empty() && stack_.back()->is_array()) {
+        stack_.back()->push_back(json());
+        return &stack_.back()->back();
+    }
+    json *slot = target_;
+    target_ = nullptr;
+    return slot;
+}
+
+bool MemberSax::Value(json &&value) {
+    Count();
+    json *slot = Slot();
+    if (slot) {
+        *slot = std::move(value);
+    }
+    Complete();
+    return true;
+}
+
+bool MemberSax::Start(json &&container) {
+    Count();
+    if (limits_ && limits_->max_depth != 0 && depth_ >= limits_->max_depth) {
+        throw TokenFormatError("json is nested deeper than " +
+                               std::to_string(limits_->max_depth));
+    }
+    if (depth_ == 0 && container.is_object()) {
+        root_object_ = true;
+    } else if (json *slot = Slot()) {
+        *slot = std::move(container);
+        stack_.push_back(slot);
+    }
+    depth_++;
+    return true;
+}
+
+bool MemberSax::End() {
+    depth_--;
+    if (capturing_) {
+        stack_.pop_back();
+        Complete();
+    }
+    return true;
+}
+
+// Hands the value over once a member, or a root that is not an object, is
+// complete.
+void MemberSax::Complete() {
+    if (!capturing_ || !stack_.empty()) {
+        return;
+    }
+    if (depth_ == 1 && root_object_) {
+        capturing_ = false;
+        Member(key_, std::move(value_));
+    } else if (depth_ == 0 && !root_object_) {
+        capturing_ = false;
+        Root(std::move(value_));
+    }
+}
+
+void MemberSax::Count() {
+    if (limits_ && limits_->max_members != 0 &&
+        ++members_ > limits_->max_members) {
+        throw TokenFormatError("json has more than " +
+                               std::to_string(limits_->max_members) +
+                               " members");
+    }
+}
@@ -0,0 +1,362 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/payloaddecoder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include "jwt/jwt_error.h"
+#include "jwt/listclaimvalidator.h"
+#include "jwt/timevalidator.h"
+#include "private/membersax.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+const std::string kNoProperty;
+
+// The registered claim a built in validator checks, 0 if the validator needs
+// json. Subclasses need json, they may override Check.
+RegisteredClaims::Claim Registered(const ClaimValidator *validator) {
+    RegisteredClaims::Claim claim =
+        RegisteredClaims::Find(validator->property());
+    const std::type_info &type = typeid(*validator);
+    switch (claim) {
+        case RegisteredClaims::kExp:
+        case RegisteredClaims::kNbf:
+        case RegisteredClaims::kIat:
+            if (type == typeid(ExpValidator) || type == typeid(NbfValidator) ||
+                type == typeid(IatValidator) || type == typeid(TimeValidator)) {
+                return claim;
+            }
+            break;
+        case RegisteredClaims::kAud:
+            if (type == typeid(AudValidator)) {
+                return claim;
+            }
+            break;
+        case RegisteredClaims::kIss:
+        case RegisteredClaims::kSub:
+            if (type == typeid(ListClaimValidator) ||
+                type == typeid(IssValidator) || type == typeid(SubValidator)) {
+                return claim;
+            }
+            break;
+        default:
+            break;
+    }
+    return static_cast<RegisteredClaims::Claim>(0);
+}
+
+// True if the value has the type the spec requires for the claim.
+bool Fits(RegisteredClaims::Claim claim, const json &value) {
+    switch (claim) {
+        case RegisteredClaims::kExp:
+        case RegisteredClaims::kNbf:
+        case RegisteredClaims::kIat:
+            return value.is_number();
+        case RegisteredClaims::kAud:
+            return value.is_string() || value.is_array();
+        default:
+            return value.is_string();
+    }
+}
+
+void Assign(RegisteredClaims::Claim claim, json *value,
+            RegisteredClaims *claims) {
+    if (!Fits(claim, *value)) {
+        claims->present &= ~claim;
+        return;
+    }
+    claims->present |= claim;
+    switch (claim) {
+        case RegisteredClaims::kIss:
+            claims->iss = std::move(value->get_ref<std::string &>());
+            break;
+        case RegisteredClaims::kSub:
+            claims->sub = std::move(value->get_ref<std::string &>());
+            break;
+        case RegisteredClaims::kJti:
+            claims->jti = std::move(value->get_ref<std::string &>());
+            break;
+        case RegisteredClaims::kExp:
+            claims->exp = value->get<int64_t>();
+            break;
+        case RegisteredClaims::kNbf:
+            claims->nbf = value->get<int64_t>();
+            break;
+        case RegisteredClaims::kIat:
+            claims->iat = value->get<int64_t>();
+            break;
+        case RegisteredClaims::kAud:
+            claims->aud.clear();
+            if (value->is_string()) {
+                claims->aud.push_back(
+                    std::move(value->get_ref<std::string &>()));
+                break;
+            }
+            for (auto &element : *value) {
+                if (element.is_string()) {
+                    claims->aud.push_back(
+                        std::move(element.get_ref<std::string &>()));
+                }
+            }
+            break;
+    }
+}
+
+void Assign(const ClaimFieldsBase::Field &field, json *value, void *object) {
+    void *member = field.address(object);
+    bool fits = false;
+    switch (field.kind) {
+        case ClaimFieldsBase::kString:
+            if ((fits = value->is_string())) {
+                *static_cast<std::string *>(member) =
+                    std::move(value->get_ref<std::string &>());
+            }
+            break;
+        case ClaimFieldsBase::kInteger:
+            if ((fits = value->is_number_integer())) {
+                *static_cast<int64_t *>(member) = value->get<int64_t>();
+            }
+            break;
+        case ClaimFieldsBase::kNumber:
+            if ((fits = value->is_number())) {
+                *static_cast<double *>(member) = value->get<double>();
+            }
+            break;
+        case ClaimFieldsBase::kBoolean:
+            if ((fits = value->is_boolean())) {
+                *static_cast<bool *>(member) = value->get<bool>();
+            }
+            break;
+        case ClaimFieldsBase::kStrings:
+            fits = value->is_array() &&
+                   std::all_of(value->begin(), value->end(),
+                               [](const json &e) { return e.is_string(); });
+            if (fits) {
+                auto strings = static_cast<std::vector<std::string> *>(member);
+                strings->clear();
+                for (auto &element : *value) {
+                    strings->push_back(
+                        std::move(element.get_ref<std::string &>()));
+                }
+            }
+            break;
+        case ClaimFieldsBase::kJson:
+            fits = true;
+            *static_cast<json *>(member) = std::move(*value);
+            break;
+    }
+    if (!fits) {
+        throw TokenFormatError("claim " + field.name + " is a " +
+                               value->type_name() +
+                               ", which does not fit its field");
+    }
+}
+
+}  // namespace
+
+// Fills the typed claims and fields, and keeps the untyped claims as json.
+class TypedPayloadDecoder::Reader : public MemberSax {
+public:
+    Reader(TypedPayloadDecoder *decoder, const DecodeLimits *limits)
+        : MemberSax(limits), decoder_(decoder) {}
+
+protected:
+    bool Wants(const std::string &key) {
+        return RegisteredClaims::Find(key) || decoder_->fields_.Find(key) ||
+               decoder_->KeepsUntyped(key);
+    }
+
+    void Member(const std::string &key, json &&value) {
+        RegisteredClaims::Claim claim = RegisteredClaims::Find(key);
+        // A registered claim of the wrong type is kept so validators can
+        // report it.
+        if (decoder_->KeepsUntyped(key) || (claim && !Fits(claim, value))) {
+            decoder_->untyped_[key] = value;
+        }
+        if (claim) {
+            Assign(claim, &value, decoder_->claims_);
+        } else if (auto field = decoder_->fields_.Find(key)) {
+            Assign(*field, &value, decoder_->object_);
+        }
+    }
+
+    void Root(json &&value) {
+        throw TokenFormatError(std::string("payload is a ") +
+                               value.type_name() + ", not an object");
+    }
+
+private:
+    TypedPayloadDecoder *decoder_;
+};
+
+void JsonPayloadDecoder::Parse(const char *str, size_t num_str,
+                               const DecodeLimits *limits) {
+    if (projection_ && !projection_->keeps_all()) {
+        payload_ = projection_->Parse(str, num_str, limits);
+    } else {
+        payload_ = limits ? limits->Parse(str) : json::parse(str);
+    }
+}
+
+void JsonPayloadDecoder::CheckUnverified(const Precheck &precheck) const {
+    precheck.CheckClaims(payload_);
+}
+
+void JsonPayloadDecoder::Validate(ClaimValidator *validator) const {
+    validator->IsValid(payload_);
+}
+
+TypedPayloadDecoder::TypedPayloadDecoder(const ClaimFieldsBase &fields,
+                                         RegisteredClaims *claims,
+                                         void *object,
+                                         const ClaimValidator *validator,
+                                         const Precheck *precheck)
+    : fields_(fields), claims_(claims), object_(object), keeps_all_(false),
+      untyped_(json::object()) {
+    if (validator) {
+        Select(validator);
+    }
+    if (precheck) {
+        for (auto check : precheck->checks()) {
+            Select(check);
+        }
+    }
+    std::sort(untyped_claims_.begin(), untyped_claims_.end());
+}
+
+void TypedPayloadDecoder::Parse(const char *str, size_t num_str,
+                                const DecodeLimits *limits) {
+    Reader reader(this, limits);
+    reader.Parse(str, num_str);
+}
+
+void TypedPayloadDecoder::CheckUnverified(const Precheck &precheck) const {
+    for (auto check : precheck.checks()) {
+        Check(check).ThrowIfInvalid();
+    }
+}
+
+void TypedPayloadDecoder::Validate(ClaimValidator *validator) const {
+    Check(validator).ThrowIfInvalid();
+}
+
+// Collects the claims the validators that cannot use the typed claims read.
+void TypedPayloadDecoder::Select(const ClaimValidator *validator) {
+    const ClaimValidator *const *children;
+    size_t num_children;
+    switch (validator->Children(&children, &num_children)) {
+        case ClaimValidator::kLeaf:
+            if (!Registered(validator)) {
+                keeps_all_ =
+                    !validator->ListClaims(&untyped_claims_) || keeps_all_;
+            }
+            break;
+        case ClaimValidator::kOptionalOf:
+            if (!Registered(children[0])) {
+                Select(children[0]);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < num_children; i++) {
+                Select(children[i]);
+            }
+            break;
+    }
+}
+
+// Mirrors the Check of the composite validators, so that only the leaves
+// decide between the typed claims and json.
+ClaimStatus TypedPayloadDecoder::Check(const ClaimValidator *validator) const {
+    const ClaimValidator *const *children;
+    size_t num_children;
+    switch (validator->Children(&children, &num_children)) {
+        case ClaimValidator::kWrapper:
+            return Check(children[0]);
+        case ClaimValidator::kAllOf:
+            for (size_t i = 0; i < num_children; i++) {
+                ClaimStatus status = Check(children[i]);
+                if (!status) {
+                    return status;
+                }
+            }
+            return ClaimStatus();
+        case ClaimValidator::kAnyOf:
+            for (size_t i = 0; i < num_children; i++) {
+                if (Check(children[i])) {
+                    return ClaimStatus();
+                }
+            }
+            return ClaimStatus(ClaimStatus::kNoneValid, &kNoProperty);
+        case ClaimValidator::kOptionalOf: {
+            RegisteredClaims::Claim claim = Registered(children[0]);
+            if (claim && claims_->has(claim)) {
+                return CheckTyped(children[0], claim);
+            }
+            return validator->Check(untyped_);
+        }
+        case ClaimValidator::kLeaf:
+            break;
+    }
+    RegisteredClaims::Claim claim = Registered(validator);
+    if (claim && claims_->has(claim)) {
+        return CheckTyped(validator, claim);
+    }
+    return validator->Check(untyped_);
+}
+
+ClaimStatus TypedPayloadDecoder::CheckTyped(
+    const ClaimValidator *validator, RegisteredClaims::Claim claim) const {
+    switch (claim) {
+        case RegisteredClaims::kExp:
+            return static_cast<const TimeValidator *>(validator)->CheckTime(
+                claims_->exp);
+        case RegisteredClaims::kNbf:
+            return static_cast<const TimeValidator *>(validator)->CheckTime(
+                claims_->nbf);
+        case RegisteredClaims::kIat:
+            return static_cast<const TimeValidator *>(validator)->CheckTime(
+                claims_->iat);
+        case RegisteredClaims::kIss:
+            return static_cast<const ListClaimValidator *>(validator)
+                ->CheckValue(claims_->iss);
+        case RegisteredClaims::kSub:
+            return static_cast<const ListClaimValidator *>(validator)
+                ->CheckValue(claims_->sub);
+        case RegisteredClaims::kAud:
+            return static_cast<const AudValidator *>(validator)->CheckValues(
+                claims_->aud);
+        default:
+            throw std::logic_error("claim is not checked typed");
+    }
+}
+
+bool TypedPayloadDecoder::KeepsUntyped(const std::string &claim) const {
+    return keeps_all_ || std::binary_search(untyped_claims_.begin(),
+                                            untyped_claims_.end(), claim);
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/registeredclaims.h"
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+RegisteredClaims::Claim RegisteredClaims::Find(const std::string &name) {
+    static const std::pair<const char *, Claim> kClaims[] = {
+        {"iss", kIss}, {"sub", kSub}, {"aud", kAud}, {"exp", kExp},
+        {"nbf", kNbf}, {"iat", kIat}, {"jti", kJti}};
+    if (name.size() != 3) {
+        return static_cast<Claim>(0);
+    }
+    for (const auto &claim : kClaims) {
+        if (name == claim.first) {
+            return claim.second;
+        }
+    }
+    return static_cast<Claim>(0);
+}
+
+const ClaimFieldsBase::Field *ClaimFieldsBase::Find(
+    const std::string &name) const {
+    for (const auto &field : fields_) {
+        if (field.name == name) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+void ClaimFieldsBase::Insert(const std::string &name, Kind kind,
+                             std::function<void *(void *)> address) {
+    if (RegisteredClaims::Find(name)) {
+        throw std::logic_error(name + " is a registered claim");
+    }
+    if (Find(name)) {
+        throw std::logic_error(name + " is described twice");
+    }
+    fields_.push_back({name, kind, std::move(address)});
+}
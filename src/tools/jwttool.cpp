@@ -0,0 +1,138 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "jwt/bundle.h"
+#include "jwt/json.hpp"
+#include "jwt/keystorevalidator.h"
+#include "jwt/revocationvalidator.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+int Usage() {
+    std::cerr << "Usage:" << std::endl
+              << "  jwt-tool bundle <validator.json> <claims.json|-> <output>"
+              << std::endl
+              << "    Compiles the validator and claim configuration into a "
+                 "binary bundle."
+              << std::endl
+              << "  jwt-tool keystore <keys.json> <output>" << std::endl
+              << "    Writes the keys, { \"kid\" : { \"HS256\" : { "
+                 "\"secret\" : \"...\" } } }, to a key file."
+              << std::endl
+              << "  jwt-tool revocations <revoked.json> <output>" << std::endl
+              << "    Writes the revoked values, { \"jti\" : [ \"...\" ], "
+                 "\"sub\" : [ \"...\" ] }, to a revocation file."
+              << std::endl;
+    return 1;
+}
+
+json ReadJson(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::logic_error("Unable to read: " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return json::parse(buffer.str());
+}
+
+int CompileBundle(int argc, char *argv[]) {
+    if (argc != 5) {
+        return Usage();
+    }
+
+    std::string claims = argv[3];
+    std::string bundle = Bundle::Compile(
+        ReadJson(argv[2]), claims == "-" ? json() : ReadJson(claims));
+
+    std::ofstream out(argv[4], std::ios::binary);
+    out.write(bundle.data(), bundle.size());
+    if (!out) {
+        std::cerr << "Unable to write: " << argv[4] << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int WriteKeyStore(int argc, char *argv[]) {
+    if (argc != 4) {
+        return Usage();
+    }
+
+    json keys = ReadJson(argv[2]);
+    KeyStoreWriter writer;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        json &key = it.value();
+        if (!key.is_object() || key.size() != 1) {
+            throw std::logic_error("Expected a single key at: " + it.key());
+        }
+        writer.Add(it.key(), key.begin().key(),
+                   key.begin().value()["secret"].get<std::string>());
+    }
+    writer.Write(argv[3]);
+    return 0;
+}
+
+int WriteRevocations(int argc, char *argv[]) {
+    if (argc != 4) {
+        return Usage();
+    }
+
+    json revoked = ReadJson(argv[2]);
+    RevocationWriter writer;
+    for (auto it = revoked.begin(); it != revoked.end(); ++it) {
+        for (auto &value : it.value()) {
+            writer.Add(it.key(), value.get<std::string>());
+        }
+    }
+    writer.Write(argv[3]);
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        return Usage();
+    }
+
+    std::string command = argv[1];
+    try {
+        if (command == "bundle") {
+            return CompileBundle(argc, argv);
+        } else if (command == "keystore") {
+            return WriteKeyStore(argc, argv);
+        } else if (command == "revocations") {
+            return WriteRevocations(argc, argv);
+        }
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return Usage();
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/filewatcher.h"
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(int poll_interval_ms)
+    : poll_interval_ms_(poll_interval_ms), stop_(false), inotify_fd_(-1) {
+    wake_fd_[0] = wake_fd_[1] = -1;
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 && pipe(wake_fd_) != 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+#endif
+    thread_ = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        stop_ = true;
+    }
+    wakeup_.notify_all();
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        char wake = 0;
+        if (write(wake_fd_[1], &wake, 1) < 0) {
+            // The poll timeout will stop the thread.
+        }
+    }
+#endif
+    thread_.join();
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        close(wake_fd_[0]);
+        close(wake_fd_[1]);
+    }
+#endif
+}
+
+bool FileWatcher::Stamp::operator==(const Stamp &other) const {
+    return exists == other.exists && device == other.device &&
+           inode == other.inode && size == other.size &&
+           modified_ns == other.modified_ns;
+}
+
+FileWatcher::Stamp FileWatcher::Stat(const std::string &path) {
+    Stamp stamp = {false, 0, 0, 0, 0};
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return stamp;
+    }
+    stamp.exists = true;
+    stamp.device = info.st_dev;
+    stamp.inode = info.st_ino;
+    stamp.size = info.st_size;
+    stamp.modified_ns = static_cast<uint64_t>(info.st_mtime) * 1000000000;
+#ifdef __linux__
+    stamp.modified_ns += info.st_mtim.tv_nsec;
+#endif
+    return stamp;
+}
+
+bool FileWatcher::IsSymlink(const std::string &path) {
+#ifdef _WIN32
+    return false;
+#else
+    struct stat info;
+    return lstat(path.c_str(), &info) == 0 && S_ISLNK(info.st_mode);
+#endif
+}
+
+void FileWatcher::Watch(const std::string &path, Callback callback) {
+    size_t slash = path.find_last_of('/');
+    Stamp stamp = Stat(path);
+    std::string name =
+        slash == std::string::npos ? path : path.substr(slash + 1);
+    Entry entry = {path, name, -1, stamp, stamp, callback};
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        std::string dir = slash == std::string::npos
+                              ? "."
+                              : slash == 0 ? "/" : path.substr(0, slash);
+        entry.watch = inotify_add_watch(inotify_fd_, dir.c_str(),
+                                        IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+#endif
+    std::lock_guard<std::mutex> lock(lock_);
+    entries_.push_back(entry);
+}
+
+std::vector<FileWatcher::Event> FileWatcher::Wait() {
+    std::vector<Event> events;
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0},
+                                {wake_fd_[0], POLLIN, 0}};
+        if (poll(fds, 2, poll_interval_ms_) > 0 && (fds[0].revents & POLLIN)) {
+            alignas(struct inotify_event) char buffer[4096];
+            ssize_t num_read;
+            while ((num_read = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+                for (char *it = buffer; it < buffer + num_read;) {
+                    auto event = reinterpret_cast<struct inotify_event *>(it);
+                    events.push_back({event->wd,
+                                      event->len ? event->name : "",
+                                      (event->mask & IN_MOVED_TO) != 0});
+                    it += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+        return events;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(lock_);
+    wakeup_.wait_for(lock, std::chrono::milliseconds(poll_interval_ms_),
+                     [this]() { return stop_; });
+    return events;
+}
+
+bool FileWatcher::Changed(Entry *entry, const std::vector<Event> &events) {
+    if (entry->watch < 0) {
+        // Polled files are reported once they are stable for an interval.
+        Stamp stamp = Stat(entry->path);
+        if (stamp == entry->seen || stamp != entry->pending) {
+            entry->pending = stamp;
+            return false;
+        }
+        entry->seen = stamp;
+        return stamp.exists;
+    }
+
+    for (const auto &event : events) {
+        // A rename can swap the target of a symlink under any name.
+        if (event.watch == entry->watch &&
+            (event.name == entry->name ||
+             (event.moved && IsSymlink(entry->path)))) {
+            Stamp stamp = Stat(entry->path);
+            if (stamp == entry->seen) {
+                return false;
+            }
+            entry->seen = stamp;
+            return stamp.exists;
+        }
+    }
+    return false;
+}
+
+void FileWatcher::CheckAll(const std::vector<Event> &events) {
+    std::vector<Callback> changed;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto &entry : entries_) {
+            if (Changed(&entry, events)) {
+                changed.push_back(entry.callback);
+            }
+        }
+    }
+
+    for (auto &callback : changed) {
+        callback();
+    }
+}
+
+void FileWatcher::Run() {
+    while (true) {
+        std::vector<Event> events = Wait();
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (stop_) return;
+        }
+        CheckAll(events);
+    }
+}
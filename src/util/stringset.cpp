@@ -0,0 +1,75 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/stringset.h"
+#include <string.h>
+#include <string>
+#include <vector>
+#include "private/hash.h"
+
+StringSet::StringSet(const std::vector<std::string> &values) {
+    size_t capacity = 4;
+    while (capacity < values.size() * 2) {
+        capacity <<= 1;
+    }
+    mask_ = capacity - 1;
+    Slot empty = {0, 0};
+    slots_.assign(capacity, empty);
+
+    for (const auto &value : values) {
+        uint64_t hash = Fnv1a(value.data(), value.size());
+        uint64_t idx = hash & mask_;
+        bool duplicate = false;
+        while (slots_[idx].index != 0) {
+            const Slot &slot = slots_[idx];
+            if (slot.hash == static_cast<uint32_t>(hash) &&
+                values_[slot.index - 1] == value) {
+                duplicate = true;
+                break;
+            }
+            idx = (idx + 1) & mask_;
+        }
+        if (duplicate) {
+            continue;
+        }
+        values_.push_back(value);
+        slots_[idx].hash = static_cast<uint32_t>(hash);
+        slots_[idx].index = values_.size();
+    }
+}
+
+int64_t StringSet::Find(const char *str, size_t len) const {
+    uint64_t hash = Fnv1a(str, len);
+    uint32_t tag = static_cast<uint32_t>(hash);
+    for (uint64_t idx = hash & mask_; slots_[idx].index != 0;
+         idx = (idx + 1) & mask_) {
+        const Slot &slot = slots_[idx];
+        if (slot.hash != tag) {
+            continue;
+        }
+        const std::string &value = values_[slot.index - 1];
+        if (value.size() == len && memcmp(value.data(), str, len) == 0) {
+            return slot.index - 1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/algorithm.h"
+#include <string.h>
+#include <string>
+
+namespace {
+
+const char *kNames[] = {"ES256", "ES384", "ES512", "EdDSA",
+                        "HS256", "HS384", "HS512", "RS256",
+                        "RS384", "RS512", "none",  ""};
+
+}  // namespace
+
+Algorithm Algorithms::Parse(const char *name, size_t num_name) {
+    // All names but "none" have 5 characters.
+    if (num_name != 5 && num_name != 4) {
+        return Algorithm::UNKNOWN;
+    }
+    for (size_t i = 0; i < kCount; i++) {
+        if (strlen(kNames[i]) == num_name &&
+            memcmp(kNames[i], name, num_name) == 0) {
+            return static_cast<Algorithm>(i);
+        }
+    }
+    return Algorithm::UNKNOWN;
+}
+
+Algorithm Algorithms::FromJose(const json &jose) {
+    if (!jose.is_object()) {
+        return Algorithm::UNKNOWN;
+    }
+    auto alg = jose.find("alg");
+    if (alg == jose.end() || !alg->is_string()) {
+        return Algorithm::UNKNOWN;
+    }
+    return Parse(alg->get_ref<const std::string &>());
+}
+
+const char *Algorithms::Name(Algorithm algorithm) {
+    return kNames[static_cast<size_t>(algorithm)];
+}
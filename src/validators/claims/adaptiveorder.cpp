@@ -0,0 +1,139 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/adaptiveorder.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+uint32_t Weight(ClaimValidator::Cost cost) {
+  switch (cost) {
+  case ClaimValidator::kCheap:
+    return 1;
+  case ClaimValidator::kModerate:
+    return 4;
+  case ClaimValidator::kExpensive:
+    return 16;
+  default:
+    return 0;  // stateful, never moved
+  }
+}
+
+}  // namespace
+
+AdaptiveOrder::AdaptiveOrder(const std::vector<ClaimValidator *> &children,
+                             bool decide_on)
+    : children_(children), decide_on_(decide_on),
+      counters_(new Counters[children.size()]), order_(0), calls_(0) {
+  if (children_.size() > kMaxChildren) {
+    throw std::logic_error("Too many children to order adaptively");
+  }
+  uint64_t order = 0;
+  for (size_t i = 0; i < children_.size(); i++) {
+    weights_.push_back(Weight(children_[i]->cost()));
+    counters_[i].evaluated.store(0, std::memory_order_relaxed);
+    counters_[i].decided.store(0, std::memory_order_relaxed);
+    order |= static_cast<uint64_t>(i) << (4 * i);
+  }
+  order_.store(order, std::memory_order_release);
+}
+
+ClaimStatus AdaptiveOrder::All(const json &claimset) const {
+  uint64_t order = order_.load(std::memory_order_acquire);
+  ClaimStatus status;
+  for (size_t i = 0; i < children_.size(); i++, order >>= 4) {
+    size_t child = order & 0xf;
+    status = children_[child]->Check(claimset);
+    Record(child, status.valid());
+    if (!status) {
+      break;
+    }
+  }
+  if (calls_.fetch_add(1, std::memory_order_relaxed) % kInterval ==
+      kInterval - 1) {
+    Reorder();
+  }
+  return status;
+}
+
+bool AdaptiveOrder::Any(const json &claimset) const {
+  uint64_t order = order_.load(std::memory_order_acquire);
+  bool valid = false;
+  for (size_t i = 0; i < children_.size() && !valid; i++, order >>= 4) {
+    size_t child = order & 0xf;
+    valid = children_[child]->Check(claimset).valid();
+    Record(child, valid);
+  }
+  if (calls_.fetch_add(1, std::memory_order_relaxed) % kInterval ==
+      kInterval - 1) {
+    Reorder();
+  }
+  return valid;
+}
+
+void AdaptiveOrder::Record(size_t child, bool valid) const {
+  counters_[child].evaluated.fetch_add(1, std::memory_order_relaxed);
+  if (valid == decide_on_) {
+    counters_[child].decided.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void AdaptiveOrder::Reorder() const {
+  // The chance a child decides the outcome, with one decided and one
+  // undecided evaluation as prior, per unit of cost.
+  std::vector<double> score(children_.size());
+  for (size_t i = 0; i < children_.size(); i++) {
+    // Halve by subtracting, so counts added since the load are kept.
+    uint32_t evaluated = counters_[i].evaluated.load(std::memory_order_relaxed);
+    uint32_t decided = counters_[i].decided.load(std::memory_order_relaxed);
+    counters_[i].evaluated.fetch_sub(evaluated - evaluated / 2,
+                                     std::memory_order_relaxed);
+    counters_[i].decided.fetch_sub(decided - decided / 2,
+                                   std::memory_order_relaxed);
+    if (weights_[i] != 0) {
+      score[i] = (decided + 1.0) / (evaluated + 2.0) / weights_[i];
+    }
+  }
+
+  std::vector<size_t> order;
+  for (size_t i = 0; i < children_.size(); i++) {
+    order.push_back(i);
+  }
+  auto by_score = [&score](size_t a, size_t b) { return score[a] > score[b]; };
+  auto begin = order.begin();
+  for (auto it = order.begin(); it != order.end(); ++it) {
+    if (weights_[*it] == 0) {
+      std::stable_sort(begin, it, by_score);
+      begin = it + 1;
+    }
+  }
+  std::stable_sort(begin, order.end(), by_score);
+
+  uint64_t packed = 0;
+  for (size_t i = 0; i < order.size(); i++) {
+    packed |= static_cast<uint64_t>(order[i]) << (4 * i);
+  }
+  order_.store(packed, std::memory_order_release);
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/claimpath.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+// The array index denoted by a reference token, or -1 if it is not one.
+int64_t ArrayIndex(const std::string &token) {
+  if (token.empty() || token.size() > 18 ||
+      (token.size() > 1 && token[0] == '0')) {
+    return -1;
+  }
+  int64_t index = 0;
+  for (char c : token) {
+    if (c < '0' || c > '9') {
+      return -1;
+    }
+    index = index * 10 + (c - '0');
+  }
+  return index;
+}
+}  // namespace
+
+ClaimPath::ClaimPath(const std::string &path)
+    : pointer_(!path.empty() && path[0] == '/') {
+  if (!pointer_) {
+    Token token = {path, -1};
+    tokens_.push_back(token);
+    return;
+  }
+
+  size_t start = 1;
+  for (;;) {
+    size_t end = path.find('/', start);
+    std::string key;
+    for (size_t i = start; i < std::min(end, path.size()); i++) {
+      if (path[i] != '~') {
+        key.push_back(path[i]);
+      } else if (i + 1 < path.size() && path[i + 1] == '0') {
+        key.push_back('~');
+        i++;
+      } else if (i + 1 < path.size() && path[i + 1] == '1') {
+        key.push_back('/');
+        i++;
+      } else {
+        throw std::logic_error("Invalid escape in json pointer: " + path);
+      }
+    }
+    Token token = {key, ArrayIndex(key)};
+    tokens_.push_back(token);
+    if (end == std::string::npos) {
+      break;
+    }
+    start = end + 1;
+  }
+}
+
+const ClaimPath::json *ClaimPath::Find(const json &claimset) const {
+  const json *current = &claimset;
+  for (const auto &token : tokens_) {
+    if (current->is_object()) {
+      auto found = current->find(token.key);
+      if (found == current->end()) {
+        return nullptr;
+      }
+      current = &*found;
+    } else if (current->is_array() && token.index >= 0 &&
+               static_cast<uint64_t>(token.index) < current->size()) {
+      current = &(*current)[token.index];
+    } else {
+      return nullptr;
+    }
+  }
+  return current;
+}
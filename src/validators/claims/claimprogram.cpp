@@ -0,0 +1,262 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/claimprogram.h"
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "jwt/jwt_error.h"
+#include "jwt/listclaimvalidator.h"
+#include "jwt/timevalidator.h"
+
+namespace {
+// Claims live in a fixed array on the stack unless a tree refers to more
+// distinct claims than this.
+const size_t kInlineSlots = 16;
+
+// Marks a slot that has not been looked up yet, a missing claim is nullptr.
+const nlohmann::json kUnresolved;
+}  // namespace
+
+ClaimProgram::ClaimProgram(const ClaimValidator *root) {
+  uint32_t reject = Label();
+  Emit(root, reject);
+  Add(kAccept, 0, 0, 0);
+  Bind(reject);
+  Add(kReject, 0, 0, 0);
+
+  // Replace the label ids with the instruction offsets they were bound to.
+  for (auto &instruction : program_) {
+    if (instruction.op != kAccept && instruction.op != kReject) {
+      instruction.target = labels_[instruction.target];
+    }
+  }
+  labels_.clear();
+}
+
+uint32_t ClaimProgram::Slot(const std::string &property) {
+  for (size_t i = 0; i < slots_.size(); i++) {
+    if (slots_[i] == property) {
+      return i;
+    }
+  }
+  slots_.push_back(property);
+  paths_.push_back(ClaimPath(property));
+  return slots_.size() - 1;
+}
+
+bool ClaimProgram::SharesLookups() const {
+  std::vector<bool> used(slots_.size(), false);
+  for (const auto &instruction : program_) {
+    switch (instruction.op) {
+    case kList:
+    case kAud:
+    case kTime:
+    case kSkip:
+      if (used[instruction.slot]) {
+        return true;
+      }
+      used[instruction.slot] = true;
+      break;
+    default:
+      break;
+    }
+  }
+  return false;
+}
+
+uint32_t ClaimProgram::Label() {
+  labels_.push_back(0);
+  return labels_.size() - 1;
+}
+
+void ClaimProgram::Bind(uint32_t label) { labels_[label] = program_.size(); }
+
+void ClaimProgram::Add(Op op, uint32_t slot, uint32_t arg, uint32_t target) {
+  Instruction instruction = {op, slot, arg, target};
+  program_.push_back(instruction);
+}
+
+void ClaimProgram::Emit(const ClaimValidator *node, uint32_t fail) {
+  const ClaimValidator *const *children;
+  size_t num_children;
+  switch (node->Children(&children, &num_children)) {
+  case ClaimValidator::kWrapper:
+    Emit(children[0], fail);
+    return;
+  case ClaimValidator::kAllOf:
+    for (size_t i = 0; i < num_children; i++) {
+      Emit(children[i], fail);
+    }
+    return;
+  case ClaimValidator::kAnyOf: {
+    uint32_t done = Label();
+    for (size_t i = 0; i < num_children; i++) {
+      uint32_t next = Label();
+      Emit(children[i], next);
+      Add(kJump, 0, 0, done);
+      Bind(next);
+    }
+    Add(kFail, 0, 0, fail);
+    Bind(done);
+    return;
+  }
+  case ClaimValidator::kOptionalOf: {
+    uint32_t done = Label();
+    Add(kSkip, Slot(node->property()), 0, done);
+    Emit(children[0], fail);
+    Bind(done);
+    return;
+  }
+  case ClaimValidator::kLeaf:
+    break;
+  }
+
+  // Only the built in classes become opcodes, a subclass may override Check.
+  const std::type_info &type = typeid(*node);
+  if (type == typeid(AudValidator)) {
+    leaves_.push_back(node);
+    Add(kAud, Slot(node->property()), leaves_.size() - 1, fail);
+  } else if (type == typeid(ListClaimValidator) ||
+             type == typeid(IssValidator) || type == typeid(SubValidator)) {
+    leaves_.push_back(node);
+    Add(kList, Slot(node->property()), leaves_.size() - 1, fail);
+  } else if (type == typeid(ExpValidator) || type == typeid(NbfValidator) ||
+             type == typeid(IatValidator) || type == typeid(TimeValidator)) {
+    leaves_.push_back(node);
+    Add(kTime, Slot(node->property()), leaves_.size() - 1, fail);
+  } else {
+    calls_.push_back(node);
+    Add(kCall, 0, calls_.size() - 1, fail);
+  }
+}
+
+ClaimStatus ClaimProgram::Run(const json &claimset) const {
+  const json *inline_slots[kInlineSlots];
+  std::unique_ptr<const json *[]> heap_slots;
+  const json **slots = inline_slots;
+  if (slots_.size() > kInlineSlots) {
+    heap_slots.reset(new const json *[slots_.size()]);
+    slots = heap_slots.get();
+  }
+  for (size_t i = 0; i < slots_.size(); i++) {
+    slots[i] = &kUnresolved;
+  }
+
+  // Only the last failure is reported.
+  ClaimStatus failed;
+  uint32_t pc = 0;
+  for (;;) {
+    const Instruction &instruction = program_[pc];
+    const ClaimValidator *leaf = nullptr;
+    const json *value = nullptr;
+    bool accepted = false;
+
+    switch (instruction.op) {
+    case kList:
+      leaf = leaves_[instruction.arg];
+      value = Load(slots, instruction.slot, claimset);
+      accepted =
+          static_cast<const ListClaimValidator *>(leaf)->AcceptsClaim(value);
+      break;
+    case kAud:
+      leaf = leaves_[instruction.arg];
+      value = Load(slots, instruction.slot, claimset);
+      accepted = static_cast<const AudValidator *>(leaf)->AcceptsClaim(value);
+      break;
+    case kTime:
+      leaf = leaves_[instruction.arg];
+      value = Load(slots, instruction.slot, claimset);
+      accepted = static_cast<const TimeValidator *>(leaf)->AcceptsClaim(value);
+      break;
+    case kSkip:
+      pc = Load(slots, instruction.slot, claimset) ? pc + 1
+                                                   : instruction.target;
+      continue;
+    case kCall: {
+      ClaimStatus status = calls_[instruction.arg]->Check(claimset);
+      if (status) {
+        pc++;
+      } else {
+        failed = status;
+        pc = instruction.target;
+      }
+      continue;
+    }
+    case kJump:
+      pc = instruction.target;
+      continue;
+    case kFail:
+      failed = ClaimStatus(ClaimStatus::kNoneValid, nullptr);
+      pc = instruction.target;
+      continue;
+    case kAccept:
+      return ClaimStatus();
+    case kReject:
+      return failed;
+    }
+
+    if (accepted) {
+      pc++;
+    } else {
+      failed = Failure(instruction, value);
+      pc = instruction.target;
+    }
+  }
+}
+
+const ClaimProgram::json *ClaimProgram::Load(const json **slots, uint32_t slot,
+                                             const json &claimset) const {
+  if (slots[slot] == &kUnresolved) {
+    slots[slot] = paths_[slot].Find(claimset);
+  }
+  return slots[slot];
+}
+
+ClaimStatus ClaimProgram::Failure(const Instruction &instruction,
+                                  const json *value) const {
+  const ClaimValidator *leaf = leaves_[instruction.arg];
+  switch (instruction.op) {
+  case kList:
+    return static_cast<const ListClaimValidator *>(leaf)->Failure(value);
+  case kAud:
+    return static_cast<const AudValidator *>(leaf)->Failure(value);
+  case kTime:
+    return static_cast<const TimeValidator *>(leaf)->Failure(value);
+  default:
+    throw std::logic_error("Instruction has no leaf validator");
+  }
+}
+
+CompiledClaimValidator::CompiledClaimValidator(ClaimValidator *tree)
+    : ClaimValidator(tree->property()), tree_(tree), root_(tree),
+      program_(tree) {}
+
+bool CompiledClaimValidator::IsValid(const json &claimset) const {
+  return program_.Run(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus CompiledClaimValidator::Check(const json &claimset) const {
+  return program_.Run(claimset);
+}
+
+std::string CompiledClaimValidator::toJson() const { return tree_->toJson(); }
@@ -21,23 +21,143 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/claimvalidator.h"
+#include "private/adaptiveorder.h"
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <vector>
 
-AllClaimValidator::AllClaimValidator(std::vector<ClaimValidator *> validators)
-    : ClaimValidator(""), validators_(validators) {}
+namespace {
+
+// The most expensive cost among the validators, stateful if any of them is.
+ClaimValidator::Cost MaxCost(const std::vector<ClaimValidator *> &validators) {
+  ClaimValidator::Cost cost = ClaimValidator::kCheap;
+  for (auto validator : validators) {
+    cost = std::max(cost, validator->cost());
+  }
+  return cost;
+}
+
+// Lists the claims of all validators, false if any of them may read any claim.
+bool ListAll(const std::vector<ClaimValidator *> &validators,
+             std::vector<std::string> *claims) {
+  for (auto validator : validators) {
+    if (!validator->ListClaims(claims)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+ClaimStatus ClaimStatus::Error(const std::string &message) {
+  ClaimStatus status(kError, nullptr);
+  status.message_ = message;
+  return status;
+}
+
+std::string ClaimStatus::message() const {
+  static const std::string unknown = "";
+  const std::string &property = property_ ? *property_ : unknown;
+  switch (code_) {
+  case kValid:
+    return "";
+  case kMissing:
+    if (wording_ == kList || wording_ == kAud) {
+      return std::string("Validator: missing: ") + property;
+    }
+    return std::string("Missing claim: ") + property;
+  case kWrongType:
+    if (wording_ == kTime) {
+      return std::string("Missing claim: ") + property;
+    }
+    if (wording_ == kList && value_) {
+      return std::string("Validator: ") + property + ", in: " + value_->dump() +
+             " not a string, but " + value_->type_name();
+    }
+    if (wording_ == kAud && value_) {
+      return std::string("AudValidator: ") + value_->dump() +
+             " not a string/array, but " + value_->type_name();
+    }
+    return std::string("Wrong type for: ") + property +
+           (value_ ? std::string(", ") + value_->dump() + " is a " +
+                         value_->type_name()
+                   : std::string());
+  case kNegative:
+    return std::string("Negative time for: ") + property;
+  case kInvalid:
+    if (wording_ == kTime) {
+      return std::string("Failed: ") + property;
+    }
+    if (wording_ == kAud && value_ && value_->is_array()) {
+      return std::string("Invalid: ") + property;
+    }
+    return std::string("Validator invalid: ") + property;
+  case kNoneValid:
+    return "None of the children validate";
+  case kError:
+    return message_;
+  }
+  return message_;
+}
+
+bool ClaimStatus::ThrowIfInvalid() const {
+  if (code_ != kValid) {
+    throw InvalidClaimError(message());
+  }
+  return true;
+}
+
+ClaimStatus ClaimValidator::Check(const json &claimset) const {
+  try {
+    if (IsValid(claimset)) {
+      return ClaimStatus();
+    }
+    return ClaimStatus(ClaimStatus::kInvalid, &property_);
+  } catch (const InvalidClaimError &ice) {
+    return ClaimStatus::Error(ice.what());
+  }
+}
+
+AllClaimValidator::AllClaimValidator(std::vector<ClaimValidator *> validators,
+                                     bool adaptive)
+    : ClaimValidator(""), validators_(validators),
+      order_(adaptive ? new AdaptiveOrder(validators, false) : nullptr) {}
+
+AllClaimValidator::~AllClaimValidator() {}
 
 bool AllClaimValidator::IsValid(const json &claimset) const {
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus AllClaimValidator::Check(const json &claimset) const {
+  if (order_) {
+    return order_->All(claimset);
+  }
   for (auto validator : validators_) {
-    validator->IsValid(claimset);
+    ClaimStatus status = validator->Check(claimset);
+    if (!status) {
+      return status;
+    }
   }
-  return true;
+  return ClaimStatus();
+}
+
+ClaimValidator::Cost AllClaimValidator::cost() const {
+  return MaxCost(validators_);
+}
+
+bool AllClaimValidator::ListClaims(std::vector<std::string> *claims) const {
+  return ListAll(validators_, claims);
 }
 
 std::string AllClaimValidator::toJson() const {
   std::ostringstream msg;
+  if (order_) {
+    msg << "{ \"adaptive\" : ";
+  }
   msg << "{ \"all\" : [ ";
   int num = validators_.size();
   for (auto validator : validators_) {
@@ -46,25 +166,50 @@ std::string AllClaimValidator::toJson() const {
       msg << ", ";
   }
   msg << " ] }";
+  if (order_) {
+    msg << " }";
+  }
   return msg.str();
 }
 
-AnyClaimValidator::AnyClaimValidator(std::vector<ClaimValidator *> validators)
-    : ClaimValidator(""), validators_(validators) {}
+AnyClaimValidator::AnyClaimValidator(std::vector<ClaimValidator *> validators,
+                                     bool adaptive)
+    : ClaimValidator(""), validators_(validators),
+      order_(adaptive ? new AdaptiveOrder(validators, true) : nullptr) {}
+
+AnyClaimValidator::~AnyClaimValidator() {}
 
 bool AnyClaimValidator::IsValid(const json &claimset) const {
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus AnyClaimValidator::Check(const json &claimset) const {
+  if (order_) {
+    return order_->Any(claimset)
+               ? ClaimStatus()
+               : ClaimStatus(ClaimStatus::kNoneValid, &property_);
+  }
   for (auto validator : validators_) {
-    try {
-      if (validator->IsValid(claimset))
-        return true;
-    } catch (const InvalidClaimError &ice) {
+    if (validator->Check(claimset)) {
+      return ClaimStatus();
     }
   }
-  throw InvalidClaimError("None of the children validate");
+  return ClaimStatus(ClaimStatus::kNoneValid, &property_);
+}
+
+ClaimValidator::Cost AnyClaimValidator::cost() const {
+  return MaxCost(validators_);
+}
+
+bool AnyClaimValidator::ListClaims(std::vector<std::string> *claims) const {
+  return ListAll(validators_, claims);
 }
 
 std::string AnyClaimValidator::toJson() const {
   std::ostringstream msg;
+  if (order_) {
+    msg << "{ \"adaptive\" : ";
+  }
   msg << "{ \"any\" : [ ";
   int num = validators_.size();
   for (auto validator : validators_) {
@@ -73,6 +218,9 @@ std::string AnyClaimValidator::toJson() const {
       msg << ", ";
   }
   msg << " ] }";
+  if (order_) {
+    msg << " }";
+  }
   return msg.str();
 }
 
@@ -80,7 +228,14 @@ OptionalClaimValidator::OptionalClaimValidator(const ClaimValidator *inner)
     : ClaimValidator(inner->property()), inner_(inner) {}
 
 bool OptionalClaimValidator::IsValid(const json &claimset) const {
-  return !claimset.count(property_) || inner_->IsValid(claimset);
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus OptionalClaimValidator::Check(const json &claimset) const {
+  if (!Find(claimset)) {
+    return ClaimStatus();
+  }
+  return inner_->Check(claimset);
 }
 
 std::string OptionalClaimValidator::toJson() const {
@@ -22,13 +22,18 @@
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/claimvalidatorfactory.h"
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 #include "jwt/allocators.h"
+#include "jwt/jtireplayvalidator.h"
 #include "jwt/listclaimvalidator.h"
+#include "jwt/revocationvalidator.h"
+#include "jwt/scopevalidator.h"
 #include "jwt/timevalidator.h"
 #include "private/buildwrappers.h"
+#include "private/claimprogram.h"
 
 #include "jwt/json.hpp"
 using json = nlohmann::json;
@@ -62,27 +67,69 @@ ClaimValidator *ClaimValidatorFactory::BuildInternal(const json &json) {
             constructed = new SubValidator(BuildList(json["sub"]));
         } else if (json.count("aud")) {
             constructed = new AudValidator(BuildList(json["aud"]));
+        } else if (json.count("claim")) {
+            ::json claim = json["claim"];
+            constructed = new ListClaimValidator(
+                claim["path"].get<std::string>(), BuildList(claim["accepted"]));
         } else if (json.count("exp")) {
             ::json val = json["exp"];
-            ::json leeway = val["leeway"];
-            constructed =
-                new ExpValidator(leeway.is_null() ? 0 : leeway.get<int>());
+            constructed = new ExpValidator(BuildLeeway(val), BuildClock(val));
         } else if (json.count("nbf")) {
             ::json val = json["nbf"];
-            ::json leeway = val["leeway"];
-            constructed =
-                new NbfValidator(leeway.is_null() ? 0 : leeway.get<int>());
+            constructed = new NbfValidator(BuildLeeway(val), BuildClock(val));
         } else if (json.count("iat")) {
             ::json val = json["iat"];
-            ::json leeway = val["leeway"];
-            constructed =
-                new IatValidator(leeway.is_null() ? 0 : leeway.get<int>());
+            constructed = new IatValidator(BuildLeeway(val), BuildClock(val));
+        } else if (json.count("jti")) {
+            ::json val = json["jti"];
+            ::json entries = val.is_null() ? ::json() : val["entries"];
+            ::json ttl = val.is_null() ? ::json() : val["ttl"];
+            constructed = new JtiReplayValidator(
+                entries.is_null() ? JtiReplayValidator::kDefaultEntries
+                                  : entries.get<size_t>(),
+                ttl.is_null() ? JtiReplayValidator::kDefaultTtl
+                              : ttl.get<uint64_t>(),
+                BuildClock(val));
+        } else if (json.count("revoked")) {
+            ::json revoked = json["revoked"];
+            ::json watch = revoked["watch"];
+            constructed = new RevocationValidator(
+                revoked["file"].get<std::string>(),
+                revoked.count("claims")
+                    ? BuildList(revoked["claims"])
+                    : std::vector<std::string>({"jti", "sub"}),
+                watch.is_null() || watch.get<bool>());
+        } else if (json.count("scope")) {
+            ::json scope = json["scope"];
+            ::json claim = scope["claim"];
+            if (!scope.count("required") && !scope.count("any")) {
+                throw std::logic_error("scope needs required or any scopes");
+            }
+            constructed = new ScopeValidator(
+                claim.is_null() ? "scope" : claim.get<std::string>(),
+                scope.count("required") ? BuildList(scope["required"])
+                                        : std::vector<std::string>(),
+                scope.count("any") ? BuildList(scope["any"])
+                                   : std::vector<std::string>());
         } else if (json.count("all")) {
             constructed =
                 new AllClaimValidator(BuildValidatorList(json["all"]));
         } else if (json.count("any")) {
             constructed =
                 new AnyClaimValidator(BuildValidatorList(json["any"]));
+        } else if (json.count("adaptive")) {
+            ::json adaptive = json["adaptive"];
+            if (adaptive.size() != 1 ||
+                (!adaptive.count("all") && !adaptive.count("any"))) {
+                throw std::logic_error("adaptive needs an all or any");
+            }
+            if (adaptive.count("all")) {
+                constructed = new AllClaimValidator(
+                    BuildValidatorList(adaptive["all"]), true);
+            } else {
+                constructed = new AnyClaimValidator(
+                    BuildValidatorList(adaptive["any"]), true);
+            }
         } else if (json.count("optional")) {
             ClaimValidator *inner = BuildInternal(json["optional"]);
             constructed = new OptionalClaimValidator(inner);
@@ -113,6 +160,20 @@ ClaimValidator *ClaimValidatorFactory::Build(const json &json) {
     return validator;
 }
 
+ClaimValidator *ClaimValidatorFactory::Compile(const std::string &fromJson) {
+    json json = json::parse(fromJson);
+    return Compile(json);
+}
+
+ClaimValidator *ClaimValidatorFactory::Compile(const json &json) {
+    std::unique_ptr<CompiledClaimValidator> compiled(
+        new CompiledClaimValidator(Build(json)));
+    if (!compiled->program().SharesLookups()) {
+        return compiled->Release();
+    }
+    return compiled.release();
+}
+
 std::vector<ClaimValidator *> ClaimValidatorFactory::BuildValidatorList(
     const json &json) {
     if (!json.is_array()) {
@@ -127,6 +188,34 @@ std::vector<ClaimValidator *> ClaimValidatorFactory::BuildValidatorList(
     return result;
 }
 
+uint64_t ClaimValidatorFactory::BuildLeeway(const json &json) {
+    if (json.is_null()) {
+        return 0;
+    }
+    if (!json.is_object()) {
+        throw std::logic_error(json.dump() + " is not an object!");
+    }
+    if (!json.count("leeway")) {
+        return 0;
+    }
+    ::json leeway = json["leeway"];
+    return leeway.is_null() ? 0 : leeway.get<int>();
+}
+
+IClock *ClaimValidatorFactory::BuildClock(const json &json) {
+    if (json.is_null() || !json.count("clock")) {
+        return TimeValidator::utc_clock();
+    }
+    ::json clock = json["clock"];
+    if (clock == "utc") {
+        return TimeValidator::utc_clock();
+    }
+    if (clock == "coarse") {
+        return TimeValidator::coarse_clock();
+    }
+    throw std::logic_error("Unknown clock: " + clock.dump());
+}
+
 std::vector<std::string> ClaimValidatorFactory::BuildList(const json &object) {
     if (!object.is_array()) {
         throw std::logic_error(object.dump() + " is not an array!");
@@ -155,6 +244,10 @@ bool ParsedClaimvalidator::IsValid(const json &claimset) const {
     return root_->IsValid(claimset);
 }
 
+ClaimStatus ParsedClaimvalidator::Check(const json &claimset) const {
+    return root_->Check(claimset);
+}
+
 ParsedClaimvalidator::~ParsedClaimvalidator() {
     for (auto it = children_.begin(); it != children_.end(); it++) {
         delete *it;
@@ -0,0 +1,131 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/jtireplayvalidator.h"
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include "jwt/timevalidator.h"
+#include "private/clock.h"
+#include "private/hash.h"
+#include "private/timingwheel.h"
+
+struct JtiReplayValidator::Shard {
+  Shard() : wheel(0) {}
+
+  std::mutex lock;
+  // The wheel refers to the ids in the set, whose nodes never move.
+  std::unordered_set<std::string> seen;
+  TimingWheel<const std::string *> wheel;
+};
+
+JtiReplayValidator::JtiReplayValidator(size_t max_entries, uint64_t ttl,
+                                       IClock *clock)
+    : ClaimValidator("jti"),
+      max_entries_(max_entries),
+      ttl_(ttl),
+      clock_(clock),
+      shards_(new Shard[kShards]) {
+  uint64_t now = clock_->Now();
+  for (size_t i = 0; i < kShards; i++) {
+    shards_[i].wheel = TimingWheel<const std::string *>(now);
+  }
+}
+
+JtiReplayValidator::JtiReplayValidator(size_t max_entries, uint64_t ttl)
+    : JtiReplayValidator(max_entries, ttl, TimeValidator::utc_clock()) {}
+
+JtiReplayValidator::JtiReplayValidator()
+    : JtiReplayValidator(kDefaultEntries, kDefaultTtl) {}
+
+JtiReplayValidator::~JtiReplayValidator() {}
+
+bool JtiReplayValidator::IsValid(const json &claimset) const {
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus JtiReplayValidator::Check(const json &claimset) const {
+  if (!claimset.is_object()) {
+    return ClaimStatus(ClaimStatus::kMissing, &property_);
+  }
+  auto jti = claimset.find(property_);
+  if (jti == claimset.end()) {
+    return ClaimStatus(ClaimStatus::kMissing, &property_);
+  }
+  if (!jti->is_string()) {
+    return ClaimStatus(ClaimStatus::kWrongType, &property_, &*jti);
+  }
+
+  const std::string &id = jti->get_ref<const std::string &>();
+  Shard &shard = shards_[Fnv1a(id.data(), id.size()) % kShards];
+  std::lock_guard<std::mutex> lock(shard.lock);
+  shard.wheel.Advance(clock_->Now(), [&shard](const std::string *expired) {
+    shard.seen.erase(shard.seen.find(*expired));
+  });
+
+  // The wheel never moves back, even if the clock does.
+  uint64_t expiry = shard.wheel.now() + (ttl_ ? ttl_ : 1);
+  auto exp = claimset.find("exp");
+  if (exp != claimset.end() && exp->is_number() && exp->get<int64_t>() >= 0 &&
+      exp->get<uint64_t>() > expiry) {
+    expiry = exp->get<uint64_t>();
+  }
+
+  if (shard.seen.count(id)) {
+    return ClaimStatus(ClaimStatus::kInvalid, &property_);
+  }
+  if (shard.seen.size() >= (max_entries_ + kShards - 1) / kShards) {
+    return ClaimStatus::Error("Too many tokens to track replays of jti");
+  }
+
+  auto inserted = shard.seen.insert(id).first;
+  shard.wheel.Add(&*inserted, expiry);
+  return ClaimStatus();
+}
+
+size_t JtiReplayValidator::size() const {
+  size_t size = 0;
+  for (size_t i = 0; i < kShards; i++) {
+    std::lock_guard<std::mutex> lock(shards_[i].lock);
+    size += shards_[i].seen.size();
+  }
+  return size;
+}
+
+bool JtiReplayValidator::ListClaims(std::vector<std::string> *claims) const {
+  // The exp claim extends how long a token id is remembered.
+  claims->push_back(property_);
+  claims->push_back("exp");
+  return true;
+}
+
+std::string JtiReplayValidator::toJson() const {
+  std::ostringstream msg;
+  msg << "{ \"jti\" : { \"entries\" : " << max_entries_
+      << ", \"ttl\" : " << ttl_;
+  if (clock_ == TimeValidator::coarse_clock()) {
+    msg << ", \"clock\" : \"coarse\"";
+  }
+  msg << " } }";
+  return msg.str();
+}
@@ -22,38 +22,71 @@
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/listclaimvalidator.h"
 #include "jwt/jwt_error.h"
+#include "private/stringset.h"
 
 #include <sstream>
 #include <string.h>
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 ListClaimValidator::ListClaimValidator(const std::string &property,
                                        const std::vector<std::string> &accepted)
-    : ClaimValidator(property), accepted_(accepted) {}
+    : ClaimValidator(property),
+      accepted_(accepted),
+      accepted_set_(std::make_shared<StringSet>(accepted)) {}
 
 bool ListClaimValidator::IsValid(const json &claim) const {
-  if (!claim.count(property_)) {
-    throw InvalidClaimError(std::string("Validator: missing: ") + property_);
-  }
+  return Check(claim).ThrowIfInvalid();
+}
 
-  auto object = claim[property_];
-  if (!object.is_string()) {
-    throw InvalidClaimError(std::string("Validator: ") + property_ +
-                            ", in: " + object.dump() + " not a string, but " +
-                            object.type_name());
-  }
+ClaimStatus ListClaimValidator::Check(const json &claim) const {
+  return CheckClaim(Find(claim));
+}
 
-  std::string value = object.get<std::string>();
-  for (auto accept : accepted_) {
-    if (accept == value)
-      return true;
+ClaimStatus ListClaimValidator::CheckClaim(const json *object) const {
+  return AcceptsClaim(object) ? ClaimStatus() : Failure(object);
+}
+
+ClaimStatus ListClaimValidator::CheckValue(const std::string &value) const {
+  if (accepted_set_->Contains(value)) {
+    return ClaimStatus();
   }
+  return ClaimStatus(ClaimStatus::kInvalid, &property_, nullptr,
+                     ClaimStatus::kList);
+}
+
+bool ListClaimValidator::AcceptsClaim(const json *object) const {
+  return object && object->is_string() &&
+         accepted_set_->Contains(object->get_ref<const std::string &>());
+}
 
-  throw InvalidClaimError(std::string("Validator invalid: ") + property_);
+ClaimStatus ListClaimValidator::Failure(const json *object) const {
+  return Failure(object, ClaimStatus::kList);
+}
+
+ClaimStatus ListClaimValidator::Failure(const json *object,
+                                        ClaimStatus::Wording wording) const {
+  if (!object) {
+    return ClaimStatus(ClaimStatus::kMissing, &property_, nullptr, wording);
+  }
+  if (!object->is_string()) {
+    return ClaimStatus(ClaimStatus::kWrongType, &property_, object, wording);
+  }
+  return ClaimStatus(ClaimStatus::kInvalid, &property_, nullptr, wording);
 }
 
 std::string ListClaimValidator::toJson() const {
+  // Only the iss, sub and aud validators have the short form. A plain list
+  // on the aud claim would otherwise be rebuilt as an AudValidator, which
+  // also accepts arrays.
+  const std::type_info &type = typeid(*this);
+  if (type != typeid(IssValidator) && type != typeid(SubValidator) &&
+      type != typeid(AudValidator)) {
+    json claim = {{"path", property_}, {"accepted", accepted_}};
+    return json({{"claim", claim}}).dump();
+  }
+
   std::ostringstream msg;
   msg << "{ \"" << property() << "\" : [";
   int last = accepted_.size();
@@ -66,27 +99,42 @@ std::string ListClaimValidator::toJson() const {
   return msg.str();
 }
 
-bool AudValidator::IsValid(const json &claim) const {
-  if (!claim.count(property_)) {
-    throw InvalidClaimError(std::string("AudValidator claim: " + claim.dump() +
-                                        " is missing: " + property_));
+ClaimStatus AudValidator::Check(const json &claim) const {
+  return CheckClaim(Find(claim));
+}
+
+ClaimStatus AudValidator::CheckClaim(const json *object) const {
+  return AcceptsClaim(object) ? ClaimStatus() : Failure(object);
+}
+
+ClaimStatus
+AudValidator::CheckValues(const std::vector<std::string> &values) const {
+  for (const auto &value : values) {
+    if (accepted_set_->Contains(value)) {
+      return ClaimStatus();
+    }
   }
+  return ClaimStatus(ClaimStatus::kInvalid, &property_, nullptr,
+                     ClaimStatus::kAud);
+}
 
-  json object = claim[property_];
-  if (!object.is_string() && !object.is_array()) {
-    throw InvalidClaimError(std::string("AudValidator: " + object.dump() +
-                                        " not a string/array, but " +
-                                        object.type_name()));
+bool AudValidator::AcceptsClaim(const json *object) const {
+  if (!object || !object->is_array()) {
+    return ListClaimValidator::AcceptsClaim(object);
   }
-  if (object.is_string()) {
-    return ListClaimValidator::IsValid(claim);
+  for (const auto &element : *object) {
+    if (element.is_string() &&
+        accepted_set_->Contains(element.get_ref<const std::string &>())) {
+      return true;
+    }
   }
+  return false;
+}
 
-  for (json::iterator it = object.begin(); it != object.end(); ++it) {
-    for (auto accept : accepted_) {
-      if (accept == *it)
-        return true;
-    }
+ClaimStatus AudValidator::Failure(const json *object) const {
+  if (object && object->is_array()) {
+    return ClaimStatus(ClaimStatus::kInvalid, &property_, object,
+                       ClaimStatus::kAud);
   }
-  throw InvalidClaimError(std::string("Invalid: ") += property_);
+  return ListClaimValidator::Failure(object, ClaimStatus::kAud);
 }
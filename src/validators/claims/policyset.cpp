@@ -0,0 +1,178 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/policyset.h"
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "jwt/listclaimvalidator.h"
+#include "jwt/revocationvalidator.h"
+#include "jwt/scopevalidator.h"
+#include "jwt/timevalidator.h"
+
+namespace {
+// The results of the distinct validators live in a fixed array on the stack
+// unless the policies have more of them than this.
+const size_t kInlineResults = 64;
+
+enum Result : uint8_t { kUnknown, kRejected, kAccepted };
+
+// Built in validators are identified by their class and configuration, all
+// others by their address. Two classes can describe different checks with the
+// same json.
+std::string LeafKey(const ClaimValidator *leaf) {
+  std::ostringstream key;
+  if (auto time = dynamic_cast<const TimeValidator *>(leaf)) {
+    key << "T" << typeid(*leaf).name()
+        << static_cast<const void *>(time->clock())
+        << nlohmann::json::parse(time->toJson()).dump();
+  } else if (dynamic_cast<const ListClaimValidator *>(leaf) ||
+             dynamic_cast<const ScopeValidator *>(leaf) ||
+             dynamic_cast<const RevocationValidator *>(leaf)) {
+    key << "L" << typeid(*leaf).name()
+        << nlohmann::json::parse(leaf->toJson()).dump();
+  } else {
+    key << "P" << static_cast<const void *>(leaf);
+  }
+  return key.str();
+}
+}  // namespace
+
+PolicySet::PolicySet(const std::vector<const ClaimValidator *> &policies) {
+  if (policies.size() > kMaxPolicies) {
+    throw std::logic_error("A policy set holds at most " +
+                           std::to_string(kMaxPolicies) + " policies");
+  }
+  for (auto policy : policies) {
+    roots_.push_back(Add(policy));
+  }
+  index_.clear();
+}
+
+uint32_t PolicySet::Add(const ClaimValidator *validator) {
+  const ClaimValidator *const *children;
+  size_t num_children;
+  ClaimValidator::Composition composition =
+      validator->Children(&children, &num_children);
+  if (composition == ClaimValidator::kWrapper) {
+    return Add(children[0]);
+  }
+
+  Node node = {kLeaf, validator, {}, ClaimPath(validator->property())};
+  std::ostringstream key;
+  switch (composition) {
+  case ClaimValidator::kAllOf:
+    node.kind = kAll;
+    break;
+  case ClaimValidator::kAnyOf:
+    node.kind = kAny;
+    break;
+  case ClaimValidator::kOptionalOf:
+    node.kind = kOptional;
+    break;
+  default:
+    break;
+  }
+
+  for (size_t i = 0; i < num_children; i++) {
+    node.children.push_back(Add(children[i]));
+  }
+  if (node.kind == kLeaf) {
+    key << LeafKey(validator);
+  } else {
+    key << node.kind << validator->property() << "(";
+    for (auto child : node.children) {
+      key << child << ",";
+    }
+    key << ")";
+  }
+  return Intern(key.str(), node);
+}
+
+uint32_t PolicySet::Intern(const std::string &key, const Node &node) {
+  auto found = index_.find(key);
+  if (found != index_.end()) {
+    return found->second;
+  }
+  nodes_.push_back(node);
+  index_[key] = nodes_.size() - 1;
+  return nodes_.size() - 1;
+}
+
+uint64_t PolicySet::Evaluate(const json &claimset) const {
+  uint8_t inline_results[kInlineResults] = {kUnknown};
+  std::unique_ptr<uint8_t[]> heap_results;
+  uint8_t *results = inline_results;
+  if (nodes_.size() > kInlineResults) {
+    heap_results.reset(new uint8_t[nodes_.size()]());
+    results = heap_results.get();
+  }
+
+  uint64_t mask = 0;
+  for (size_t i = 0; i < roots_.size(); i++) {
+    if (Eval(roots_[i], claimset, results)) {
+      mask |= static_cast<uint64_t>(1) << i;
+    }
+  }
+  return mask;
+}
+
+bool PolicySet::Eval(uint32_t index, const json &claimset,
+                     uint8_t *results) const {
+  if (results[index] != kUnknown) {
+    return results[index] == kAccepted;
+  }
+
+  const Node &node = nodes_[index];
+  bool accepted = false;
+  switch (node.kind) {
+  case kLeaf:
+    accepted = node.leaf->Check(claimset).valid();
+    break;
+  case kAll:
+    accepted = true;
+    for (auto child : node.children) {
+      if (!Eval(child, claimset, results)) {
+        accepted = false;
+        break;
+      }
+    }
+    break;
+  case kAny:
+    for (auto child : node.children) {
+      if (Eval(child, claimset, results)) {
+        accepted = true;
+        break;
+      }
+    }
+    break;
+  case kOptional:
+    accepted = !node.path.Find(claimset) ||
+               Eval(node.children[0], claimset, results);
+    break;
+  }
+  results[index] = accepted ? kAccepted : kRejected;
+  return accepted;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/precheck.h"
+
+Precheck::Precheck(const ClaimValidator *validator,
+                   const DecodeLimits &limits)
+    : limits_(limits) {
+  if (validator) {
+    Select(validator);
+  }
+}
+
+void Precheck::Select(const ClaimValidator *validator) {
+  const ClaimValidator *const *children;
+  size_t num_children;
+  ClaimValidator::Composition composition =
+      validator->Children(&children, &num_children);
+  if (composition == ClaimValidator::kWrapper) {
+    Select(children[0]);
+  } else if (validator->cost() == ClaimValidator::kCheap) {
+    checks_.push_back(validator);
+  } else if (composition == ClaimValidator::kAllOf) {
+    for (size_t i = 0; i < num_children; i++) {
+      Select(children[i]);
+    }
+  }
+}
+
+void Precheck::CheckClaims(const json &payload) const {
+  for (auto check : checks_) {
+    check->Check(payload).ThrowIfInvalid();
+  }
+}
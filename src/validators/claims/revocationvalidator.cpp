@@ -0,0 +1,286 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/revocationvalidator.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "private/filewatcher.h"
+#include "private/hash.h"
+#include "private/mappedfile.h"
+
+// The revocation file:
+//
+// header:  "JWTR" | u32 version | u64 number of blocks | u64 number of values
+// filter:  (64 byte bloom filter block)*
+// index:   (u64 hash | u64 offset of the value)*, sorted by hash
+// values:  (u32 claim length | u32 value length | claim | value)*
+//
+// The hash of a value is the FNV-1a hash of claim | '\0' | value. Its upper
+// half selects a block of the filter, and kProbes bits in that block are
+// derived from the remainder.
+namespace {
+const char kMagic[] = {'J', 'W', 'T', 'R'};
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 24;
+const size_t kBlockSize = 64;
+const size_t kIndexSize = 16;
+const size_t kValueHeaderSize = 8;
+const size_t kBitsPerValue = 12;
+const int kProbes = 6;
+
+uint64_t Prefix(const std::string &claim) {
+  const char separator = 0;
+  return Fnv1a(&separator, 1, Fnv1a(claim.data(), claim.size()));
+}
+
+uint64_t Block(uint64_t hash, uint64_t num_blocks) {
+  return (hash >> 32) & (num_blocks - 1);
+}
+
+// The bit in the block for the given probe.
+uint32_t Bit(uint64_t hash, int probe) {
+  uint64_t mixed = hash * 0x9E3779B97F4A7C15ULL;
+  return (mixed >> (10 + 9 * probe)) & (kBlockSize * 8 - 1);
+}
+}  // namespace
+
+class RevocationValidator::Revocations {
+public:
+  explicit Revocations(const std::string &path) : file_(new MappedFile(path)) {
+    const uint8_t *data = file_->data();
+    size_t size = file_->size();
+    if (size < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+        ReadU32(data + 4) != kVersion) {
+      throw std::logic_error("Not a revocation file: " + path);
+    }
+
+    num_blocks_ = ReadU64(data + 8);
+    num_values_ = ReadU64(data + 16);
+    if (num_blocks_ == 0 || (num_blocks_ & (num_blocks_ - 1)) != 0 ||
+        num_blocks_ > (size - kHeaderSize) / kBlockSize ||
+        num_values_ >
+            (size - kHeaderSize - num_blocks_ * kBlockSize) / kIndexSize) {
+      throw std::logic_error("Corrupt revocation file: " + path);
+    }
+    filter_ = data + kHeaderSize;
+    index_ = filter_ + num_blocks_ * kBlockSize;
+  }
+
+  bool Contains(uint64_t prefix, const std::string &claim,
+                const std::string &value) const {
+    uint64_t hash = Fnv1a(value.data(), value.size(), prefix);
+    const uint8_t *block = filter_ + Block(hash, num_blocks_) * kBlockSize;
+    for (int probe = 0; probe < kProbes; probe++) {
+      uint32_t bit = Bit(hash, probe);
+      if (!(block[bit >> 3] & (1 << (bit & 7)))) {
+        return false;
+      }
+    }
+
+    // Possibly revoked, find the first index entry with this hash.
+    uint64_t low = 0, high = num_values_;
+    while (low < high) {
+      uint64_t mid = low + (high - low) / 2;
+      if (ReadU64(index_ + mid * kIndexSize) < hash) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    for (; low < num_values_ && ReadU64(index_ + low * kIndexSize) == hash;
+         low++) {
+      if (Matches(ReadU64(index_ + low * kIndexSize + 8), claim, value)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  uint64_t size() const { return num_values_; }
+
+private:
+  bool Matches(uint64_t offset, const std::string &claim,
+               const std::string &value) const {
+    size_t size = file_->size();
+    if (offset > size || size - offset < kValueHeaderSize) {
+      return false;
+    }
+    const uint8_t *entry = file_->data() + offset;
+    uint64_t num_claim = ReadU32(entry);
+    uint64_t num_value = ReadU32(entry + 4);
+    if (size - offset - kValueHeaderSize < num_claim + num_value ||
+        num_claim != claim.size() || num_value != value.size()) {
+      return false;
+    }
+    entry += kValueHeaderSize;
+    return memcmp(entry, claim.data(), num_claim) == 0 &&
+           memcmp(entry + num_claim, value.data(), num_value) == 0;
+  }
+
+  std::unique_ptr<MappedFile> file_;
+  uint64_t num_blocks_;
+  uint64_t num_values_;
+  const uint8_t *filter_;
+  const uint8_t *index_;
+};
+
+RevocationValidator::RevocationValidator(const std::string &path,
+                                         const std::vector<std::string> &claims,
+                                         bool watch)
+    : ClaimValidator(""),
+      path_(path),
+      claims_(claims),
+      revocations_(new Revocations(path)) {
+  for (auto &claim : claims_) {
+    paths_.push_back(ClaimPath(claim));
+    prefixes_.push_back(Prefix(claim));
+  }
+  if (watch) {
+    watcher_.reset(new FileWatcher());
+    watcher_->Watch(path_, [this]() { Reload(); });
+  }
+}
+
+RevocationValidator::~RevocationValidator() {
+  // Stop the watcher first, it reloads into this validator.
+  watcher_.reset();
+}
+
+bool RevocationValidator::Reload() {
+  std::shared_ptr<const Revocations> revocations;
+  try {
+    revocations.reset(new Revocations(path_));
+  } catch (std::exception &) {
+    return false;
+  }
+  std::atomic_store(&revocations_, revocations);
+  return true;
+}
+
+size_t RevocationValidator::size() const {
+  return std::atomic_load(&revocations_)->size();
+}
+
+bool RevocationValidator::IsValid(const json &claimset) const {
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus RevocationValidator::Check(const json &claimset) const {
+  std::shared_ptr<const Revocations> revocations =
+      std::atomic_load(&revocations_);
+  for (size_t i = 0; i < claims_.size(); i++) {
+    const json *value = paths_[i].Find(claimset);
+    if (value && value->is_string() &&
+        revocations->Contains(prefixes_[i], claims_[i],
+                              value->get_ref<const std::string &>())) {
+      return ClaimStatus(ClaimStatus::kInvalid, &claims_[i]);
+    }
+  }
+  return ClaimStatus();
+}
+
+bool RevocationValidator::ListClaims(std::vector<std::string> *claims) const {
+  for (auto &path : paths_) {
+    claims->push_back(path.head());
+  }
+  return true;
+}
+
+std::string RevocationValidator::toJson() const {
+  json revoked = {{"file", path_}, {"claims", claims_}};
+  if (!watcher_) {
+    revoked["watch"] = false;
+  }
+  return json({{"revoked", revoked}}).dump();
+}
+
+void RevocationWriter::Add(const std::string &claim, const std::string &value) {
+  revoked_.insert(std::make_pair(claim, value));
+}
+
+void RevocationWriter::Write(const std::string &path) const {
+  uint64_t num_blocks = 1;
+  while (num_blocks * kBlockSize * 8 < revoked_.size() * kBitsPerValue) {
+    num_blocks <<= 1;
+  }
+
+  std::vector<std::pair<uint64_t, const std::pair<std::string, std::string> *>>
+      hashed;
+  for (auto &revoked : revoked_) {
+    const std::string &value = revoked.second;
+    hashed.push_back(std::make_pair(
+        Fnv1a(value.data(), value.size(), Prefix(revoked.first)), &revoked));
+  }
+  std::sort(hashed.begin(), hashed.end());
+
+  std::string filter(num_blocks * kBlockSize, 0);
+  std::string index;
+  std::string values;
+  uint64_t offset =
+      kHeaderSize + num_blocks * kBlockSize + hashed.size() * kIndexSize;
+  for (auto &entry : hashed) {
+    uint64_t hash = entry.first;
+    size_t block = Block(hash, num_blocks) * kBlockSize;
+    for (int probe = 0; probe < kProbes; probe++) {
+      uint32_t bit = Bit(hash, probe);
+      filter[block + (bit >> 3)] |= static_cast<char>(1 << (bit & 7));
+    }
+
+    WriteU64(&index, hash);
+    WriteU64(&index, offset + values.size());
+    const std::string &claim = entry.second->first;
+    const std::string &value = entry.second->second;
+    WriteU32(&values, static_cast<uint32_t>(claim.size()));
+    WriteU32(&values, static_cast<uint32_t>(value.size()));
+    values += claim;
+    values += value;
+  }
+
+  std::string file(kMagic, sizeof(kMagic));
+  WriteU32(&file, kVersion);
+  WriteU64(&file, num_blocks);
+  WriteU64(&file, hashed.size());
+  file += filter;
+  file += index;
+  file += values;
+
+  std::string temp = path + ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary);
+    out.write(file.data(), file.size());
+    if (!out) {
+      throw std::logic_error("Unable to write revocation file: " + temp);
+    }
+  }
+#ifdef _WIN32
+  // Windows does not replace existing files on rename.
+  remove(path.c_str());
+#endif
+  if (rename(temp.c_str(), path.c_str()) != 0) {
+    remove(temp.c_str());
+    throw std::logic_error("Unable to write revocation file: " + path);
+  }
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/scopevalidator.h"
+#include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "private/stringset.h"
+
+namespace {
+std::vector<std::string> Concat(const std::vector<std::string> &a,
+                                const std::vector<std::string> &b) {
+  std::vector<std::string> result(a);
+  result.insert(result.end(), b.begin(), b.end());
+  return result;
+}
+}  // namespace
+
+ScopeValidator::ScopeValidator(const std::string &property,
+                               const std::vector<std::string> &required,
+                               const std::vector<std::string> &any_of)
+    : ClaimValidator(property),
+      required_(required),
+      any_of_(any_of),
+      scopes_(new StringSet(Concat(required, any_of))) {
+  size_t words = (scopes_->size() + 63) / 64;
+  required_mask_.assign(words, 0);
+  any_mask_.assign(words, 0);
+  for (auto &scope : required_) {
+    int64_t bit = scopes_->Find(scope);
+    required_mask_[bit / 64] |= 1ULL << (bit % 64);
+  }
+  for (auto &scope : any_of_) {
+    int64_t bit = scopes_->Find(scope);
+    any_mask_[bit / 64] |= 1ULL << (bit % 64);
+  }
+}
+
+ScopeValidator::~ScopeValidator() {}
+
+void ScopeValidator::Set(const char *scope, size_t len,
+                         uint64_t *granted) const {
+  int64_t bit = scopes_->Find(scope, len);
+  if (bit >= 0) {
+    granted[bit / 64] |= 1ULL << (bit % 64);
+  }
+}
+
+bool ScopeValidator::IsValid(const json &claimset) const {
+  return Check(claimset).ThrowIfInvalid();
+}
+
+ClaimStatus ScopeValidator::Check(const json &claimset) const {
+  const json *claim = Find(claimset);
+  if (!claim) {
+    return ClaimStatus(ClaimStatus::kMissing, &property_);
+  }
+  if (!claim->is_string() && !claim->is_array()) {
+    return ClaimStatus(ClaimStatus::kWrongType, &property_, claim);
+  }
+
+  size_t words = required_mask_.size();
+  uint64_t inline_granted[kInlineWords] = {0};
+  std::unique_ptr<uint64_t[]> heap_granted;
+  uint64_t *granted = inline_granted;
+  if (words > kInlineWords) {
+    heap_granted.reset(new uint64_t[words]());
+    granted = heap_granted.get();
+  }
+
+  if (claim->is_string()) {
+    const std::string &scopes = claim->get_ref<const std::string &>();
+    const char *str = scopes.data();
+    const char *end = str + scopes.size();
+    while (str < end) {
+      const char *space =
+          static_cast<const char *>(memchr(str, ' ', end - str));
+      if (!space) {
+        space = end;
+      }
+      if (space != str) {
+        Set(str, space - str, granted);
+      }
+      str = space + 1;
+    }
+  } else {
+    for (const auto &scope : *claim) {
+      if (scope.is_string()) {
+        const std::string &str = scope.get_ref<const std::string &>();
+        Set(str.data(), str.size(), granted);
+      }
+    }
+  }
+
+  bool any = any_of_.empty();
+  for (size_t i = 0; i < words; i++) {
+    if ((granted[i] & required_mask_[i]) != required_mask_[i]) {
+      return ClaimStatus(ClaimStatus::kInvalid, &property_);
+    }
+    any |= (granted[i] & any_mask_[i]) != 0;
+  }
+  return any ? ClaimStatus() : ClaimStatus(ClaimStatus::kInvalid, &property_);
+}
+
+std::string ScopeValidator::toJson() const {
+  json scope = {{"claim", property_}, {"required", required_}};
+  if (!any_of_.empty()) {
+    scope["any"] = any_of_;
+  }
+  return json({{"scope", scope}}).dump();
+}
@@ -27,6 +27,12 @@
 #include <string>
 
 UtcClock TimeValidator::utc_clock_ = UtcClock();
+CoarseClock TimeValidator::coarse_clock_ = CoarseClock();
+
+IClock *TimeValidator::utc_clock() { return &utc_clock_; }
+IClock *TimeValidator::coarse_clock() { return &coarse_clock_; }
+uint64_t TimeValidator::Now(IClock *clock) { return clock->Now(); }
+
 TimeValidator::TimeValidator(const char *key, bool sign, uint64_t leeway)
     : TimeValidator(key, sign, leeway, &utc_clock_) {}
 TimeValidator::TimeValidator(const char *key, bool sign)
@@ -36,36 +42,58 @@ TimeValidator::TimeValidator(const char *key, bool sign, uint64_t leeway,
     : ClaimValidator(key), sign_(sign), leeway_(leeway), clock_(clock) {}
 
 bool TimeValidator::IsValid(const json &claim) const {
-  if (!claim.count(property_) || !claim[property_].is_number()) {
-    throw InvalidClaimError(std::string("Missing claim: ") += property_);
-  }
+  return Check(claim).ThrowIfInvalid();
+}
 
-  int64_t time = claim[property_].get<int64_t>();
-  if (time < 0) {
-    throw InvalidClaimError(std::string("Negative time for: ") += property_);
-  }
+ClaimStatus TimeValidator::Check(const json &claim) const {
+  return CheckClaim(Find(claim));
+}
 
-  int64_t diff = clock_->Now() - time;
-  int64_t min = diff - leeway_;
-  int64_t max = diff + leeway_;
+ClaimStatus TimeValidator::CheckClaim(const json *object) const {
+  return AcceptsClaim(object) ? ClaimStatus() : Failure(object);
+}
 
-  if (sign_) {
-    if (!(min >= 0 || max >= 0)) {
-      throw InvalidClaimError(std::string("Failed: ") += property_);
-    }
-    return true;
+ClaimStatus TimeValidator::Failure(const json *object) const {
+  if (!object) {
+    return ClaimStatus(ClaimStatus::kMissing, &property_, nullptr,
+                       ClaimStatus::kTime);
   }
-  if (!(min <= 0 || max <= 0)) {
-    throw InvalidClaimError(std::string("Failed: ") += property_);
+  if (!object->is_number()) {
+    return ClaimStatus(ClaimStatus::kWrongType, &property_, object,
+                       ClaimStatus::kTime);
   }
+  if (object->get<int64_t>() < 0) {
+    return ClaimStatus(ClaimStatus::kNegative, &property_, nullptr,
+                       ClaimStatus::kTime);
+  }
+  return ClaimStatus(ClaimStatus::kInvalid, &property_, nullptr,
+                     ClaimStatus::kTime);
+}
+
+ClaimStatus TimeValidator::CheckTime(int64_t time) const {
+  if (time < 0) {
+    return ClaimStatus(ClaimStatus::kNegative, &property_, nullptr,
+                       ClaimStatus::kTime);
+  }
+  if (!Accepts(time, clock_->Now(), sign_, leeway_)) {
+    return ClaimStatus(ClaimStatus::kInvalid, &property_, nullptr,
+                       ClaimStatus::kTime);
+  }
+  return ClaimStatus();
+}
 
-  return true;
+bool TimeValidator::AcceptsClaim(const json *object) const {
+  return object && object->is_number() &&
+         Accepts(object->get<int64_t>(), clock_->Now(), sign_, leeway_);
 }
 
 std::string TimeValidator::toJson() const {
   std::ostringstream msg;
   msg << "{ \"" << property() << "\" : ";
-  if (leeway_ == 0) {
+  if (clock_ == &coarse_clock_) {
+    msg << "{ \"leeway\" : " << std::to_string(leeway_)
+        << ", \"clock\" : \"coarse\" }";
+  } else if (leeway_ == 0) {
     msg << "null";
   } else {
     msg << "{ \"leeway\" : " << std::to_string(leeway_) << " }";
@@ -0,0 +1,166 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/derivedkeyvalidator.h"
+#include <openssl/hmac.h>
+#include <sstream>
+#include <string>
+#include "jwt/hmacvalidator.h"
+#include "private/lrucache.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+std::string Hmac(const std::string &key, const std::string &data) {
+    unsigned char out[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+         reinterpret_cast<const unsigned char *>(data.data()), data.size(),
+         out, &len);
+    return std::string(reinterpret_cast<char *>(out), len);
+}
+
+bool Glob(const char *pattern, const char *pattern_end, const char *str,
+          const char *str_end) {
+    // Iterative glob matching, backtracking to the last star.
+    const char *star = nullptr, *star_str = nullptr;
+    while (str != str_end) {
+        if (pattern != pattern_end && (*pattern == '?' || *pattern == *str)) {
+            pattern++;
+            str++;
+        } else if (pattern != pattern_end && *pattern == '*') {
+            star = pattern++;
+            star_str = str;
+        } else if (star != nullptr) {
+            pattern = star + 1;
+            str = ++star_str;
+        } else {
+            return false;
+        }
+    }
+    while (pattern != pattern_end && *pattern == '*') {
+        pattern++;
+    }
+    return pattern == pattern_end;
+}
+
+}  // namespace
+
+DerivedKeyValidator::DerivedKeyValidator(const std::string &algorithm,
+                                         const std::string &master,
+                                         const std::string &pattern,
+                                         size_t cache_size,
+                                         const std::string &salt)
+    : algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)),
+      md_(nullptr),
+      master_(master),
+      pattern_(pattern),
+      salt_(salt),
+      cache_(new LruCache<std::string, MessageValidator>(cache_size)) {
+    if (algorithm == "HS256") {
+        md_ = EVP_sha256();
+    } else if (algorithm == "HS384") {
+        md_ = EVP_sha384();
+    } else if (algorithm == "HS512") {
+        md_ = EVP_sha512();
+    } else {
+        throw std::logic_error("Unsupported derived key algorithm: " +
+                               algorithm);
+    }
+
+    // HKDF-Extract, an empty salt is a string of zeros of the hash length.
+    prk_ = Hmac(salt.empty() ? std::string(32, '\0') : salt, master);
+}
+
+DerivedKeyValidator::~DerivedKeyValidator() {}
+
+std::string DerivedKeyValidator::DeriveKey(const std::string &kid) const {
+    // HKDF-Expand, T(i) = HMAC(PRK, T(i - 1) | info | i)
+    size_t length = EVP_MD_size(md_);
+    std::string okm, block;
+    for (char i = 1; okm.size() < length; i++) {
+        block = Hmac(prk_, block + kid + i);
+        okm += block;
+    }
+    okm.resize(length);
+    return okm;
+}
+
+bool DerivedKeyValidator::Matches(const std::string &kid) const {
+    return Glob(pattern_.data(), pattern_.data() + pattern_.size(),
+                kid.data(), kid.data() + kid.size());
+}
+
+HMACValidator *DerivedKeyValidator::NewValidator(
+    const std::string &key) const {
+    return new HMACValidator(algorithm_, md_, key);
+}
+
+const std::string *DerivedKeyValidator::Kid(const json &jose) const {
+    if (!jose.is_object()) {
+        return nullptr;
+    }
+    auto kid = jose.find("kid");
+    if (kid == jose.end() || !kid->is_string() ||
+        !Matches(kid->get_ref<const std::string &>())) {
+        return nullptr;
+    }
+    return &kid->get_ref<const std::string &>();
+}
+
+bool DerivedKeyValidator::Verify(const json &jose, const uint8_t *header,
+                                 size_t num_header, const uint8_t *signature,
+                                 size_t num_signature) const {
+    const std::string *kid = Kid(jose);
+    if (kid == nullptr) {
+        return false;
+    }
+
+    std::shared_ptr<MessageValidator> validator = cache_->Get(*kid);
+    if (!validator) {
+        validator = cache_->Put(
+            *kid, std::shared_ptr<MessageValidator>(
+                      NewValidator(DeriveKey(*kid))));
+    }
+    return validator->Verify(jose, header, num_header, signature,
+                             num_signature);
+}
+
+bool DerivedKeyValidator::Accepts(const json &jose) const {
+    return Kid(jose) != nullptr && MessageValidator::Accepts(jose);
+}
+
+size_t DerivedKeyValidator::cache_size() const { return cache_->size(); }
+
+std::string DerivedKeyValidator::toJson() const {
+    std::ostringstream msg;
+    msg << "{ \"derived\" : { \"alg\" : \"" << algorithm_
+        << "\", \"secret\" : " << json(master_) << ", \"kid\" : "
+        << json(pattern_);
+    if (!salt_.empty()) {
+        msg << ", \"salt\" : " << json(salt_);
+    }
+    msg << ", \"cache\" : " << cache_->capacity() << " } }";
+    return msg.str();
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/ecdsavalidator.h"
+#include <memory>
+#include <string>
+#include "private/pemkey.h"
+#include "private/ssl_compat.h"
+
+namespace {
+// The curve size each algorithm signs with, a key on another curve would
+// accept signatures of another size.
+int CurveBits(Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::ES256:
+            return 256;
+        case Algorithm::ES384:
+            return 384;
+        case Algorithm::ES512:
+            return 521;
+        default:
+            return 0;
+    }
+}
+}  // namespace
+
+ECDSAValidator::ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                               const std::string &key)
+    : algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)),
+      private_key_(NULL), public_key_(NULL), md_(md),
+      num_component_(0) {
+    public_key_ = PemKey::Load(key.c_str(), true);
+    if (public_key_ == NULL || EVP_PKEY_base_id(public_key_) != EVP_PKEY_EC) {
+        EVP_PKEY_free(public_key_);
+        throw InvalidValidatorError(algorithm + " requires an EC public key");
+    }
+    if (EVP_PKEY_bits(public_key_) != CurveBits(algorithm_id_)) {
+        EVP_PKEY_free(public_key_);
+        throw InvalidValidatorError(algorithm + " does not match the key curve");
+    }
+    num_component_ = (EVP_PKEY_bits(public_key_) + 7) / 8;
+}
+
+ECDSAValidator::ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                               const std::string &key,
+                               const std::string &private_key)
+    : ECDSAValidator(algorithm, md, key) {
+    private_key_ = PemKey::Load(private_key.c_str(), false);
+}
+
+ECDSAValidator::ECDSAValidator(const std::string &algorithm, const EVP_MD *md,
+                               EVP_PKEY *public_key)
+    : algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)),
+      private_key_(NULL), public_key_(public_key),
+      md_(md), num_component_((EVP_PKEY_bits(public_key) + 7) / 8) {
+    if (EVP_PKEY_base_id(public_key_) != EVP_PKEY_EC ||
+        EVP_PKEY_bits(public_key_) != CurveBits(algorithm_id_)) {
+        throw InvalidValidatorError(algorithm + " does not match the key curve");
+    }
+    EVP_PKEY_up_ref(public_key_);
+}
+
+ECDSAValidator::~ECDSAValidator() {
+    EVP_PKEY_free(public_key_);
+    EVP_PKEY_free(private_key_);
+}
+
+bool ECDSAValidator::Verify(const json &jsonHeader, const uint8_t *header,
+                            size_t num_header, const uint8_t *signature,
+                            size_t num_signature) const {
+    if (signature == nullptr || num_signature != 2 * num_component_) {
+        return false;
+    }
+
+    ECDSA_SIG *sig = ECDSA_SIG_new();
+    ECDSA_SIG_set0(sig, BN_bin2bn(signature, num_component_, NULL),
+                   BN_bin2bn(signature + num_component_, num_component_, NULL));
+    int num_der = i2d_ECDSA_SIG(sig, NULL);
+    std::unique_ptr<uint8_t[]> der(new uint8_t[num_der > 0 ? num_der : 1]);
+    uint8_t *der_end = der.get();
+    num_der = i2d_ECDSA_SIG(sig, &der_end);
+    ECDSA_SIG_free(sig);
+    if (num_der <= 0) {
+        return false;
+    }
+
+    EvpMdCtx ctx;
+    EVP_MD_CTX *evp_md_ctx = ctx.get();
+    EVP_VerifyInit_ex(evp_md_ctx, md_, NULL);
+    return EVP_VerifyUpdate(evp_md_ctx, header, num_header) == 1 &&
+           EVP_VerifyFinal(evp_md_ctx, der.get(), num_der, public_key_) == 1;
+}
+
+bool ECDSAValidator::Sign(const uint8_t *header, size_t num_header,
+                          uint8_t *signature, size_t *num_signature) const {
+    size_t needed = 2 * num_component_;
+    if (signature == NULL || *num_signature < needed) {
+        *num_signature = needed;
+        return false;
+    }
+
+    EvpMdCtx ctx;
+    EVP_MD_CTX *evp_md_ctx = ctx.get();
+    size_t num_der = 0;
+    if (private_key_ == NULL ||
+        EVP_DigestSignInit(evp_md_ctx, NULL, md_, NULL, private_key_) != 1 ||
+        EVP_DigestSignUpdate(evp_md_ctx, header, num_header) != 1 ||
+        EVP_DigestSignFinal(evp_md_ctx, NULL, &num_der) != 1) {
+        return false;
+    }
+
+    std::unique_ptr<uint8_t[]> der(new uint8_t[num_der]);
+    if (EVP_DigestSignFinal(evp_md_ctx, der.get(), &num_der) != 1) {
+        return false;
+    }
+
+    const uint8_t *der_start = der.get();
+    ECDSA_SIG *sig = d2i_ECDSA_SIG(NULL, &der_start, num_der);
+    if (sig == NULL) {
+        return false;
+    }
+
+    // R and S are written big endian, left padded with zeros.
+    const BIGNUM *r, *s;
+    ECDSA_SIG_get0(sig, &r, &s);
+    memset(signature, 0, needed);
+    BN_bn2bin(r, signature + num_component_ - BN_num_bytes(r));
+    BN_bn2bin(s, signature + needed - BN_num_bytes(s));
+    ECDSA_SIG_free(sig);
+
+    *num_signature = needed;
+    return true;
+}
+
+std::string ECDSAValidator::toJson() const {
+    return PemKey::ToJson(algorithm(), public_key_, private_key_);
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/eddsavalidator.h"
+#include <string>
+#include "private/pemkey.h"
+#include "private/ssl_compat.h"
+
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+#define HAS_EDDSA 1
+#endif
+
+EdDSAValidator::EdDSAValidator(const std::string &key)
+    : private_key_(NULL), public_key_(NULL) {
+#ifndef HAS_EDDSA
+    throw InvalidValidatorError("EdDSA requires openssl 1.1.1 or later");
+#else
+    public_key_ = PemKey::Load(key.c_str(), true);
+    if (public_key_ == NULL ||
+        (EVP_PKEY_base_id(public_key_) != EVP_PKEY_ED25519 &&
+         EVP_PKEY_base_id(public_key_) != EVP_PKEY_ED448)) {
+        EVP_PKEY_free(public_key_);
+        throw InvalidValidatorError("EdDSA requires an Ed25519 or Ed448 key");
+    }
+#endif
+}
+
+EdDSAValidator::EdDSAValidator(const std::string &key,
+                               const std::string &private_key)
+    : EdDSAValidator(key) {
+    private_key_ = PemKey::Load(private_key.c_str(), false);
+}
+
+EdDSAValidator::EdDSAValidator(EVP_PKEY *public_key)
+    : private_key_(NULL), public_key_(public_key) {
+    EVP_PKEY_up_ref(public_key_);
+}
+
+EdDSAValidator::~EdDSAValidator() {
+    EVP_PKEY_free(public_key_);
+    EVP_PKEY_free(private_key_);
+}
+
+bool EdDSAValidator::Verify(const json &jsonHeader, const uint8_t *header,
+                            size_t num_header, const uint8_t *signature,
+                            size_t num_signature) const {
+#ifdef HAS_EDDSA
+    // EdDSA signs the message itself, so there is no separate digest.
+    EvpMdCtx ctx;
+    EVP_MD_CTX *evp_md_ctx = ctx.get();
+    return signature != nullptr &&
+           EVP_DigestVerifyInit(evp_md_ctx, NULL, NULL, NULL, public_key_) ==
+               1 &&
+           EVP_DigestVerify(evp_md_ctx, signature, num_signature, header,
+                            num_header) == 1;
+#else
+    return false;
+#endif
+}
+
+bool EdDSAValidator::Sign(const uint8_t *header, size_t num_header,
+                          uint8_t *signature, size_t *num_signature) const {
+#ifdef HAS_EDDSA
+    size_t needed = 0;
+    EvpMdCtx ctx;
+    EVP_MD_CTX *evp_md_ctx = ctx.get();
+    if (private_key_ == NULL ||
+        EVP_DigestSignInit(evp_md_ctx, NULL, NULL, NULL, private_key_) != 1 ||
+        EVP_DigestSign(evp_md_ctx, NULL, &needed, header, num_header) != 1) {
+        return false;
+    }
+
+    // We need more bytes please!
+    if (signature == NULL || *num_signature < needed) {
+        *num_signature = needed;
+        return false;
+    }
+
+    return EVP_DigestSign(evp_md_ctx, signature, num_signature, header,
+                          num_header) == 1;
+#else
+    return false;
+#endif
+}
+
+std::string EdDSAValidator::toJson() const {
+    return PemKey::ToJson(algorithm(), public_key_, private_key_);
+}
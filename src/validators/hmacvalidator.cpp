@@ -29,7 +29,9 @@
 
 HMACValidator::HMACValidator(const std::string &algorithm, const EVP_MD *md,
                              const std::string &key)
-    : md_(md), algorithm_(algorithm), key_size_(EVP_MD_size(md)), key_(key) {}
+    : md_(md), algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)), key_size_(EVP_MD_size(md)),
+      key_(key) {}
 
 HMACValidator::~HMACValidator() {}
 
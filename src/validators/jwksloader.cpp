@@ -0,0 +1,336 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/jwksloader.h"
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "jwt/ecdsavalidator.h"
+#include "jwt/eddsavalidator.h"
+#include "jwt/hmacvalidator.h"
+#include "jwt/rsavalidator.h"
+#include "private/base64.h"
+#include "private/ssl_compat.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+const json &Member(const json &jwk, const char *name) {
+    auto member = jwk.find(name);
+    if (member == jwk.end() || !member->is_string()) {
+        throw InvalidValidatorError(std::string("jwk is missing: ") + name);
+    }
+    return *member;
+}
+
+std::string DecodeMember(const json &jwk, const char *name) {
+    std::string decoded =
+        Base64Encode::DecodeUrl(Member(jwk, name).get<std::string>());
+    if (decoded.empty()) {
+        throw InvalidValidatorError(std::string("jwk has invalid base64: ") +
+                                    name);
+    }
+    return decoded;
+}
+
+typedef std::unique_ptr<BIGNUM, void (*)(BIGNUM *)> bignum_ptr;
+
+bignum_ptr DecodeNumber(const json &jwk, const char *name) {
+    std::string bytes = DecodeMember(jwk, name);
+    bignum_ptr number(
+        BN_bin2bn(reinterpret_cast<const uint8_t *>(bytes.data()),
+                  bytes.size(), NULL),
+        BN_free);
+    if (!number) {
+        throw InvalidValidatorError(std::string("jwk has invalid number: ") +
+                                    name);
+    }
+    return number;
+}
+
+EVP_PKEY *RsaKey(const json &jwk) {
+    bignum_ptr n = DecodeNumber(jwk, "n");
+    bignum_ptr e = DecodeNumber(jwk, "e");
+    EVP_PKEY *pkey = NewRsaPublicKey(n.get(), e.get());
+    if (pkey == NULL) {
+        throw InvalidValidatorError("Invalid RSA key");
+    }
+    return pkey;
+}
+
+EVP_PKEY *EcKey(const json &jwk) {
+    const std::string &crv = Member(jwk, "crv").get_ref<const std::string &>();
+    int nid = NID_undef;
+    if (crv == "P-256") {
+        nid = NID_X9_62_prime256v1;
+    } else if (crv == "P-384") {
+        nid = NID_secp384r1;
+    } else if (crv == "P-521") {
+        nid = NID_secp521r1;
+    } else {
+        throw InvalidValidatorError("Unsupported EC curve: " + crv);
+    }
+
+    bignum_ptr x = DecodeNumber(jwk, "x");
+    bignum_ptr y = DecodeNumber(jwk, "y");
+    EVP_PKEY *pkey = NewEcPublicKey(nid, x.get(), y.get());
+    if (pkey == NULL) {
+        throw InvalidValidatorError("EC point is not on curve " + crv);
+    }
+    return pkey;
+}
+
+EVP_PKEY *OkpKey(const json &jwk) {
+    const std::string &crv = Member(jwk, "crv").get_ref<const std::string &>();
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    int type = EVP_PKEY_NONE;
+    if (crv == "Ed25519") {
+        type = EVP_PKEY_ED25519;
+    } else if (crv == "Ed448") {
+        type = EVP_PKEY_ED448;
+    } else {
+        throw InvalidValidatorError("Unsupported OKP curve: " + crv);
+    }
+
+    std::string x = DecodeMember(jwk, "x");
+    EVP_PKEY *pkey = EVP_PKEY_new_raw_public_key(
+        type, NULL, reinterpret_cast<const uint8_t *>(x.data()), x.size());
+    if (pkey == NULL) {
+        throw InvalidValidatorError("Invalid OKP key for curve " + crv);
+    }
+    return pkey;
+#else
+    throw InvalidValidatorError("OKP keys require openssl 1.1.1 or later");
+#endif
+}
+
+std::string DefaultAlgorithm(const std::string &kty, const json &jwk) {
+    if (kty == "RSA") return "RS256";
+    if (kty == "oct") return "HS256";
+    if (kty == "OKP") return "EdDSA";
+
+    const std::string &crv = Member(jwk, "crv").get_ref<const std::string &>();
+    if (crv == "P-384") return "ES384";
+    if (crv == "P-521") return "ES512";
+    return "ES256";
+}
+
+}  // namespace
+
+JwksLoader::JwksLoader() : materialized_(0) {}
+
+json JwksLoader::ReadFile(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw InvalidValidatorError("Unable to read jwks from: " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return json::parse(buffer.str());
+}
+
+KidValidator *JwksLoader::Load(const std::string &path) {
+    return Build(ReadFile(path));
+}
+
+KidValidator *JwksLoader::Build(const json &jwks) {
+    std::string first;
+    KidValidator::KidMap validators = BuildMap(jwks, &first);
+    return new KidValidator(validators, first);
+}
+
+void JwksLoader::Reload(const std::string &path, KidValidator *kid) {
+    Reload(ReadFile(path), kid);
+}
+
+void JwksLoader::Reload(const json &jwks, KidValidator *kid) {
+    std::string first;
+    KidValidator::KidMap validators = BuildMap(jwks, &first);
+    kid->Swap(validators, first);
+}
+
+std::string JwksLoader::Thumbprint(const json &jwk) {
+    const std::string &kty = Member(jwk, "kty").get_ref<const std::string &>();
+
+    // The required members in lexicographic order, without whitespace.
+    json required = {{"kty", kty}};
+    if (kty == "RSA") {
+        required["e"] = Member(jwk, "e");
+        required["n"] = Member(jwk, "n");
+    } else if (kty == "EC") {
+        required["crv"] = Member(jwk, "crv");
+        required["x"] = Member(jwk, "x");
+        required["y"] = Member(jwk, "y");
+    } else if (kty == "oct") {
+        required["k"] = Member(jwk, "k");
+    } else if (kty == "OKP") {
+        required["crv"] = Member(jwk, "crv");
+        required["x"] = Member(jwk, "x");
+    } else {
+        throw InvalidValidatorError("Unsupported key type: " + kty);
+    }
+
+    std::string canonical = required.dump();
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int num_digest = 0;
+    EVP_Digest(canonical.data(), canonical.size(), digest, &num_digest,
+               EVP_sha256(), NULL);
+    return Base64Encode::EncodeUrl(
+        std::string(reinterpret_cast<char *>(digest), num_digest));
+}
+
+KidValidator::KidMap JwksLoader::BuildMap(const json &jwks,
+                                          std::string *first) {
+    auto keys = jwks.find("keys");
+    if (keys == jwks.end() || !keys->is_array()) {
+        throw InvalidValidatorError("jwks does not contain a keys array");
+    }
+
+    KidValidator::KidMap validators;
+    PKeyCache used;
+    for (const json &jwk : *keys) {
+        if (!jwk.is_object()) {
+            throw InvalidValidatorError("jwk is not an object: " + jwk.dump());
+        }
+
+        auto use = jwk.find("use");
+        auto kty = jwk.find("kty");
+        if ((use != jwk.end() && *use != "sig") || kty == jwk.end() ||
+            (*kty != "RSA" && *kty != "EC" && *kty != "oct" &&
+             *kty != "OKP")) {
+            continue;
+        }
+
+        std::string thumbprint = Thumbprint(jwk);
+        std::shared_ptr<MessageValidator> validator =
+            BuildKey(jwk, thumbprint, &used);
+        if (!validator) {
+            continue;
+        }
+
+        auto kid = jwk.find("kid");
+        std::string id = kid != jwk.end() && kid->is_string()
+                             ? kid->get<std::string>()
+                             : thumbprint;
+        if (!validators.emplace(id, validator).second) {
+            throw InvalidValidatorError("Duplicate kid in jwks: " + id);
+        }
+        if (validators.size() == 1) {
+            *first = id;
+        }
+    }
+
+    // Only keep the keys that are still in use.
+    std::lock_guard<std::mutex> lock(lock_);
+    cache_.swap(used);
+    return validators;
+}
+
+std::shared_ptr<MessageValidator> JwksLoader::BuildKey(
+    const json &jwk, const std::string &thumbprint, PKeyCache *used) {
+    const std::string &kty = jwk["kty"].get_ref<const std::string &>();
+    auto alg_member = jwk.find("alg");
+    std::string alg = alg_member != jwk.end() && alg_member->is_string()
+                          ? alg_member->get<std::string>()
+                          : DefaultAlgorithm(kty, jwk);
+
+    if (kty == "oct") {
+        std::string secret = DecodeMember(jwk, "k");
+        if (alg == "HS256") {
+            return std::make_shared<HS256Validator>(secret);
+        } else if (alg == "HS384") {
+            return std::make_shared<HS384Validator>(secret);
+        } else if (alg == "HS512") {
+            return std::make_shared<HS512Validator>(secret);
+        }
+    } else if (kty == "RSA") {
+        if (alg == "RS256") {
+            return std::make_shared<RS256Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        } else if (alg == "RS384") {
+            return std::make_shared<RS384Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        } else if (alg == "RS512") {
+            return std::make_shared<RS512Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        }
+    } else if (kty == "EC") {
+        if (alg == "ES256") {
+            return std::make_shared<ES256Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        } else if (alg == "ES384") {
+            return std::make_shared<ES384Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        } else if (alg == "ES512") {
+            return std::make_shared<ES512Validator>(
+                Materialize(thumbprint, jwk, used).get());
+        }
+    } else if (kty == "OKP" && alg == "EdDSA") {
+        return std::make_shared<EdDSAValidator>(
+            Materialize(thumbprint, jwk, used).get());
+    }
+
+    // Not an algorithm we can verify with this key.
+    return nullptr;
+}
+
+JwksLoader::pkey_ptr JwksLoader::Materialize(const std::string &thumbprint,
+                                             const json &jwk,
+                                             PKeyCache *used) {
+    auto found = used->find(thumbprint);
+    if (found != used->end()) {
+        return found->second;
+    }
+
+    pkey_ptr pkey;
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        auto cached = cache_.find(thumbprint);
+        if (cached != cache_.end()) {
+            pkey = cached->second;
+        }
+    }
+
+    if (!pkey) {
+        const std::string &kty = jwk["kty"].get_ref<const std::string &>();
+        EVP_PKEY *key = kty == "RSA" ? RsaKey(jwk)
+                                     : kty == "EC" ? EcKey(jwk) : OkpKey(jwk);
+        pkey = pkey_ptr(key, EVP_PKEY_free);
+        std::lock_guard<std::mutex> lock(lock_);
+        materialized_++;
+    }
+
+    (*used)[thumbprint] = pkey;
+    return pkey;
+}
+
+size_t JwksLoader::cache_size() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cache_.size();
+}
+
+size_t JwksLoader::materialized() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return materialized_;
+}
@@ -0,0 +1,262 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/keystorevalidator.h"
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "jwt/hmacvalidator.h"
+#include "private/hash.h"
+#include "private/lrucache.h"
+#include "private/mappedfile.h"
+
+using json = nlohmann::json;
+
+// The key file is an open addressing hash table:
+//
+// header:  "JWTK" | u32 version | u64 number of buckets | u64 number of keys
+// buckets: (u64 hash of the kid | u64 offset of the key, 0 if empty)*
+// keys:    (u8 algorithm | u8 0 | u16 kid length | u32 secret length |
+//           kid | secret)*
+//
+// The number of buckets is a power of two, at least twice the number of keys.
+namespace {
+
+const char kMagic[] = {'J', 'W', 'T', 'K'};
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 24;
+const size_t kBucketSize = 16;
+const size_t kKeyHeaderSize = 8;
+const char *kAlgorithms[] = {nullptr, "HS256", "HS384", "HS512"};
+const Algorithm kAlgorithmIds[] = {Algorithm::UNKNOWN, Algorithm::HS256,
+                                   Algorithm::HS384, Algorithm::HS512};
+
+MessageValidator *NewValidator(uint8_t algorithm, const std::string &secret) {
+    switch (algorithm) {
+        case 1:
+            return new HS256Validator(secret);
+        case 2:
+            return new HS384Validator(secret);
+        default:
+            return new HS512Validator(secret);
+    }
+}
+
+const std::string *KidOf(const json &jose) {
+    if (!jose.is_object()) {
+        return nullptr;
+    }
+    auto kid = jose.find("kid");
+    if (kid == jose.end() || !kid->is_string()) {
+        return nullptr;
+    }
+    return &kid->get_ref<const std::string &>();
+}
+
+}  // namespace
+
+KeyStoreValidator::KeyStoreValidator(const std::string &path,
+                                     size_t cache_size)
+    : path_(path),
+      file_(new MappedFile(path)),
+      cache_(new LruCache<std::string, MessageValidator>(cache_size)) {
+    const uint8_t *data = file_->data();
+    if (file_->size() < kHeaderSize ||
+        memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+        ReadU32(data + 4) != kVersion) {
+        throw std::logic_error("Not a key file: " + path);
+    }
+
+    num_buckets_ = ReadU64(data + 8);
+    num_keys_ = ReadU64(data + 16);
+    if (num_buckets_ == 0 || (num_buckets_ & (num_buckets_ - 1)) != 0 ||
+        num_buckets_ > (file_->size() - kHeaderSize) / kBucketSize) {
+        throw std::logic_error("Corrupt key file: " + path);
+    }
+}
+
+KeyStoreValidator::~KeyStoreValidator() {}
+
+bool KeyStoreValidator::ReadKey(uint64_t offset, Key *key) const {
+    if (offset > file_->size() || file_->size() - offset < kKeyHeaderSize) {
+        return false;
+    }
+
+    const uint8_t *entry = file_->data() + offset;
+    key->algorithm = entry[0];
+    key->num_kid = entry[2] | (entry[3] << 8);
+    key->num_secret = ReadU32(entry + 4);
+    if (key->algorithm < 1 || key->algorithm > 3 ||
+        file_->size() - offset - kKeyHeaderSize <
+            key->num_kid + key->num_secret) {
+        return false;
+    }
+
+    key->kid = reinterpret_cast<const char *>(entry + kKeyHeaderSize);
+    key->secret = key->kid + key->num_kid;
+    return true;
+}
+
+bool KeyStoreValidator::Lookup(const char *kid, size_t num_kid,
+                               Key *key) const {
+    uint64_t hash = Fnv1a(kid, num_kid);
+    uint64_t mask = num_buckets_ - 1;
+    const uint8_t *buckets = file_->data() + kHeaderSize;
+    for (uint64_t probe = 0, idx = hash & mask; probe < num_buckets_;
+         probe++, idx = (idx + 1) & mask) {
+        const uint8_t *bucket = buckets + idx * kBucketSize;
+        uint64_t offset = ReadU64(bucket + 8);
+        if (offset == 0) {
+            return false;
+        }
+        if (ReadU64(bucket) == hash && ReadKey(offset, key) &&
+            key->num_kid == num_kid && memcmp(key->kid, kid, num_kid) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KeyStoreValidator::Find(const json &jose, Key *key) const {
+    const std::string *kid = KidOf(jose);
+    return kid != nullptr && Lookup(kid->data(), kid->size(), key);
+}
+
+bool KeyStoreValidator::Verify(const json &jose, const uint8_t *header,
+                               size_t num_header, const uint8_t *signature,
+                               size_t num_signature) const {
+    const std::string *kid = KidOf(jose);
+    if (kid == nullptr) {
+        return false;
+    }
+
+    std::shared_ptr<MessageValidator> validator = cache_->Get(*kid);
+    if (!validator) {
+        Key key;
+        if (!Lookup(kid->data(), kid->size(), &key)) {
+            return false;
+        }
+        validator = cache_->Put(
+            *kid, std::shared_ptr<MessageValidator>(NewValidator(
+                     key.algorithm, std::string(key.secret, key.num_secret))));
+    }
+    return validator->Verify(jose, header, num_header, signature,
+                             num_signature);
+}
+
+bool KeyStoreValidator::Accepts(const json &jose) const {
+    Key key;
+    if (!Find(jose, &key)) {
+        return false;
+    }
+    return Algorithms::FromJose(jose) == kAlgorithmIds[key.algorithm];
+}
+
+std::string KeyStoreValidator::algorithm() const {
+    return Algorithms::Name(algorithm_id());
+}
+
+Algorithm KeyStoreValidator::algorithm_id() const {
+    Key key;
+    uint64_t first = kHeaderSize + num_buckets_ * kBucketSize;
+    if (num_keys_ == 0 || !ReadKey(first, &key)) {
+        return Algorithm::UNKNOWN;
+    }
+    return kAlgorithmIds[key.algorithm];
+}
+
+size_t KeyStoreValidator::cache_size() const { return cache_->size(); }
+
+std::string KeyStoreValidator::toJson() const {
+    std::ostringstream msg;
+    msg << "{ \"keystore\" : { \"file\" : " << json(path_)
+        << ", \"cache\" : " << cache_->capacity() << " } }";
+    return msg.str();
+}
+
+void KeyStoreWriter::Add(const std::string &kid, const std::string &algorithm,
+                         const std::string &secret) {
+    uint8_t alg = 0;
+    for (uint8_t i = 1; i < 4; i++) {
+        if (algorithm == kAlgorithms[i]) {
+            alg = i;
+        }
+    }
+    if (alg == 0) {
+        throw std::logic_error("Unsupported key store algorithm: " +
+                               algorithm);
+    }
+    if (kid.size() > 0xffff) {
+        throw std::logic_error("kid is too long: " + kid);
+    }
+    if (!kids_.insert(kid).second) {
+        throw std::logic_error("Duplicate kid: " + kid);
+    }
+
+    Key key = {kid, alg, secret};
+    keys_.push_back(key);
+}
+
+void KeyStoreWriter::Write(const std::string &path) const {
+    uint64_t num_buckets = 1;
+    while (num_buckets < keys_.size() * 2) {
+        num_buckets <<= 1;
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> buckets(num_buckets);
+    std::string keys;
+    uint64_t offset = kHeaderSize + num_buckets * kBucketSize;
+    for (auto &key : keys_) {
+        uint64_t hash = Fnv1a(key.kid.data(), key.kid.size());
+        uint64_t idx = hash & (num_buckets - 1);
+        while (buckets[idx].second != 0) {
+            idx = (idx + 1) & (num_buckets - 1);
+        }
+        buckets[idx] = std::make_pair(hash, offset + keys.size());
+
+        keys.push_back(static_cast<char>(key.algorithm));
+        keys.push_back(0);
+        keys.push_back(static_cast<char>(key.kid.size() & 0xff));
+        keys.push_back(static_cast<char>(key.kid.size() >> 8));
+        WriteU32(&keys, static_cast<uint32_t>(key.secret.size()));
+        keys += key.kid;
+        keys += key.secret;
+    }
+
+    std::string file(kMagic, sizeof(kMagic));
+    WriteU32(&file, kVersion);
+    WriteU64(&file, num_buckets);
+    WriteU64(&file, keys_.size());
+    for (auto &bucket : buckets) {
+        WriteU64(&file, bucket.first);
+        WriteU64(&file, bucket.second);
+    }
+    file += keys;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(file.data(), file.size());
+    if (!out) {
+        throw std::logic_error("Unable to write key file: " + path);
+    }
+}
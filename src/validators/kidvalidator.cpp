@@ -22,58 +22,138 @@
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/kidvalidator.h"
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
 
-KidValidator::KidValidator() : algorithm_("") {}
+namespace {
+// Validators registered by pointer are owned by the caller.
+void NoDelete(MessageValidator *) {}
+}  // namespace
+
+KidValidator::KidValidator() : snapshot_(std::make_shared<Snapshot>()) {}
+
+KidValidator::KidValidator(const KidMap &validators, const std::string &first)
+    : KidValidator() {
+    Swap(validators, first);
+}
+
+KidValidator::snapshot_ptr KidValidator::Load() const {
+    return std::atomic_load(&snapshot_);
+}
+
+void KidValidator::Publish(const snapshot_ptr &snapshot) {
+    std::atomic_store(&snapshot_, snapshot);
+}
 
 void KidValidator::Register(const std::string &kid,
                             MessageValidator *validator) {
-    validator_map_[kid] = validator;
-    if (algorithm_.empty()) {
-        algorithm_ = validator->algorithm();
+    Register(kid, std::shared_ptr<MessageValidator>(validator, NoDelete));
+}
+
+void KidValidator::Register(const std::string &kid,
+                            std::shared_ptr<MessageValidator> validator) {
+    std::lock_guard<std::mutex> lock(writer_);
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*Load());
+    if (next->algorithm.empty()) {
+        next->algorithm = validator->algorithm();
+        next->algorithm_id = validator->algorithm_id();
     }
+    next->validators[kid] = std::move(validator);
+    Publish(next);
 }
 
-bool KidValidator::Accepts(const json &jose) const {
-    if (!jose.count("kid") || !jose["kid"].is_string() ||
-        !validator_map_.count(jose["kid"]))
+bool KidValidator::Unregister(const std::string &kid) {
+    std::lock_guard<std::mutex> lock(writer_);
+    snapshot_ptr current = Load();
+    if (!current->validators.count(kid)) {
         return false;
+    }
 
-    auto kidvalidator = validator_map_.find(jose["kid"].get<std::string>());
-    if (kidvalidator == validator_map_.end()) {
-        return false;
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>(*current);
+    next->validators.erase(kid);
+    if (next->validators.empty()) {
+        next->algorithm.clear();
+        next->algorithm_id = Algorithm::UNKNOWN;
     }
+    Publish(next);
+    return true;
+}
 
-    return kidvalidator->second->Accepts(jose);
+void KidValidator::Swap(const KidMap &validators,
+                        const std::string &first_kid) {
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+    next->validators = validators;
+
+    // Same algorithm as registering the keys in order.
+    auto first = validators.find(first_kid);
+    if (first == validators.end()) {
+        first = std::min_element(
+            validators.begin(), validators.end(),
+            [](const KidMap::value_type &a, const KidMap::value_type &b) {
+                return a.first < b.first;
+            });
+    }
+    if (first != validators.end()) {
+        next->algorithm = first->second->algorithm();
+        next->algorithm_id = first->second->algorithm_id();
+    }
+
+    std::lock_guard<std::mutex> lock(writer_);
+    Publish(next);
+}
+
+MessageValidator *KidValidator::Find(const json &jose,
+                                     snapshot_ptr *snapshot) const {
+    auto kid = jose.find("kid");
+    if (kid == jose.end() || !kid->is_string()) return nullptr;
+
+    *snapshot = Load();
+    const KidMap &validators = (*snapshot)->validators;
+    auto kidvalidator = validators.find(kid->get_ref<const std::string &>());
+    if (kidvalidator == validators.end()) {
+        return nullptr;
+    }
+    return kidvalidator->second.get();
+}
+
+bool KidValidator::Accepts(const json &jose) const {
+    snapshot_ptr snapshot;
+    MessageValidator *validator = Find(jose, &snapshot);
+    return validator && validator->Accepts(jose);
 }
 
 bool KidValidator::Verify(const json &jose, const uint8_t *header,
                           size_t num_header, const uint8_t *signature,
                           size_t num_signature) const {
-    if (!jose.count("kid") || !jose["kid"].is_string()) return false;
+    snapshot_ptr snapshot;
+    MessageValidator *validator = Find(jose, &snapshot);
+    return validator && validator->Verify(jose, header, num_header, signature,
+                                          num_signature);
+}
 
-    auto kidvalidator = validator_map_.find(jose["kid"].get<std::string>());
-    if (kidvalidator == validator_map_.end()) {
-        return false;
-    }
+std::string KidValidator::algorithm() const { return Load()->algorithm; }
 
-    MessageValidator *validator = kidvalidator->second;
-    return validator->Verify(jose, header, num_header, signature,
-                             num_signature);
-}
+Algorithm KidValidator::algorithm_id() const { return Load()->algorithm_id; }
 
 std::string KidValidator::toJson() const {
+    snapshot_ptr snapshot = Load();
+    std::vector<std::string> kids;
+    for (const auto &validator : snapshot->validators) {
+        kids.push_back(validator.first);
+    }
+    std::sort(kids.begin(), kids.end());
+
     std::ostringstream msg;
     msg << "{ \"kid\" : { ";
     int idx = 0;
-    for (const auto &validator : validator_map_) {
+    for (const auto &kid : kids) {
         if (idx++ > 0) {
             msg << ", ";
         }
-        msg << "\"" << validator.first << "\" : ";
-        msg << validator.second->toJson();
+        msg << "\"" << kid << "\" : ";
+        msg << snapshot->validators.at(kid)->toJson();
     }
     msg << " } }";
     return msg.str();
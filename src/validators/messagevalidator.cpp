@@ -23,9 +23,20 @@
 #include "jwt/messagevalidator.h"
 #include <string>
 
+Algorithm MessageValidator::algorithm_id() const {
+    return Algorithms::Parse(algorithm());
+}
+
 bool MessageValidator::Accepts(const json &jose) const {
-    return jose.count("alg") &&
-           jose["alg"].get<std::string>() == this->algorithm();
+    Algorithm id = algorithm_id();
+    if (id != Algorithm::UNKNOWN) {
+        return Algorithms::FromJose(jose) == id;
+    }
+
+    // Not an algorithm we know, so compare the names.
+    auto alg = jose.find("alg");
+    return alg != jose.end() && alg->is_string() &&
+           alg->get_ref<const std::string &>() == algorithm();
 }
 
 bool MessageValidator::Validate(const json &jsonHeader,
@@ -23,22 +23,33 @@
 #include "jwt/messagevalidatorfactory.h"
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <vector>
 #include "jwt/allocators.h"
+#include "jwt/derivedkeyvalidator.h"
+#include "jwt/ecdsavalidator.h"
+#include "jwt/eddsavalidator.h"
 #include "jwt/hmacvalidator.h"
 #include "jwt/json.hpp"
+#include "jwt/keystorevalidator.h"
 #include "jwt/kidvalidator.h"
+#include "jwt/multikeyvalidator.h"
 #include "jwt/nonevalidator.h"
 #include "jwt/rsavalidator.h"
 #include "jwt/setvalidator.h"
 #include "private/buildwrappers.h"
+#include "private/filewatcher.h"
 
 using namespace std;
 using json = nlohmann::json;
 
+MessageValidatorFactory::MessageValidatorFactory()
+    : watch_(true), lazy_(false), warmup_(false) {}
+
 MessageValidatorFactory::~MessageValidatorFactory() {
+    watcher_.reset();
     for (auto it = build_.begin(); it != build_.end(); it++) {
         delete *it;
     }
@@ -71,17 +82,33 @@ MessageSigner *MessageValidatorFactory::BuildSigner(const json &json) {
         constructed.reset(
             new HS512Validator(ParseSecret("secret", json["HS512"])));
     } else if (json.count("RS256")) {
+        std::string pub = ParseSecret("public", json["RS256"]);
         constructed.reset(
-            new RS256Validator(ParseSecret("public", json["RS256"]),
-                               ParseSecret("private", json["RS256"])));
+            new RS256Validator(pub, ParseSecret("private", json["RS256"])));
     } else if (json.count("RS384")) {
+        std::string pub = ParseSecret("public", json["RS384"]);
         constructed.reset(
-            new RS384Validator(ParseSecret("public", json["RS384"]),
-                               ParseSecret("private", json["RS384"])));
+            new RS384Validator(pub, ParseSecret("private", json["RS384"])));
     } else if (json.count("RS512")) {
+        std::string pub = ParseSecret("public", json["RS512"]);
+        constructed.reset(
+            new RS512Validator(pub, ParseSecret("private", json["RS512"])));
+    } else if (json.count("ES256")) {
+        std::string pub = ParseSecret("public", json["ES256"]);
+        constructed.reset(
+            new ES256Validator(pub, ParseSecret("private", json["ES256"])));
+    } else if (json.count("ES384")) {
+        std::string pub = ParseSecret("public", json["ES384"]);
+        constructed.reset(
+            new ES384Validator(pub, ParseSecret("private", json["ES384"])));
+    } else if (json.count("ES512")) {
+        std::string pub = ParseSecret("public", json["ES512"]);
+        constructed.reset(
+            new ES512Validator(pub, ParseSecret("private", json["ES512"])));
+    } else if (json.count("EdDSA")) {
+        std::string pub = ParseSecret("public", json["EdDSA"]);
         constructed.reset(
-            new RS512Validator(ParseSecret("public", json["RS512"]),
-                               ParseSecret("private", json["RS512"])));
+            new EdDSAValidator(pub, ParseSecret("private", json["EdDSA"])));
     }
 
     if (constructed.get() == nullptr) {
@@ -99,8 +126,33 @@ MessageValidator *MessageValidatorFactory::BuildInternal(const json &json) {
     }
 
     std::unique_ptr<MessageValidator> constructed = nullptr;
+    std::vector<std::string> watched = watch_ ? WatchedFiles(json)
+                                              : std::vector<std::string>();
     try {
-        if (json.count("none")) {
+        if (!watched.empty()) {
+            WatchedValidator *validator =
+                new WatchedValidator(json, [json]() { return BuildUnwatched(json); });
+            constructed.reset(validator);
+            if (!watcher_) {
+                watcher_.reset(new FileWatcher());
+            }
+            for (auto &path : watched) {
+                watcher_->Watch(path, [validator]() { validator->Reload(); });
+            }
+        } else if (lazy_ && IsKeyed(json)) {
+            LazyValidator *validator = new LazyValidator(
+                json, [json]() { return BuildUnwatched(json); });
+            constructed.reset(validator);
+            lazy_validators_.push_back(validator);
+        } else if (json.count("lazy") || json.count("warmup")) {
+            std::string property = json.count("lazy") ? "lazy" : "warmup";
+            bool lazy = lazy_;
+            lazy_ = true;
+            warmup_ = warmup_ || property == "warmup";
+            MessageValidator *root = BuildInternal(json[property]);
+            lazy_ = lazy;
+            constructed.reset(new LazyScope(property, root));
+        } else if (json.count("none")) {
             constructed.reset(new NoneValidator());
         } else if (json.count("HS256")) {
             constructed.reset(
@@ -120,13 +172,44 @@ MessageValidator *MessageValidatorFactory::BuildInternal(const json &json) {
         } else if (json.count("RS512")) {
             constructed.reset(
                 new RS512Validator(ParseSecret("public", json["RS512"])));
+        } else if (json.count("ES256")) {
+            constructed.reset(
+                new ES256Validator(ParseSecret("public", json["ES256"])));
+        } else if (json.count("ES384")) {
+            constructed.reset(
+                new ES384Validator(ParseSecret("public", json["ES384"])));
+        } else if (json.count("ES512")) {
+            constructed.reset(
+                new ES512Validator(ParseSecret("public", json["ES512"])));
+        } else if (json.count("EdDSA")) {
+            constructed.reset(
+                new EdDSAValidator(ParseSecret("public", json["EdDSA"])));
         } else if (json.count("set")) {
             auto lst = BuildValidatorList(json["set"]);
             constructed.reset(new SetValidator(lst));
+        } else if (json.count("multi")) {
+            auto lst = BuildValidatorList(json["multi"]);
+            constructed.reset(new MultiKeyValidator(lst));
         } else if (json.count("kid")) {
             KidValidator *kid = new KidValidator();
             constructed.reset(kid);
             BuildKid(kid, json["kid"]);
+        } else if (json.count("keystore")) {
+            ::json keystore = json["keystore"];
+            ::json cache = keystore["cache"];
+            constructed.reset(new KeyStoreValidator(
+                keystore["file"].get<std::string>(),
+                cache.is_null() ? 1024 : cache.get<size_t>()));
+        } else if (json.count("derived")) {
+            ::json derived = json["derived"];
+            std::string alg = derived["alg"].get<std::string>();
+            std::string master = ParseSecret("secret", derived);
+            std::string kid = derived["kid"].get<std::string>();
+            ::json cache = derived["cache"];
+            ::json salt = derived["salt"];
+            constructed.reset(new DerivedKeyValidator(
+                alg, master, kid, cache.is_null() ? 1024 : cache.get<size_t>(),
+                salt.is_null() ? "" : salt.get<std::string>()));
         }
     } catch (std::exception &e) {
         throw std::logic_error(
@@ -146,6 +229,21 @@ MessageValidator *MessageValidatorFactory::BuildInternal(const json &json) {
 MessageValidator *MessageValidatorFactory::Build(const json &json) {
     MessageValidatorFactory factory;
 
+    MessageValidator *root = factory.BuildInternal(json);
+    ParsedMessagevalidator *validator = new ParsedMessagevalidator(
+        json, factory.build_, root, factory.watcher_.release());
+    factory.build_.clear();
+
+    if (factory.warmup_) {
+        validator->WarmUp(factory.lazy_validators_);
+    }
+    return validator;
+}
+
+MessageValidator *MessageValidatorFactory::BuildUnwatched(const json &json) {
+    MessageValidatorFactory factory;
+    factory.watch_ = false;
+
     MessageValidator *root = factory.BuildInternal(json);
     ParsedMessagevalidator *validator =
         new ParsedMessagevalidator(json, factory.build_, root);
@@ -154,6 +252,40 @@ MessageValidator *MessageValidatorFactory::Build(const json &json) {
     return validator;
 }
 
+bool MessageValidatorFactory::IsKeyed(const json &j) {
+    static const char *keyed[] = {"HS256", "HS384", "HS512", "RS256",
+                                  "RS384", "RS512", "ES256", "ES384",
+                                  "ES512", "EdDSA"};
+    if (!j.is_object() || j.size() != 1) {
+        return false;
+    }
+    for (auto alg : keyed) {
+        if (j.begin().key() == alg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string> MessageValidatorFactory::WatchedFiles(
+    const json &j) {
+    // Only the key material of a single algorithm can be watched, i.e.
+    // { "RS256" : { "public" : { "fromfile" : "...", "watch" : true } } }
+    std::vector<std::string> files;
+    if (!j.is_object() || j.size() != 1 || !j.begin()->is_object()) {
+        return files;
+    }
+
+    for (auto &secret : *j.begin()) {
+        if (secret.is_object() && secret.count("fromfile") &&
+            secret.count("watch") && secret["watch"].is_boolean() &&
+            secret["watch"].get<bool>()) {
+            files.push_back(secret["fromfile"].get<std::string>());
+        }
+    }
+    return files;
+}
+
 std::vector<MessageValidator *> MessageValidatorFactory::BuildValidatorList(
     const json &j) {
     std::vector<MessageValidator *> result;
@@ -167,10 +299,15 @@ std::vector<MessageValidator *> MessageValidatorFactory::BuildValidatorList(
 
 MessageValidator *MessageValidatorFactory::BuildKid(KidValidator *kid,
                                                     const json &j) {
+    // The factory owns the validators, and the table is published once so
+    // large key sets are not copied for every kid.
+    KidValidator::KidMap validators;
     for (auto it = j.begin(); it != j.end(); ++it) {
         MessageValidator *validator = BuildInternal(it.value());
-        kid->Register(it.key(), validator);
+        validators[it.key()] = std::shared_ptr<MessageValidator>(
+            validator, [](MessageValidator *) {});
     }
+    kid->Swap(validators, j.empty() ? std::string() : j.begin().key());
 
     return kid;
 }
@@ -190,9 +327,15 @@ std::string MessageValidatorFactory::ParseSecret(const std::string &property,
     }
 
     if (secret.count("fromfile")) {
-        std::ifstream t(secret["fromfile"].get<std::string>());
+        std::string path = secret["fromfile"].get<std::string>();
+        std::ifstream t(path);
         std::stringstream buffer;
         buffer << t.rdbuf();
+        // A file that is being replaced can be missing or still empty, a
+        // reload must fail rather than use an empty key.
+        if (!t || buffer.str().empty()) {
+            throw std::logic_error("unable to read secret from: " + path);
+        }
         return buffer.str();
     }
 
@@ -209,9 +352,19 @@ std::string ParsedMessagevalidator::algorithm() const {
     return root_->algorithm();
 }
 
+Algorithm ParsedMessagevalidator::algorithm_id() const {
+    return root_->algorithm_id();
+}
+
 std::string ParsedMessagevalidator::toJson() const { return root_->toJson(); }
 
 ParsedMessagevalidator::~ParsedMessagevalidator() {
+    // Stop the watcher and warm up first, they refer to our children.
+    watcher_.reset();
+    stop_ = true;
+    if (warmup_.joinable()) {
+        warmup_.join();
+    }
     for (auto it = children_.begin(); it != children_.end(); it++) {
         delete *it;
     }
@@ -223,5 +376,113 @@ bool ParsedMessagevalidator::Accepts(const json &jose) const {
 
 ParsedMessagevalidator::ParsedMessagevalidator(
     const json &json, const std::vector<MessageValidator *> &children,
-    MessageValidator *root)
-    : json_(json), children_(children), root_(root) {}
+    MessageValidator *root, FileWatcher *watcher)
+    : json_(json),
+      children_(children),
+      root_(root),
+      watcher_(watcher),
+      stop_(false) {}
+
+void ParsedMessagevalidator::WarmUp(const std::vector<LazyValidator *> &lazy) {
+    warmup_ = std::thread([this, lazy]() {
+        for (auto it = lazy.begin(); it != lazy.end() && !stop_; it++) {
+            (*it)->Materialize();
+        }
+    });
+}
+
+WatchedValidator::WatchedValidator(const json &json, Builder builder)
+    : json_(json), builder_(builder), validator_(builder()) {}
+
+bool WatchedValidator::Reload() {
+    std::shared_ptr<MessageValidator> validator;
+    try {
+        validator.reset(builder_());
+    } catch (std::exception &) {
+        return false;
+    }
+    std::atomic_store(&validator_, validator);
+    return true;
+}
+
+bool WatchedValidator::Verify(const json &jose, const uint8_t *header,
+                              size_t num_header, const uint8_t *signature,
+                              size_t num_signature) const {
+    return std::atomic_load(&validator_)
+        ->Verify(jose, header, num_header, signature, num_signature);
+}
+
+std::string WatchedValidator::algorithm() const {
+    return std::atomic_load(&validator_)->algorithm();
+}
+
+Algorithm WatchedValidator::algorithm_id() const {
+    return std::atomic_load(&validator_)->algorithm_id();
+}
+
+bool WatchedValidator::Accepts(const json &jose) const {
+    return std::atomic_load(&validator_)->Accepts(jose);
+}
+
+std::string WatchedValidator::toJson() const { return json_.dump(); }
+
+LazyValidator::LazyValidator(const json &json, Builder builder)
+    : json_(json),
+      algorithm_id_(Algorithms::Parse(json.begin().key())),
+      builder_(builder),
+      failed_(false),
+      materialized_(nullptr) {}
+
+MessageValidator *LazyValidator::Materialize() const {
+    MessageValidator *validator = materialized_.load(std::memory_order_acquire);
+    if (validator) {
+        return validator;
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!validator_ && !failed_) {
+        try {
+            validator_.reset(builder_());
+        } catch (std::exception &) {
+            // A bad key does not get better by parsing it on every token.
+            failed_ = true;
+            return nullptr;
+        }
+        materialized_.store(validator_.get(), std::memory_order_release);
+    }
+    return validator_.get();
+}
+
+bool LazyValidator::Verify(const json &jose, const uint8_t *header,
+                           size_t num_header, const uint8_t *signature,
+                           size_t num_signature) const {
+    MessageValidator *validator = Materialize();
+    return validator && validator->Verify(jose, header, num_header, signature,
+                                          num_signature);
+}
+
+std::string LazyValidator::algorithm() const { return json_.begin().key(); }
+
+Algorithm LazyValidator::algorithm_id() const { return algorithm_id_; }
+
+std::string LazyValidator::toJson() const { return json_.dump(); }
+
+LazyScope::LazyScope(const std::string &property, MessageValidator *root)
+    : property_(property), root_(root) {}
+
+bool LazyScope::Verify(const json &jose, const uint8_t *header,
+                       size_t num_header, const uint8_t *signature,
+                       size_t num_signature) const {
+    return root_->Verify(jose, header, num_header, signature, num_signature);
+}
+
+std::string LazyScope::algorithm() const { return root_->algorithm(); }
+
+Algorithm LazyScope::algorithm_id() const { return root_->algorithm_id(); }
+
+bool LazyScope::Accepts(const json &jose) const {
+    return root_->Accepts(jose);
+}
+
+std::string LazyScope::toJson() const {
+    return "{ \"" + property_ + "\" : " + root_->toJson() + " }";
+}
@@ -0,0 +1,177 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "jwt/multikeyvalidator.h"
+#include <openssl/evp.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "jwt/rsavalidator.h"
+
+MultiKeyValidator::MultiKeyValidator(
+    const std::vector<MessageValidator *> &validators)
+    : validators_(validators) {
+    std::vector<Candidates *> all;
+    for (auto validator : validators) {
+        Algorithm id = validator->algorithm_id();
+        Candidates *candidates =
+            id != Algorithm::UNKNOWN
+                ? Add(&candidates_[static_cast<size_t>(id)], validator)
+                : Add(&unknown_[validator->algorithm()], validator);
+        if (candidates->validators.size() == 1) {
+            all.push_back(candidates);
+        }
+    }
+
+    // The digest can only be shared if every candidate is an RSA validator.
+    for (auto candidates : all) {
+        for (auto validator : candidates->validators) {
+            const RSAValidator *rsa = dynamic_cast<const RSAValidator *>(validator);
+            if (rsa == nullptr) {
+                candidates->rsa.clear();
+                break;
+            }
+            candidates->rsa.push_back(rsa);
+        }
+    }
+}
+
+MultiKeyValidator::~MultiKeyValidator() {}
+
+MultiKeyValidator::Candidates *MultiKeyValidator::Add(
+    std::unique_ptr<Candidates> *candidates, MessageValidator *validator) {
+    if (!*candidates) {
+        candidates->reset(new Candidates());
+    }
+    (*candidates)->validators.push_back(validator);
+    return candidates->get();
+}
+
+MultiKeyValidator::Candidates *MultiKeyValidator::Find(
+    const json &jose) const {
+    Algorithm id = Algorithms::FromJose(jose);
+    if (id != Algorithm::UNKNOWN) {
+        return candidates_[static_cast<size_t>(id)].get();
+    }
+    if (unknown_.empty()) {
+        return nullptr;
+    }
+
+    auto alg = jose.find("alg");
+    if (alg == jose.end() || !alg->is_string()) {
+        return nullptr;
+    }
+    auto candidates = unknown_.find(alg->get_ref<const std::string &>());
+    return candidates == unknown_.end() ? nullptr : candidates->second.get();
+}
+
+bool MultiKeyValidator::Verify(const json &jose, const uint8_t *header,
+                               size_t num_header, const uint8_t *signature,
+                               size_t num_signature) const {
+    Candidates *candidates = Find(jose);
+    if (candidates == nullptr) {
+        return false;
+    }
+
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int num_digest = 0;
+    bool shared = !candidates->rsa.empty();
+    if (shared && EVP_Digest(header, num_header, digest, &num_digest,
+                             candidates->rsa[0]->md(), NULL) != 1) {
+        return false;
+    }
+
+    // Try the last successful candidate first, then all the others in order.
+    size_t num_candidates = candidates->validators.size();
+    size_t last = candidates->last.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= num_candidates; i++) {
+        size_t idx = i == 0 ? last : i - 1;
+        if (i > 0 && idx == last) {
+            continue;
+        }
+
+        bool valid =
+            shared ? candidates->rsa[idx]->VerifyDigest(
+                         digest, num_digest, signature, num_signature)
+                   : candidates->validators[idx]->Verify(
+                         jose, header, num_header, signature, num_signature);
+        if (valid) {
+            if (idx != last) {
+                candidates->last.store(idx, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MultiKeyValidator::Accepts(const json &jose) const {
+    Candidates *candidates = Find(jose);
+    if (candidates == nullptr) {
+        return false;
+    }
+    for (auto validator : candidates->validators) {
+        if (validator->Accepts(jose)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string MultiKeyValidator::algorithm() const {
+    Algorithm id = algorithm_id();
+    if (id != Algorithm::UNKNOWN) {
+        return Algorithms::Name(id);
+    }
+    if (unknown_.size() == 1 && validators_.size() ==
+                                    unknown_.begin()->second->validators.size()) {
+        return unknown_.begin()->first;
+    }
+    return "MULTI";
+}
+
+Algorithm MultiKeyValidator::algorithm_id() const {
+    if (validators_.empty()) {
+        return Algorithm::UNKNOWN;
+    }
+    Algorithm id = validators_[0]->algorithm_id();
+    if (id == Algorithm::UNKNOWN ||
+        candidates_[static_cast<size_t>(id)]->validators.size() !=
+            validators_.size()) {
+        return Algorithm::UNKNOWN;
+    }
+    return id;
+}
+
+std::string MultiKeyValidator::toJson() const {
+    std::ostringstream msg;
+    msg << "{ \"multi\" : [ ";
+    int idx = 0;
+    for (auto validator : validators_) {
+        if (idx++ > 0) {
+            msg << ", ";
+        }
+        msg << validator->toJson();
+    }
+    msg << " ] }";
+    return msg.str();
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2015 Erwin Jansen
+//
+// MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining
+// a copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+// OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "private/pemkey.h"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <regex>  // NOLINT(*)
+#include <sstream>
+#include <string>
+#include "jwt/jwt_error.h"
+
+EVP_PKEY *PemKey::Load(const char *key, bool public_key) {
+    EVP_PKEY *evp_pkey = NULL;
+    BIO *keybio = !key || !*key ? NULL : BIO_new_mem_buf(
+        const_cast<void *>(reinterpret_cast<const void *>(key)), -1);
+    if (keybio == NULL) {
+        return NULL;
+    }
+
+    if (public_key) {
+        evp_pkey = PEM_read_bio_PUBKEY(keybio, &evp_pkey, NULL, NULL);
+    } else {
+        evp_pkey = PEM_read_bio_PrivateKey(keybio, &evp_pkey, NULL, NULL);
+    }
+
+    BIO_free(keybio);
+
+    if (evp_pkey == NULL) {
+        char buffer[120];
+        ERR_error_string(ERR_get_error(), buffer);
+        throw InvalidValidatorError(
+            std::string("Unable to construct ") +
+            (public_key ? "public key" : "private key") +
+            " due to: " + std::string(buffer));
+    }
+
+    return evp_pkey;
+}
+
+std::string PemKey::Write(EVP_PKEY *key, bool public_key) {
+    char *data;
+    BIO *out = BIO_new(BIO_s_mem());
+    if (public_key) {
+        PEM_write_bio_PUBKEY(out, key);
+    } else {
+        PEM_write_bio_PrivateKey(out, key, NULL, NULL, 0, 0, NULL);
+    }
+    uint64_t len = BIO_get_mem_data(out, &data);
+    std::string pem = std::string(data, len);
+    BIO_free(out);
+    return pem;
+}
+
+std::string PemKey::ToJson(const std::string &algorithm, EVP_PKEY *public_key,
+                           EVP_PKEY *private_key) {
+    std::ostringstream msg;
+    std::regex newline("\n");
+
+    msg << "{ \"" << algorithm << "\" : { ";
+
+    if (public_key) {
+        msg << "\"public\" : \""
+            << std::regex_replace(Write(public_key, true), newline, "\\n")
+            << "\"";
+
+        if (private_key) {
+            msg << ", ";
+            msg << "\"private\" : \""
+                << std::regex_replace(Write(private_key, false), newline,
+                                      "\\n")
+                << "\"";
+        }
+    }
+
+    msg << "} }";
+    return msg.str();
+}
@@ -21,24 +21,32 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/rsavalidator.h"
+#include "private/pemkey.h"
 #include "private/ssl_compat.h"
-#include <openssl/err.h>
-#include <openssl/pem.h>
-#include <regex>  // NOLINT(*)
-#include <sstream>
 #include <string>
 
 RSAValidator::RSAValidator(const std::string &algorithm, const EVP_MD *md,
                            const std::string &key)
-    : algorithm_(algorithm), private_key_(NULL), public_key_(NULL), md_(md) {
-    public_key_ = LoadKey(key.c_str(), true);
+    : algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)),
+      private_key_(NULL), public_key_(NULL), md_(md) {
+    public_key_ = PemKey::Load(key.c_str(), true);
 }
 
 RSAValidator::RSAValidator(const std::string &algorithm, const EVP_MD *md,
                            const std::string &key,
                            const std::string &private_key)
     : RSAValidator(algorithm, md, key) {
-    private_key_ = LoadKey(private_key.c_str(), false);
+    private_key_ = PemKey::Load(private_key.c_str(), false);
+}
+
+RSAValidator::RSAValidator(const std::string &algorithm, const EVP_MD *md,
+                           EVP_PKEY *public_key)
+    : algorithm_(algorithm),
+      algorithm_id_(Algorithms::Parse(algorithm)),
+      private_key_(NULL), public_key_(public_key),
+      md_(md) {
+    EVP_PKEY_up_ref(public_key_);
 }
 
 RSAValidator::~RSAValidator() {
@@ -59,6 +67,22 @@ bool RSAValidator::Verify(const json &jsonHeader, const uint8_t *header,
     return valid;
 }
 
+bool RSAValidator::VerifyDigest(const uint8_t *digest, size_t num_digest,
+                                const uint8_t *signature,
+                                size_t num_signature) const {
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(public_key_, NULL);
+    if (ctx == NULL) {
+        return false;
+    }
+    bool valid =
+        EVP_PKEY_verify_init(ctx) == 1 &&
+        EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) == 1 &&
+        EVP_PKEY_CTX_set_signature_md(ctx, md_) == 1 &&
+        EVP_PKEY_verify(ctx, signature, num_signature, digest, num_digest) == 1;
+    EVP_PKEY_CTX_free(ctx);
+    return valid;
+}
+
 bool RSAValidator::Sign(const uint8_t *header, size_t num_header,
                         uint8_t *signature, size_t *num_signature) const {
     size_t needed = 0;
@@ -88,62 +112,6 @@ Error:
     return success;
 }
 
-EVP_PKEY *RSAValidator::LoadKey(const char *key, bool public_key) {
-    EVP_PKEY *evp_pkey = NULL;
-    BIO *keybio = !key || !*key ? NULL : BIO_new_mem_buf(
-        const_cast<void *>(reinterpret_cast<const void *>(key)), -1);
-    if (keybio == NULL) {
-        return NULL;
-    }
-
-    if (public_key) {
-        evp_pkey = PEM_read_bio_PUBKEY(keybio, &evp_pkey, NULL, NULL);
-    } else {
-        evp_pkey = PEM_read_bio_PrivateKey(keybio, &evp_pkey, NULL, NULL);
-    }
-
-    BIO_free(keybio);
-
-    if (evp_pkey == NULL) {
-        char buffer[120];
-        ERR_error_string(ERR_get_error(), buffer);
-        throw InvalidValidatorError(
-            std::string("Unable to construct ") +
-            (public_key ? "public key" : "private key") +
-            " due to: " + std::string(buffer));
-    }
-
-    return evp_pkey;
-}
-
 std::string RSAValidator::toJson() const {
-    std::ostringstream msg;
-    char *key;
-    std::regex newline("\n");
-
-    msg << "{ \"" << algorithm() << "\" : { ";
-
-    if (public_key_) {
-        BIO *out = BIO_new(BIO_s_mem());
-        PEM_write_bio_PUBKEY(out, public_key_);
-        uint64_t len = BIO_get_mem_data(out, &key);
-        std::string pubkey = std::string(key, len);
-        msg << "\"public\" : \"" << std::regex_replace(pubkey, newline, "\\n")
-            << "\"";
-        BIO_free(out);
-
-        if (private_key_) {
-            msg << ", ";
-            BIO *out = BIO_new(BIO_s_mem());
-            PEM_write_bio_PrivateKey(out, private_key_, NULL, NULL, 0, 0, NULL);
-            uint64_t len = BIO_get_mem_data(out, &key);
-            std::string privkey = std::string(key, len);
-            msg << "\"private\" : \""
-                << std::regex_replace(privkey, newline, "\\n") << "\"";
-            BIO_free(out);
-        }
-    }
-
-    msg << "} }";
-    return msg.str();
+    return PemKey::ToJson(algorithm(), public_key_, private_key_);
 }
@@ -21,48 +21,68 @@
 // OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
 // WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "jwt/setvalidator.h"
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <vector>
 
 SetValidator::SetValidator(const std::vector<MessageValidator *> &validators) {
+    std::fill(validators_, validators_ + Algorithms::kCount, nullptr);
     for (auto validator : validators) {
-        validator_map_[validator->algorithm()] = validator;
+        Algorithm id = validator->algorithm_id();
+        if (id != Algorithm::UNKNOWN) {
+            validators_[static_cast<size_t>(id)] = validator;
+        } else {
+            unknown_[validator->algorithm()] = validator;
+        }
     }
 }
 
-bool SetValidator::Verify(const json &jose, const uint8_t *header,
-                          size_t num_header, const uint8_t *signature,
-                          size_t num_signature) const {
-    if (!jose.count("alg")) {
-        return false;
+MessageValidator *SetValidator::Find(const json &jose) const {
+    Algorithm id = Algorithms::FromJose(jose);
+    if (id != Algorithm::UNKNOWN) {
+        return validators_[static_cast<size_t>(id)];
+    }
+    if (unknown_.empty()) {
+        return nullptr;
     }
 
-    auto alg = validator_map_.find(jose["alg"].get<std::string>());
-    if (alg == validator_map_.end()) {
-        return false;
+    auto alg = jose.find("alg");
+    if (alg == jose.end() || !alg->is_string()) {
+        return nullptr;
     }
+    auto validator = unknown_.find(alg->get_ref<const std::string &>());
+    return validator == unknown_.end() ? nullptr : validator->second;
+}
 
-    MessageValidator *validator = alg->second;
-    return validator->Verify(nullptr, header, num_header, signature,
+bool SetValidator::Verify(const json &jose, const uint8_t *header,
+                          size_t num_header, const uint8_t *signature,
+                          size_t num_signature) const {
+    MessageValidator *validator = Find(jose);
+    return validator != nullptr &&
+           validator->Verify(jose, header, num_header, signature,
                              num_signature);
 }
 
 bool SetValidator::Accepts(const json &jose) const {
-    if (!jose.count("alg") || !jose["alg"].is_string()) return false;
-
-    auto alg = validator_map_.find(jose["alg"].get<std::string>());
-    if (alg == validator_map_.end()) {
-        return false;
-    }
-    return alg->second->Accepts(jose);
+    MessageValidator *validator = Find(jose);
+    return validator != nullptr && validator->Accepts(jose);
 }
 
 std::string SetValidator::toJson() const {
     std::ostringstream msg;
     msg << "{ \"set\" : [ ";
     int idx = 0;
-    for (const auto &validator : validator_map_) {
+    for (auto validator : validators_) {
+        if (validator == nullptr) {
+            continue;
+        }
+        if (idx++ > 0) {
+            msg << ", ";
+        }
+        msg << validator->toJson();
+    }
+    for (const auto &validator : unknown_) {
         if (idx++ > 0) {
             msg << ", ";
         }
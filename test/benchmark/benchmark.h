@@ -0,0 +1,25 @@
+#ifndef TEST_BENCHMARK_BENCHMARK_H_
+#define TEST_BENCHMARK_BENCHMARK_H_
+
+#include <chrono>
+#include <iostream>
+#include "jwt/claimvalidator.h"
+
+// Returns the average time in nanoseconds the validator takes to check the
+// claims. Every iteration must get the same verdict.
+static double run(const ClaimValidator &validator, const nlohmann::json &claims,
+                  int iterations) {
+  size_t valid = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    valid += validator.Check(claims).valid();
+  }
+  auto end = std::chrono::steady_clock::now();
+  if (valid != 0 && valid != static_cast<size_t>(iterations)) {
+    std::cerr << "inconsistent results" << std::endl;
+  }
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         iterations;
+}
+
+#endif // TEST_BENCHMARK_BENCHMARK_H_
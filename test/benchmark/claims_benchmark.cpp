@@ -0,0 +1,45 @@
+// Measures the cost of validating iss and aud claims against allow lists of
+// various sizes. This is not a test, run it by hand:
+//
+//   ./claims_benchmark [iterations]
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "jwt/claimvalidator.h"
+#include "jwt/listclaimvalidator.h"
+#include "./benchmark.h"
+
+using json = nlohmann::json;
+
+static std::vector<std::string> make_list(size_t size) {
+  std::vector<std::string> list;
+  for (size_t i = 0; i < size; i++) {
+    list.push_back("https://issuer-" + std::to_string(i) + ".example.com");
+  }
+  return list;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+  size_t sizes[] = {10, 1000, 100000};
+
+  std::cout << "entries\tiss hit\tiss miss\taud[4] hit\taud[4] miss (ns/op)"
+            << std::endl;
+  for (size_t size : sizes) {
+    std::vector<std::string> list = make_list(size);
+    IssValidator iss(list);
+    AudValidator aud(list);
+
+    json iss_hit = {{"iss", list[size - 1]}};
+    json iss_miss = {{"iss", "https://unknown.example.com"}};
+    json aud_hit = {{"aud", {"a", "b", "c", list[size / 2]}}};
+    json aud_miss = {{"aud", {"a", "b", "c", "d"}}};
+
+    std::cout << size << "\t" << run(iss, iss_hit, iterations) << "\t"
+              << run(iss, iss_miss, iterations) << "\t"
+              << run(aud, aud_hit, iterations) << "\t"
+              << run(aud, aud_miss, iterations) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,46 @@
+// Compares a static policy against the same policy built and compiled by the
+// ClaimValidatorFactory. This is not a test, run it by hand:
+//
+//   ./policy_benchmark [iterations]
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "jwt/claimvalidator.h"
+#include "jwt/claimvalidatorfactory.h"
+#include "jwt/staticpolicy.h"
+#include "./benchmark.h"
+
+using json = nlohmann::json;
+
+JWT_CLAIM_VALUES(Issuers, "https://a.example.com", "https://b.example.com");
+JWT_CLAIM_VALUES(Audience, "api");
+typedef policy::All<policy::Exp<30>, policy::Iss<Issuers>,
+                    policy::Aud<Audience>>
+    BenchmarkPolicy;
+
+int main(int argc, char *argv[]) {
+  int iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+  policy::Policy<BenchmarkPolicy> static_policy;
+  std::string description = static_policy.toJson();
+  std::unique_ptr<ClaimValidator> tree(
+      ClaimValidatorFactory::Build(description));
+  std::unique_ptr<ClaimValidator> compiled(
+      ClaimValidatorFactory::Compile(description));
+
+  json hit = {{"exp", 4102444800},
+              {"iss", "https://b.example.com"},
+              {"aud", {"web", "api"}}};
+  json miss = {{"exp", 4102444800},
+               {"iss", "https://b.example.com"},
+               {"aud", {"web", "mobile"}}};
+
+  std::cout << "validator\thit\tmiss (ns/op)" << std::endl;
+  std::cout << "static\t" << run(static_policy, hit, iterations) << "\t"
+            << run(static_policy, miss, iterations) << std::endl;
+  std::cout << "tree\t" << run(*tree, hit, iterations) << "\t"
+            << run(*tree, miss, iterations) << std::endl;
+  std::cout << "compiled\t" << run(*compiled, hit, iterations) << "\t"
+            << run(*compiled, miss, iterations) << std::endl;
+  return 0;
+}
@@ -1,6 +1,7 @@
 #include <string>
 #include "gtest/gtest.h"
 #include "jwt/jwt_all.h"
+#include "private/base64.h"
 
 class TokenTest : public ::testing::Test {
    public:
@@ -211,3 +212,305 @@ TEST_F(TokenTest, payload_deserialize) {
     EXPECT_TRUE(payload["admin"].get<bool>());
     EXPECT_STREQ("John Doe", payload["name"].get<std::string>().c_str());
 }
+
+TEST_F(TokenTest, issuer_registry_routes_by_iss) {
+    IssuerRegistry registry;
+    registry.Load({{"alice",
+                    {{"validator", {{"HS256", {{"secret", "alice"}}}}},
+                     {"claims", {{"sub", {"1"}}}}}},
+                   {"bob", {{"validator", {{"HS256", {{"secret", "bob"}}}}}}}});
+    EXPECT_EQ(2u, registry.size());
+
+    HS256Validator alice("alice"), bob("bob");
+    ::json header, payload;
+    std::tie(header, payload) = registry.Decode(
+        JWT::Encode(alice, {{"nested", {{"iss", "bob"}}}, {"iss", "alice"},
+                            {"sub", "1"}}));
+    EXPECT_EQ("alice", payload["iss"]);
+    std::tie(header, payload) =
+        registry.Decode(JWT::Encode(bob, {{"iss", "bob"}, {"sub", "2"}}));
+    EXPECT_EQ("2", payload["sub"]);
+
+    ASSERT_THROW(registry.Decode(JWT::Encode(alice, {{"iss", "alice"}})),
+                 InvalidClaimError);
+    ASSERT_THROW(registry.Decode(JWT::Encode(bob, {{"iss", "alice"}})),
+                 InvalidSignatureError);
+    ASSERT_THROW(registry.Decode(JWT::Encode(bob, {{"iss", "carol"}})),
+                 InvalidSignatureError);
+    ASSERT_THROW(registry.Decode(JWT::Encode(bob, {{"sub", "bob"}})),
+                 InvalidSignatureError);
+    ASSERT_THROW(registry.Decode("foo"), TokenFormatError);
+
+    EXPECT_TRUE(registry.Remove("bob"));
+    EXPECT_FALSE(registry.Remove("bob"));
+    ASSERT_THROW(registry.Decode(JWT::Encode(bob, {{"iss", "bob"}})),
+                 InvalidSignatureError);
+}
+
+TEST_F(TokenTest, issuer_registry_rejects_duplicate_iss) {
+    IssuerRegistry registry;
+    registry.Register("alice", new HS256Validator("alice"), nullptr);
+
+    HS256Validator alice("alice");
+    std::string signed_area =
+        Base64Encode::EncodeUrl("{\"alg\":\"HS256\",\"kid\":\"k1\"}") + "." +
+        Base64Encode::EncodeUrl("{\"iss\":\"alice\",\"iss\":\"bob\"}");
+    std::string token =
+        signed_area + "." + Base64Encode::EncodeUrl(alice.Digest(signed_area));
+
+    std::string kid, iss;
+    IssuerRegistry::Peek(token.data(), token.size(), &kid, &iss);
+    EXPECT_EQ("k1", kid);
+    EXPECT_EQ("alice", iss);
+    ASSERT_THROW(registry.Decode(token), InvalidClaimError);
+}
+
+TEST_F(TokenTest, issuer_registry_checks_limits_first) {
+    DecodeLimits limits;
+    limits.max_token = 256;
+    limits.max_sections.payload = 64;
+    IssuerRegistry registry(limits);
+    registry.Load({{"alice",
+                    {{"validator", {{"HS256", {{"secret", "alice"}}}}},
+                     {"claims", {{"exp", nullptr}}}}}});
+
+    HS256Validator alice("alice"), bob("bob");
+    ::json header, payload;
+    std::tie(header, payload) = registry.Decode(
+        JWT::Encode(alice, {{"iss", "alice"}, {"exp", 4102444800}}));
+    EXPECT_EQ("alice", payload["iss"]);
+
+    // The precheck rejects an expired token before its signature.
+    ASSERT_THROW(
+        registry.Decode(JWT::Encode(bob, {{"iss", "alice"}, {"exp", 1}})),
+        InvalidClaimError);
+
+    // Rejected by size before the payload is decoded, even with a bad iss.
+    std::string large = JWT::Encode(
+        alice, {{"iss", "carol"}, {"data", std::string(64, 'x')}});
+    ASSERT_THROW(registry.Decode(large), TokenFormatError);
+    ASSERT_THROW(registry.Decode(large + std::string(256, 'x')),
+                 TokenFormatError);
+
+    std::string iss;
+    IssuerRegistry::Peek(large.data(), large.size(), nullptr, &iss);
+    EXPECT_EQ("carol", iss);
+}
+
+TEST_F(TokenTest, precheck_rejects_before_signature) {
+    claim_ptr claims(ClaimValidatorFactory::Build(::json::parse(
+        "{ \"all\" : [ { \"exp\" : null }, { \"jti\" : null }, "
+        "{ \"any\" : [ { \"iss\" : [\"foo\"] }, { \"sub\" : [\"bar\"] } ] } ] }")));
+    DecodeLimits limits;
+    limits.max_token = 512;
+    Precheck precheck(claims.get(), limits);
+    // Only exp and the any over iss and sub, the jti validator is stateful.
+    EXPECT_EQ(2u, precheck.checks().size());
+
+    HS256Validator other("other");
+    std::string forged =
+        JWT::Encode(other, {{"exp", 1}, {"iss", "foo"}, {"jti", "a"}});
+    ASSERT_THROW(JWT::Decode(forged, &validator_, claims.get(), &precheck),
+                 InvalidClaimError);
+    forged = JWT::Encode(other, {{"exp", 4102444800}, {"iss", "foo"}, {"jti", "a"}});
+    ASSERT_THROW(JWT::Decode(forged, &validator_, claims.get(), &precheck),
+                 InvalidSignatureError);
+
+    std::string token = JWT::Encode(
+        validator_, {{"exp", 4102444800}, {"iss", "foo"}, {"jti", "a"}});
+    ValidToken(token, &validator_, claims.get());
+    ASSERT_THROW(JWT::Decode(token, &validator_, claims.get(), &precheck),
+                 InvalidClaimError);
+
+    std::string large = JWT::Encode(
+        validator_, {{"exp", 4102444800}, {"iss", std::string(512, 'a')}});
+    ASSERT_THROW(JWT::Decode(large, &validator_, claims.get(), &precheck),
+                 TokenFormatError);
+}
+
+TEST_F(TokenTest, decode_limits) {
+    DecodeLimits limits;
+    limits.max_sections = {64, 256, 64};
+    limits.max_sections_by_alg["HS256"] = {64, 128, 64};
+    limits.max_depth = 3;
+    limits.max_members = 16;
+    Precheck precheck(nullptr, limits);
+
+    std::string token = JWT::Encode(validator_, {{"a", {{"b", {1, 2}}}}});
+    ValidToken(token, &validator_, nullptr);
+    JWT::Decode(token, &validator_, nullptr, &precheck);
+
+    // Too deep, and too many members.
+    token = JWT::Encode(validator_, {{"a", {{"b", {{"c", {1}}}}}}});
+    ASSERT_THROW(JWT::Decode(token, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+    token = JWT::Encode(validator_, {{"a", std::vector<int>(16, 1)}});
+    ASSERT_THROW(JWT::Decode(token, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+
+    // The payload fits the limits of other algs, but not those of HS256.
+    token = JWT::Encode(validator_, {{"a", std::string(120, 'a')}});
+    ValidToken(token, &validator_, nullptr);
+    ASSERT_THROW(JWT::Decode(token, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+    token = JWT::Encode(validator_, {{"a", std::string(300, 'a')}});
+    ASSERT_THROW(JWT::Decode(token, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+
+    // Oversized signatures are rejected before they are decoded.
+    token = JWT::Encode(validator_, {{"a", 1}}) + std::string(64, 'A');
+    ASSERT_THROW(JWT::Decode(token, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+}
+
+TEST_F(TokenTest, projection_skips_claims) {
+    claim_ptr claims(ClaimValidatorFactory::Build(::json::parse(
+        "{ \"all\" : [ { \"exp\" : null }, "
+        "{ \"claim\" : { \"path\" : \"/cnf/jkt\", \"accepted\" : [\"a\"] } } ] }")));
+    ClaimProjection projection({"sub"}, claims.get());
+    EXPECT_FALSE(projection.keeps_all());
+    EXPECT_EQ(std::vector<std::string>({"cnf", "exp", "sub"}),
+              projection.claims());
+
+    ::json full = {{"sub", "1"},
+                   {"exp", 4102444800},
+                   {"cnf", {{"jkt", "a"}, {"x", {1, {{"y", nullptr}}}}}},
+                   {"groups", {"a", "b", {{"c", {1, 2}}}}},
+                   {"name", "John Doe"}};
+    std::string token = JWT::Encode(validator_, full);
+    ::json header, payload;
+    std::tie(header, payload) =
+        JWT::Decode(token, projection, &validator_, claims.get());
+    full.erase("groups");
+    full.erase("name");
+    EXPECT_EQ(full, payload);
+
+    token = JWT::Encode(validator_, {{"exp", 4102444800}, {"cnf", "a"}});
+    ASSERT_THROW(JWT::Decode(token, projection, &validator_, claims.get()),
+                 InvalidClaimError);
+
+    DecodeLimits limits;
+    limits.max_depth = 2;
+    Precheck precheck(nullptr, limits);
+    token = JWT::Encode(validator_, {{"skipped", {{"a", {1}}}}});
+    ASSERT_THROW(JWT::Decode(token, projection, &validator_, nullptr, &precheck),
+                 TokenFormatError);
+    ASSERT_THROW(projection.Parse("{\"sub\": ", 8), TokenFormatError);
+}
+
+// A validator that does not say which claims it reads.
+class AnyClaims : public ClaimValidator {
+   public:
+    AnyClaims() : ClaimValidator("") {}
+    bool IsValid(const json &) const { return true; }
+    std::string toJson() const { return "{}"; }
+};
+
+TEST_F(TokenTest, projection_keeps_all_for_custom_validators) {
+    AnyClaims any;
+    ClaimProjection projection({"sub"}, &any);
+    EXPECT_TRUE(projection.keeps_all());
+    ::json payload = projection.Parse("{\"a\":1,\"sub\":\"b\"}", 17);
+    EXPECT_EQ(::json({{"a", 1}, {"sub", "b"}}), payload);
+    EXPECT_EQ(::json::array({1, {{"a", 2}}}),
+              ClaimProjection({}).Parse("[1,{\"a\":2}]", 11));
+}
+
+// Claims decoded by JWT::Decode<T>.
+struct TokenSession : RegisteredClaims {
+    std::string name;
+    bool admin = false;
+    std::vector<std::string> groups;
+    ::json cnf;
+    static void Describe(ClaimFields<TokenSession> *fields) {
+        fields->Add("name", &TokenSession::name)
+            .Add("admin", &TokenSession::admin)
+            .Add("groups", &TokenSession::groups)
+            .Add("cnf", &TokenSession::cnf);
+    }
+};
+
+TEST_F(TokenTest, typed_decode_fills_fields) {
+    std::string token = JWT::Encode(
+        validator_, {{"sub", "1"},
+                     {"aud", "a"},
+                     {"exp", 4102444800},
+                     {"iat", "yesterday"},
+                     {"name", "John Doe"},
+                     {"groups", {"x", "y"}},
+                     {"cnf", {{"jkt", "k"}}},
+                     {"skipped", {1, 2, {{"a", nullptr}}}}});
+    ::json header;
+    TokenSession session;
+    std::tie(header, session) = JWT::Decode<TokenSession>(token, &validator_);
+    EXPECT_EQ("HS256", header["alg"]);
+    EXPECT_TRUE(session.has(RegisteredClaims::kSub));
+    EXPECT_EQ("1", session.sub);
+    EXPECT_EQ(std::vector<std::string>({"a"}), session.aud);
+    EXPECT_EQ(4102444800, session.exp);
+    EXPECT_FALSE(session.has(RegisteredClaims::kIat));
+    EXPECT_FALSE(session.has(RegisteredClaims::kIss));
+    EXPECT_EQ("John Doe", session.name);
+    EXPECT_FALSE(session.admin);
+    EXPECT_EQ(std::vector<std::string>({"x", "y"}), session.groups);
+    EXPECT_EQ(::json({{"jkt", "k"}}), session.cnf);
+
+    token = JWT::Encode(validator_, {{"admin", "yes"}});
+    ASSERT_THROW(JWT::Decode<TokenSession>(token, &validator_),
+                 TokenFormatError);
+    token = JWT::Encode(validator_, {1, 2});
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token), TokenFormatError);
+}
+
+TEST_F(TokenTest, typed_decode_validates_claims) {
+    claim_ptr claims(ClaimValidatorFactory::Build(::json::parse(
+        "{ \"all\" : [ { \"exp\" : null }, { \"aud\" : [\"a\", \"b\"] }, "
+        "{ \"optional\" : { \"iss\" : [\"foo\"] } }, "
+        "{ \"claim\" : { \"path\" : \"/cnf/jkt\", \"accepted\" : [\"k\"] } } ] }")));
+    std::string token = JWT::Encode(
+        validator_, {{"aud", {"c", "b"}}, {"exp", 4102444800}, {"cnf", {{"jkt", "k"}}}});
+    RegisteredClaims registered;
+    std::tie(std::ignore, registered) =
+        JWT::Decode<RegisteredClaims>(token, &validator_, claims.get());
+    EXPECT_EQ(std::vector<std::string>({"c", "b"}), registered.aud);
+
+    token = JWT::Encode(validator_, {{"aud", "b"}, {"exp", 1}, {"cnf", {{"jkt", "k"}}}});
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token, &validator_, claims.get()),
+                 InvalidClaimError);
+    token = JWT::Encode(validator_, {{"aud", "b"}, {"exp", 4102444800},
+                                     {"iss", 1}, {"cnf", {{"jkt", "k"}}}});
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token, &validator_, claims.get()),
+                 InvalidClaimError);
+    token = JWT::Encode(validator_, {{"aud", "b"}, {"exp", 4102444800},
+                                     {"cnf", {{"jkt", "x"}}}});
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token, &validator_, claims.get()),
+                 InvalidClaimError);
+
+    Precheck precheck(claims.get());
+    token = JWT::Encode(validator_, {{"aud", "b"}, {"exp", 1}}) + "AAAA";
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token, &validator_, claims.get(),
+                                               &precheck),
+                 InvalidClaimError);
+
+    AnyClaims any;
+    token = JWT::Encode(validator_, {{"sub", "1"}});
+    std::tie(std::ignore, registered) =
+        JWT::Decode<RegisteredClaims>(token, &validator_, &any);
+    EXPECT_EQ("1", registered.sub);
+}
+
+// A subject check that rejects every subject.
+class ClosedSubValidator : public SubValidator {
+   public:
+    ClosedSubValidator() : SubValidator({"1"}) {}
+    ClaimStatus Check(const json &) const {
+        return ClaimStatus::Error("closed");
+    }
+};
+
+TEST_F(TokenTest, typed_decode_calls_overridden_checks) {
+    ClosedSubValidator closed;
+    std::string token = JWT::Encode(validator_, {{"sub", "1"}});
+    ASSERT_THROW(JWT::Decode<RegisteredClaims>(token, &validator_, &closed),
+                 InvalidClaimError);
+}
@@ -0,0 +1,177 @@
+#include <fstream>
+#include <memory>
+#include <string>
+#include "./constants.h"
+#include "gtest/gtest.h"
+#include "jwt/jwt_all.h"
+
+class BundleTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() override {
+        validator_ = {
+            {"set",
+             {{{"kid",
+                {{"rsa", {{"RS256", {{"public", pubkey}}}}},
+                 {"ec", {{"ES256", {{"public", ecpubkey}}}}},
+                 {"ed", {{"EdDSA", {{"public", edpubkey}}}}},
+                 {"hmac", {{"HS384", {{"secret", "secret"}}}}}}}},
+              {{"HS256", {{"secret", "secret"}}}}}}};
+        claims_ = {{"all",
+                    {{{"iss", {"foo", "bar"}}},
+                     {{"exp", {{"leeway", 10}}}},
+                     {{"optional", {{"aud", {"foo"}}}}}}}};
+    }
+
+    Bundle *RoundTrip(const std::string &bundle) {
+        return Bundle::Parse(reinterpret_cast<const uint8_t *>(bundle.data()),
+                             bundle.size());
+    }
+
+    ::json validator_;
+    ::json claims_;
+};
+
+TEST_F(BundleTest, same_as_json) {
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_, claims_)));
+    validator_ptr validator(MessageValidatorFactory::Build(validator_));
+    std::unique_ptr<ClaimValidator> claims(ClaimValidatorFactory::Build(claims_));
+
+    EXPECT_EQ(::json::parse(validator->toJson()),
+              ::json::parse(bundle->validator()->toJson()));
+    EXPECT_EQ(::json::parse(claims->toJson()),
+              ::json::parse(bundle->claims()->toJson()));
+}
+
+TEST_F(BundleTest, validates_tokens) {
+    // A set dispatches on the algorithm, so only use the kid validator.
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_["set"][0], claims_)));
+
+    ::json payload = {{"iss", "foo"}, {"exp", 4102444800}};
+    std::string tokens[] = {
+        JWT::Encode(RS256Validator(pubkey, privkey), payload, {{"kid", "rsa"}}),
+        JWT::Encode(ES256Validator(ecpubkey, ecprivkey), payload,
+                    {{"kid", "ec"}}),
+        JWT::Encode(EdDSAValidator(edpubkey, edprivkey), payload,
+                    {{"kid", "ed"}}),
+        JWT::Encode(HS384Validator("secret"), payload, {{"kid", "hmac"}})};
+    for (auto &token : tokens) {
+        EXPECT_NO_THROW(
+            JWT::Decode(token, bundle->validator(), bundle->claims()));
+    }
+
+    std::string wrong_issuer =
+        JWT::Encode(HS384Validator("secret"), {{"iss", "baz"}, {"exp", 4102444800}},
+                    {{"kid", "hmac"}});
+    EXPECT_THROW(
+        JWT::Decode(wrong_issuer, bundle->validator(), bundle->claims()),
+        InvalidClaimError);
+}
+
+TEST_F(BundleTest, load_from_file) {
+    {
+        std::ofstream out("/tmp/test.key");
+        out << pubkey;
+    }
+    ::json validator = {
+        {"RS256", {{"public", {{"fromfile", "/tmp/test.key"}, {"watch", true}}}}}};
+    std::string compiled = Bundle::Compile(validator, nullptr);
+    {
+        std::ofstream out("/tmp/test.bundle", std::ios::binary);
+        out.write(compiled.data(), compiled.size());
+    }
+
+    std::unique_ptr<Bundle> bundle(Bundle::Load("/tmp/test.bundle"));
+    EXPECT_EQ(nullptr, bundle->claims());
+    std::string token =
+        JWT::Encode(RS256Validator(pubkey, privkey), {{"sub", "subject"}});
+    EXPECT_NO_THROW(JWT::Decode(token, bundle->validator()));
+}
+
+TEST_F(BundleTest, interns_strings) {
+    ::json twice = {{"kid",
+                     {{"a", {{"RS256", {{"public", pubkey}}}}},
+                      {"b", {{"RS256", {{"public", pubkey}}}}}}}};
+    ::json once = {{"kid", {{"a", {{"RS256", {{"public", pubkey}}}}}}}};
+    size_t two = Bundle::Compile(twice, nullptr).size();
+    size_t one = Bundle::Compile(once, nullptr).size();
+
+    // Only the kid and its node are added, the key is shared.
+    EXPECT_GT(200u, two - one);
+}
+
+TEST_F(BundleTest, rejects_invalid_bundles) {
+    std::string compiled = Bundle::Compile(validator_, claims_);
+    for (size_t i = 0; i < compiled.size(); i++) {
+        EXPECT_THROW(RoundTrip(compiled.substr(0, i)), std::logic_error);
+    }
+
+    std::string version = compiled;
+    version[4] = 1;
+    EXPECT_THROW(RoundTrip(version), std::logic_error);
+    EXPECT_THROW(RoundTrip(compiled + "x"), std::logic_error);
+    EXPECT_THROW(Bundle::Load("/tmp/does/not/exist"), std::logic_error);
+}
+
+TEST_F(BundleTest, rejects_deep_nesting) {
+    ::json shallow = {{"iss", {"foo"}}};
+    for (int i = 0; i < 32; i++) {
+        shallow = {{"optional", shallow}};
+    }
+    ::json deep = shallow;
+    for (int i = 0; i < 1000; i++) {
+        deep = {{"optional", deep}};
+    }
+
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_, shallow)));
+    EXPECT_EQ(shallow, ::json::parse(bundle->claims()->toJson()));
+    EXPECT_THROW(RoundTrip(Bundle::Compile(validator_, deep)),
+                 std::logic_error);
+}
+
+TEST_F(BundleTest, rejects_invalid_config) {
+    EXPECT_THROW(Bundle::Compile({{"XS256", nullptr}}, nullptr),
+                 std::logic_error);
+    EXPECT_THROW(Bundle::Compile(validator_, {{"xxx", nullptr}}),
+                 std::logic_error);
+}
+
+TEST_F(BundleTest, keeps_coarse_clock) {
+    ::json claims = {{"nbf", {{"leeway", 5}, {"clock", "coarse"}}}};
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_, claims)));
+    std::unique_ptr<ClaimValidator> expected(ClaimValidatorFactory::Build(claims));
+
+    EXPECT_EQ(::json::parse(expected->toJson()),
+              ::json::parse(bundle->claims()->toJson()));
+}
+
+TEST_F(BundleTest, keeps_nested_claims) {
+    ::json claims = {
+        {"claim", {{"path", "/cnf/jkt"}, {"accepted", {"abc", "def"}}}}};
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_, claims)));
+
+    EXPECT_EQ(claims, ::json::parse(bundle->claims()->toJson()));
+    ::json payload = {{"cnf", {{"jkt", "def"}}}};
+    EXPECT_TRUE(bundle->claims()->IsValid(payload));
+
+    // A plain list on aud does not become an aud validator.
+    claims = {{"claim", {{"path", "aud"}, {"accepted", {"abc"}}}}};
+    bundle.reset(RoundTrip(Bundle::Compile(validator_, claims)));
+    EXPECT_EQ(claims, ::json::parse(bundle->claims()->toJson()));
+    EXPECT_FALSE(bundle->claims()->Check({{"aud", {"abc"}}}).valid());
+}
+
+TEST_F(BundleTest, keeps_adaptive_order) {
+    ::json claims = {
+        {"adaptive",
+         {{"any", {{{"iss", {"foo"}}}, {{"sub", {"bar"}}}}}}}};
+    std::unique_ptr<Bundle> bundle(
+        RoundTrip(Bundle::Compile(validator_, claims)));
+
+    EXPECT_EQ(claims, ::json::parse(bundle->claims()->toJson()));
+    EXPECT_TRUE(bundle->claims()->IsValid({{"sub", "bar"}}));
+}
@@ -149,3 +149,182 @@ TEST(parse, round_trip_option) {
   OptionalClaimValidator validator(&val1);
   roundtrip(&validator);
 }
+
+TEST(compile_test, matches_tree) {
+  std::vector<std::string> configs = {
+      "{ \"iss\" : [\"foo\", \"bar\"] }",
+      "{ \"aud\" : [\"foo\"] }",
+      "{ \"exp\" : null }",
+      "{ \"nbf\" : { \"leeway\" : 32 } }",
+      "{ \"optional\" : { \"exp\" : { \"leeway\" : 32} } }",
+      "{ \"all\" : [ { \"optional\" : { \"exp\" : null } }, "
+      "{ \"iss\" : [\"foo\", \"bar\"] } ] }",
+      "{ \"any\" : [ { \"sub\" : [\"foo\"] }, { \"all\" : [ "
+      "{ \"aud\" : [\"bar\"] }, { \"iat\" : null } ] } ] }",
+      "{ \"optional\" : { \"any\" : [ { \"sub\" : [\"foo\"] } ] } }",
+      "{ \"adaptive\" : { \"all\" : [ { \"optional\" : { \"exp\" : null } }, "
+      "{ \"iss\" : [\"foo\", \"bar\"] } ] } }",
+  };
+  std::vector<::json> claimsets = {
+      ::json::object(),
+      {{"iss", "foo"}},
+      {{"iss", "baz"}, {"exp", 1}},
+      {{"iss", "bar"}, {"exp", 4102444800}},
+      {{"aud", {"x", "foo"}}, {"nbf", 4102444800}},
+      {{"aud", "bar"}, {"iat", 9}},
+      {{"aud", "bar"}, {"iat", "9"}},
+      {{"sub", "foo"}, {"exp", -1}},
+      {{"sub", 12}, {"nbf", 9}},
+  };
+
+  for (auto &config : configs) {
+    claim_ptr tree(ClaimValidatorFactory::Build(config));
+    claim_ptr compiled(ClaimValidatorFactory::Compile(config));
+    EXPECT_EQ(tree->toJson(), compiled->toJson());
+    EXPECT_EQ(tree->property(), compiled->property());
+    for (auto &claimset : claimsets) {
+      bool tree_valid = true, compiled_valid = true;
+      try {
+        tree->IsValid(claimset);
+      } catch (InvalidClaimError &ice) {
+        tree_valid = false;
+      }
+      try {
+        compiled->IsValid(claimset);
+      } catch (InvalidClaimError &ice) {
+        compiled_valid = false;
+      }
+      EXPECT_EQ(tree_valid, compiled_valid) << config << " " << claimset;
+    }
+  }
+}
+
+TEST(compile_test, reports_failure) {
+  claim_ptr compiled(ClaimValidatorFactory::Compile(
+      std::string("{ \"iss\" : [\"foo\"] }")));
+  ::json claims = {{"iss", "bar"}};
+  try {
+    compiled->IsValid(claims);
+    FAIL();
+  } catch (InvalidClaimError &ice) {
+    EXPECT_STREQ("Validator invalid: iss", ice.what());
+  }
+}
+
+TEST(compile_test, bad_json) {
+  ASSERT_THROW(ClaimValidatorFactory::Compile(std::string("{ \"foo\" : 1 }")),
+               std::logic_error);
+}
+
+TEST(parse_test, coarse_clock) {
+  std::string json = "{ \"exp\" : { \"leeway\" : 0, \"clock\" : \"coarse\" } }";
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  ::json exp = {{"exp", 4102444800}};
+  EXPECT_TRUE(valid->IsValid(exp));
+  exp["exp"] = 1;
+  ASSERT_THROW(valid->IsValid(exp), InvalidClaimError);
+  EXPECT_EQ(::json::parse(json), ::json::parse(valid->toJson()));
+}
+
+TEST(parse_test, unknown_clock) {
+  std::string json = "{ \"nbf\" : { \"clock\" : \"sundial\" } }";
+  ASSERT_THROW(ClaimValidatorFactory::Build(json), std::logic_error);
+}
+
+TEST(parse_test, time_not_an_object) {
+  std::string json = "{ \"iat\" : 12 }";
+  ASSERT_THROW(ClaimValidatorFactory::Build(json), std::logic_error);
+}
+
+TEST(parse_test, jti) {
+  claim_ptr defaults(ClaimValidatorFactory::Build(std::string("{ \"jti\" : null }")));
+  ::json token = {{"jti", "once"}};
+  EXPECT_TRUE(defaults->IsValid(token));
+  ASSERT_THROW(defaults->IsValid(token), InvalidClaimError);
+
+  std::string json = "{ \"jti\" : { \"entries\" : 10, \"ttl\" : 60 } }";
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  EXPECT_EQ(::json::parse(json), ::json::parse(valid->toJson()));
+}
+
+TEST(parse_test, revoked) {
+  RevocationWriter writer;
+  writer.Add("jti", "revoked");
+  writer.Write("/tmp/factory.revocations");
+
+  std::string json = "{ \"revoked\" : { \"file\" : "
+                     "\"/tmp/factory.revocations\", \"watch\" : false } }";
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  ::json revoked = {{"jti", "revoked"}};
+  ::json fine = {{"jti", "fine"}};
+  ASSERT_THROW(valid->IsValid(revoked), InvalidClaimError);
+  EXPECT_TRUE(valid->IsValid(fine));
+
+  ::json expected = ::json::parse(json);
+  expected["revoked"]["claims"] = {"jti", "sub"};
+  EXPECT_EQ(expected, ::json::parse(valid->toJson()));
+}
+
+TEST(parse_test, scope) {
+  std::string json = "{ \"scope\" : { \"claim\" : \"roles\", "
+                     "\"required\" : [\"user\"], \"any\" : [\"a\", \"b\"] } }";
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  ::json roles = {{"roles", {"user", "b"}}};
+  EXPECT_TRUE(valid->IsValid(roles));
+  EXPECT_EQ(::json::parse(json), ::json::parse(valid->toJson()));
+
+  claim_ptr scope(ClaimValidatorFactory::Build(
+      std::string("{ \"scope\" : { \"required\" : [\"read\"] } }")));
+  ::json scopes = {{"scope", "openid read"}};
+  EXPECT_TRUE(scope->IsValid(scopes));
+  ASSERT_THROW(ClaimValidatorFactory::Build(std::string("{ \"scope\" : {} }")),
+               std::logic_error);
+}
+
+TEST(parse_test, nested_claim) {
+  std::string json = "{ \"all\" : [ "
+                     "{ \"claim\" : { \"path\" : \"/cnf/jkt\", \"accepted\" : [\"abc\"] } }, "
+                     "{ \"scope\" : { \"claim\" : \"/realm_access/roles\", \"required\" : [\"admin\"] } } ] }";
+  ::json claims = {{"cnf", {{"jkt", "abc"}}},
+                   {"realm_access", {{"roles", {"admin"}}}}};
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  claim_ptr compiled(ClaimValidatorFactory::Compile(json));
+  EXPECT_TRUE(valid->IsValid(claims));
+  EXPECT_TRUE(compiled->IsValid(claims));
+  EXPECT_EQ(::json::parse(json), ::json::parse(valid->toJson()));
+
+  claims["cnf"]["jkt"] = "def";
+  ASSERT_THROW(valid->IsValid(claims), InvalidClaimError);
+  ASSERT_THROW(compiled->IsValid(claims), InvalidClaimError);
+
+  ASSERT_THROW(ClaimValidatorFactory::Build(std::string(
+                   "{ \"claim\" : { \"path\" : \"/a~9\", \"accepted\" : [] } }")),
+               std::logic_error);
+}
+
+TEST(parse_test, plain_list_on_registered_claim) {
+  ListClaimValidator list("aud", {"abc"});
+  claim_ptr rebuilt(ClaimValidatorFactory::Build(list.toJson()));
+  ::json claims = {{"aud", {"abc"}}};
+  EXPECT_FALSE(list.Check(claims).valid());
+  EXPECT_FALSE(rebuilt->Check(claims).valid());
+  EXPECT_EQ(::json::parse(list.toJson()), ::json::parse(rebuilt->toJson()));
+
+  AudValidator aud({"abc"});
+  EXPECT_EQ(::json::parse("{ \"aud\" : [\"abc\"] }"), ::json::parse(aud.toJson()));
+}
+
+TEST(parse_test, adaptive) {
+  std::string json = "{ \"adaptive\" : { \"any\" : [ "
+                     "{ \"iss\" : [\"foo\"] }, { \"sub\" : [\"bar\"] } ] } }";
+  claim_ptr valid(ClaimValidatorFactory::Build(json));
+  EXPECT_EQ(::json::parse(json), ::json::parse(valid->toJson()));
+  for (int i = 0; i < 4096; i++) {
+    EXPECT_TRUE(valid->IsValid({{"sub", "bar"}}));
+  }
+  ASSERT_THROW(valid->IsValid({{"sub", "foo"}}), InvalidClaimError);
+
+  ASSERT_THROW(ClaimValidatorFactory::Build(std::string(
+                   "{ \"adaptive\" : { \"iss\" : [\"foo\"] } }")),
+               std::logic_error);
+}
@@ -1,8 +1,23 @@
 #include "./constants.h"
 #include "jwt/allocators.h"
+#include "jwt/claimpath.h"
 #include "jwt/claimvalidator.h"
+#include "jwt/claimvalidatorfactory.h"
+#include "jwt/jtireplayvalidator.h"
 #include "jwt/listclaimvalidator.h"
+#include "jwt/policyset.h"
+#include "jwt/revocationvalidator.h"
+#include "jwt/scopevalidator.h"
+#include "jwt/staticpolicy.h"
 #include "jwt/timevalidator.h"
+#include "private/adaptiveorder.h"
+#include "private/claimprogram.h"
+#include "private/stringset.h"
+#include "private/timingwheel.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <thread>
 #include "gtest/gtest.h"
 #include <string>
 
@@ -28,6 +43,17 @@ TEST(clock, clock_test) {
   EXPECT_LT(now, later);
 }
 
+TEST(clock, coarse_clock_test) {
+  UtcClock utc;
+  CoarseClock coarse;
+  uint64_t before = utc.Now();
+  uint64_t now = coarse.Now();
+  uint64_t after = utc.Now();
+  // The coarse clock may lag up to a tick behind.
+  EXPECT_LE(before, now + 1);
+  EXPECT_LE(now, after);
+}
+
 TEST(iat_test, before) {
   json json = {{"iat", 9}};
   IatValidator iat(0, &fakeClock);
@@ -270,3 +296,723 @@ TEST(option_test, optional_value_missing) {
   OptionalClaimValidator option(&iss);
   EXPECT_TRUE(option.IsValid(json));
 }
+
+// Runs the tree and the program compiled from it, both must agree.
+static void expect_same(const ClaimValidator &tree, const json &claimset) {
+  ClaimProgram program(&tree);
+  bool valid = true;
+  try {
+    tree.IsValid(claimset);
+  } catch (const InvalidClaimError &ice) {
+    valid = false;
+  }
+  EXPECT_EQ(valid, program.Run(claimset).valid()) << claimset.dump();
+}
+
+TEST(program_test, time_matches_tree) {
+  IatValidator iat(0, &fakeClock);
+  NbfValidator nbf(2, &fakeClock);
+  ExpValidator exp(0, &fakeClock);
+  ExpValidator exp_leeway(3, &fakeClock);
+  for (int time = -2; time < 20; time++) {
+    json json = {{"iat", time}, {"nbf", time}, {"exp", time}};
+    expect_same(iat, json);
+    expect_same(nbf, json);
+    expect_same(exp, json);
+    expect_same(exp_leeway, json);
+  }
+  expect_same(iat, {{"iat", "foo"}});
+  expect_same(exp, {{"iat", 9}});
+}
+
+TEST(program_test, list_matches_tree) {
+  IssValidator iss(accepted);
+  AudValidator aud(accepted);
+  std::vector<json> claimsets = {
+      {{"iss", "foo"}},       {{"iss", "baz"}},        {{"iss", 12}},
+      {{"aud", "bar"}},       {{"aud", {"baz", "foo"}}}, {{"aud", {1, "x"}}},
+      {{"aud", {{"a", 1}}}},  json::array(),           {{"sub", "foo"}}};
+  for (auto &claimset : claimsets) {
+    expect_same(iss, claimset);
+    expect_same(aud, claimset);
+  }
+}
+
+TEST(program_test, nested_matches_tree) {
+  AudValidator aud(accepted);
+  SubValidator sub(accepted);
+  ExpValidator exp(0, &fakeClock);
+  OptionalClaimValidator optional_exp(&exp);
+  std::vector<ClaimValidator *> either = {&aud, &sub};
+  AnyClaimValidator any(either);
+  std::vector<ClaimValidator *> both = {&optional_exp, &any};
+  AllClaimValidator all(both);
+  OptionalClaimValidator optional_all(&all);
+
+  std::vector<json> claimsets = {
+      {{"sub", "foo"}},  {{"sub", "foo"}, {"exp", 9}},
+      {{"aud", "bar"}, {"exp", 12}}, {{"exp", 12}}, {{"aud", {"x", "bar"}}},
+      {{"sub", "baz"}, {"aud", "baz"}}, json::object()};
+  for (auto &claimset : claimsets) {
+    expect_same(any, claimset);
+    expect_same(all, claimset);
+    expect_same(optional_all, claimset);
+  }
+}
+
+TEST(program_test, reports_tree_status) {
+  ExpValidator exp(0, &fakeClock);
+  AudValidator aud(accepted);
+  std::vector<json> claimsets = {
+      {{"exp", 9}},  {{"exp", -1}}, {{"exp", "x"}}, {{"aud", 1}},
+      {{"aud", {"x"}}}, {{"aud", "x"}}, json::object()};
+  for (auto &claimset : claimsets) {
+    EXPECT_EQ(exp.Check(claimset).code(),
+              ClaimProgram(&exp).Run(claimset).code()) << claimset.dump();
+    EXPECT_EQ(aud.Check(claimset).code(),
+              ClaimProgram(&aud).Run(claimset).code()) << claimset.dump();
+  }
+}
+
+TEST(program_test, compiles_only_shared_lookups) {
+  std::unique_ptr<ClaimValidator> flat(ClaimValidatorFactory::Compile(
+      std::string("{ \"all\" : [ { \"iss\" : [\"a\"] }, "
+                  "{ \"sub\" : [\"b\"] } ] }")));
+  EXPECT_EQ(nullptr, dynamic_cast<CompiledClaimValidator *>(flat.get()));
+
+  std::unique_ptr<ClaimValidator> shared(ClaimValidatorFactory::Compile(
+      std::string("{ \"any\" : [ { \"iss\" : [\"a\"] }, "
+                  "{ \"iss\" : [\"b\"] } ] }")));
+  EXPECT_NE(nullptr, dynamic_cast<CompiledClaimValidator *>(shared.get()));
+  EXPECT_TRUE(shared->IsValid({{"iss", "b"}}));
+}
+
+class RejectAll : public ClaimValidator {
+public:
+  RejectAll() : ClaimValidator("reject") {}
+  bool IsValid(const json &claimset) const {
+    throw InvalidClaimError("rejected");
+  }
+  std::string toJson() const { return "{ \"reject\" : null }"; }
+};
+
+TEST(program_test, calls_unknown_validators) {
+  RejectAll reject;
+  SubValidator sub(accepted);
+  std::vector<ClaimValidator *> claims = {&reject, &sub};
+  AnyClaimValidator any(claims);
+  ClaimProgram program(&reject);
+
+  ClaimStatus status = program.Run({{"sub", "foo"}});
+  EXPECT_EQ(ClaimStatus::kError, status.code());
+  EXPECT_STREQ("rejected", status.message().c_str());
+  expect_same(any, {{"sub", "foo"}});
+  expect_same(any, {{"sub", "baz"}});
+}
+
+// An issuer check that has been closed, it rejects every issuer.
+class ClosedIssValidator : public IssValidator {
+public:
+  ClosedIssValidator() : IssValidator(::accepted) {}
+  ClaimStatus Check(const json &claimset) const {
+    return ClaimStatus::Error("closed");
+  }
+};
+
+TEST(program_test, calls_overridden_leaves) {
+  ClosedIssValidator closed;
+  ExpValidator exp(0, &fakeClock);
+  std::vector<ClaimValidator *> claims = {&exp, &closed};
+  AllClaimValidator all(claims);
+  ClaimProgram program(&all);
+
+  ClaimStatus status = program.Run({{"exp", 12}, {"iss", "foo"}});
+  EXPECT_EQ(ClaimStatus::kError, status.code());
+  EXPECT_STREQ("closed", status.message().c_str());
+  expect_same(all, {{"exp", 12}, {"iss", "foo"}});
+}
+
+TEST(status_test, codes) {
+  IssValidator iss(accepted);
+  ExpValidator exp(0, &fakeClock);
+  json missing = {{"sub", "foo"}};
+  json wrong_type = {{"iss", 12}, {"exp", "12"}};
+  json invalid = {{"iss", "baz"}, {"exp", 9}};
+  json negative = {{"exp", -1}};
+
+  EXPECT_EQ(ClaimStatus::kMissing, iss.Check(missing).code());
+  EXPECT_EQ(ClaimStatus::kWrongType, iss.Check(wrong_type).code());
+  EXPECT_EQ(ClaimStatus::kWrongType, exp.Check(wrong_type).code());
+  EXPECT_EQ(ClaimStatus::kInvalid, iss.Check(invalid).code());
+  EXPECT_EQ(ClaimStatus::kInvalid, exp.Check(invalid).code());
+  EXPECT_EQ(ClaimStatus::kNegative, exp.Check(negative).code());
+  EXPECT_STREQ("Validator: missing: iss", iss.Check(missing).message().c_str());
+  EXPECT_STREQ("Missing claim: exp", exp.Check(missing).message().c_str());
+  EXPECT_STREQ("Failed: exp", exp.Check(invalid).message().c_str());
+  AudValidator aud(accepted);
+  EXPECT_STREQ("Invalid: aud",
+               aud.Check({{"aud", {"baz"}}}).message().c_str());
+  EXPECT_STREQ("Validator invalid: aud",
+               aud.Check({{"aud", "baz"}}).message().c_str());
+  EXPECT_TRUE(iss.Check({{"iss", "foo"}}).valid());
+}
+
+TEST(status_test, any_does_not_throw) {
+  std::vector<IssValidator> issuers;
+  for (int i = 0; i < 20; i++) {
+    issuers.push_back(IssValidator({"issuer" + std::to_string(i)}));
+  }
+  std::vector<ClaimValidator *> claims;
+  for (auto &iss : issuers) {
+    claims.push_back(&iss);
+  }
+  AnyClaimValidator any(claims);
+
+  EXPECT_TRUE(any.Check({{"iss", "issuer19"}}).valid());
+  ClaimStatus status = any.Check({{"iss", "issuer20"}});
+  EXPECT_EQ(ClaimStatus::kNoneValid, status.code());
+  EXPECT_STREQ("None of the children validate", status.message().c_str());
+}
+
+TEST(status_test, custom_validator) {
+  RejectAll reject;
+  OptionalClaimValidator optional(&reject);
+  ClaimStatus status = optional.Check({{"reject", 1}});
+  EXPECT_EQ(ClaimStatus::kError, status.code());
+  EXPECT_STREQ("rejected", status.message().c_str());
+  EXPECT_TRUE(optional.Check({{"sub", 1}}).valid());
+}
+
+TEST(string_set, large) {
+  std::vector<std::string> values;
+  for (int i = 0; i < 5000; i++) {
+    values.push_back("issuer" + std::to_string(i));
+  }
+  values.push_back("issuer7");
+  values.push_back("");
+  StringSet set(values);
+
+  EXPECT_EQ(5001u, set.size());
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_TRUE(set.Contains("issuer" + std::to_string(i)));
+  }
+  EXPECT_TRUE(set.Contains(""));
+  EXPECT_FALSE(set.Contains("issuer5000"));
+  EXPECT_FALSE(set.Contains("issuer", 5));
+  EXPECT_FALSE(StringSet(std::vector<std::string>()).Contains(""));
+}
+
+TEST(string_set, large_aud) {
+  std::vector<std::string> values;
+  for (int i = 0; i < 5000; i++) {
+    values.push_back("aud" + std::to_string(i));
+  }
+  AudValidator aud(values);
+  EXPECT_TRUE(aud.Check({{"aud", {1, "x", "aud4999"}}}).valid());
+  EXPECT_FALSE(aud.Check({{"aud", {"x", "aud5000"}}}).valid());
+}
+
+class SettableClock : public IClock {
+public:
+  explicit SettableClock(uint64_t now) : now_(now) {}
+  uint64_t Now() { return now_; }
+  void Set(uint64_t now) { now_ = now; }
+
+private:
+  uint64_t now_;
+};
+
+TEST(timing_wheel, expires_in_order) {
+  TimingWheel<int> wheel(1000);
+  std::vector<int> expiries = {1001, 1063, 1064, 1065, 5000, 300000,
+                               1000 + TimingWheel<int>::kHorizon * 2};
+  for (size_t i = 0; i < expiries.size(); i++) {
+    EXPECT_TRUE(wheel.Add(i, expiries[i]));
+  }
+  EXPECT_FALSE(wheel.Add(99, 1000));
+
+  std::vector<int> expired;
+  auto collect = [&expired](int value) { expired.push_back(value); };
+  for (size_t i = 0; i + 1 < expiries.size(); i++) {
+    wheel.Advance(expiries[i] - 1, collect);
+    EXPECT_EQ(i, expired.size()) << expiries[i];
+    wheel.Advance(expiries[i], collect);
+    ASSERT_EQ(i + 1, expired.size()) << expiries[i];
+    EXPECT_EQ(static_cast<int>(i), expired.back());
+  }
+
+  // Kept beyond the horizon until it expires.
+  EXPECT_EQ(1, wheel.size());
+  wheel.Advance(1000 + TimingWheel<int>::kHorizon, collect);
+  EXPECT_EQ(1, wheel.size());
+  wheel.Advance(expiries.back() - 1, collect);
+  EXPECT_EQ(expiries.size() - 1, expired.size());
+  wheel.Advance(expiries.back(), collect);
+  EXPECT_EQ(expiries.size(), expired.size());
+  EXPECT_EQ(0, wheel.size());
+
+  // Skipping past the horizon keeps what has not expired yet.
+  uint64_t now = wheel.now();
+  wheel.Add(1, now + TimingWheel<int>::kHorizon * 4);
+  wheel.Add(2, now + TimingWheel<int>::kHorizon * 2);
+  wheel.Advance(now + TimingWheel<int>::kHorizon * 3, collect);
+  EXPECT_EQ(1, wheel.size());
+  EXPECT_EQ(2, expired.back());
+}
+
+TEST(jti_test, rejects_replays) {
+  SettableClock clock(1000);
+  JtiReplayValidator jti(100, 10, &clock);
+
+  json token = {{"jti", "a"}, {"exp", 1100}};
+  EXPECT_TRUE(jti.Check(token).valid());
+  EXPECT_EQ(ClaimStatus::kInvalid, jti.Check(token).code());
+  EXPECT_TRUE(jti.Check({{"jti", "b"}}).valid());
+  EXPECT_EQ(ClaimStatus::kMissing, jti.Check({{"sub", "b"}}).code());
+  EXPECT_EQ(ClaimStatus::kWrongType, jti.Check({{"jti", 1}}).code());
+  ASSERT_THROW(jti.IsValid(token), InvalidClaimError);
+  EXPECT_EQ(2, jti.size());
+}
+
+TEST(jti_test, forgets_expired_tokens) {
+  SettableClock clock(1000);
+  JtiReplayValidator jti(100, 10, &clock);
+
+  json with_exp = {{"jti", "a"}, {"exp", 1100}};
+  json without_exp = {{"jti", "b"}};
+  EXPECT_TRUE(jti.Check(with_exp).valid());
+  EXPECT_TRUE(jti.Check(without_exp).valid());
+
+  clock.Set(1009);
+  EXPECT_FALSE(jti.Check(without_exp).valid());
+  clock.Set(1010);
+  EXPECT_TRUE(jti.Check(without_exp).valid());
+  EXPECT_FALSE(jti.Check(with_exp).valid());
+
+  clock.Set(1100);
+  EXPECT_TRUE(jti.Check(with_exp).valid());
+}
+
+TEST(jti_test, remembers_beyond_horizon) {
+  SettableClock clock(1000);
+  JtiReplayValidator jti(100, 10, &clock);
+  uint64_t exp = 1000 + TimingWheel<const std::string *>::kHorizon * 2;
+  json token = {{"jti", "a"}, {"exp", exp}};
+  EXPECT_TRUE(jti.Check(token).valid());
+
+  clock.Set(exp - 1);
+  EXPECT_EQ(ClaimStatus::kInvalid, jti.Check(token).code());
+  clock.Set(exp);
+  EXPECT_TRUE(jti.Check(token).valid());
+}
+
+TEST(jti_test, bounded) {
+  SettableClock clock(1000);
+  JtiReplayValidator jti(16, 10, &clock);
+  size_t remembered = 0;
+  for (int i = 0; i < 100; i++) {
+    ClaimStatus status = jti.Check({{"jti", std::to_string(i)}});
+    if (status) {
+      remembered++;
+    } else {
+      EXPECT_EQ(ClaimStatus::kError, status.code());
+    }
+  }
+  EXPECT_LE(remembered, 16u);
+  EXPECT_EQ(remembered, jti.size());
+
+  // Shards forget expired ids as they are used.
+  clock.Set(1010);
+  EXPECT_TRUE(jti.Check({{"jti", "fresh"}}).valid());
+  EXPECT_LE(jti.size(), 16u);
+}
+
+TEST(jti_test, concurrent) {
+  JtiReplayValidator jti;
+  std::atomic<int> unique(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.push_back(std::thread([&jti, &unique]() {
+      for (int i = 0; i < 1000; i++) {
+        json token = {{"jti", std::to_string(i)}};
+        if (jti.Check(token)) {
+          unique++;
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1000, unique.load());
+}
+
+TEST(revocation_test, rejects_revoked_claims) {
+  RevocationWriter writer;
+  for (int i = 0; i < 10000; i++) {
+    writer.Add("jti", "token" + std::to_string(i));
+  }
+  writer.Add("sub", "mallory");
+  writer.Write("/tmp/test.revocations");
+
+  RevocationValidator revoked("/tmp/test.revocations", {"jti", "sub"}, false);
+  EXPECT_EQ(10001, revoked.size());
+  for (int i = 0; i < 10000; i++) {
+    json token = {{"jti", "token" + std::to_string(i)}};
+    EXPECT_EQ(ClaimStatus::kInvalid, revoked.Check(token).code());
+  }
+  for (int i = 10000; i < 20000; i++) {
+    json token = {{"jti", "token" + std::to_string(i)}, {"sub", "alice"}};
+    EXPECT_TRUE(revoked.Check(token).valid());
+  }
+
+  // Values are revoked for their claim only.
+  EXPECT_TRUE(revoked.Check({{"sub", "token1"}}).valid());
+  EXPECT_TRUE(revoked.Check({{"jti", "mallory"}}).valid());
+  EXPECT_FALSE(revoked.Check({{"sub", "mallory"}}).valid());
+  EXPECT_TRUE(revoked.Check({{"sub", 12}}).valid());
+  ASSERT_THROW(revoked.IsValid({{"sub", "mallory"}}), InvalidClaimError);
+}
+
+TEST(revocation_test, rejects_invalid_files) {
+  {
+    std::ofstream out("/tmp/test.notrevocations");
+    out << "JWTR but not quite";
+  }
+  EXPECT_THROW(RevocationValidator("/tmp/test.notrevocations", {"jti"}, false),
+               std::logic_error);
+  EXPECT_THROW(RevocationValidator("/tmp/does/not/exist", {"jti"}, false),
+               std::logic_error);
+}
+
+TEST(revocation_test, reloads) {
+  RevocationWriter first;
+  first.Add("jti", "first");
+  first.Write("/tmp/watched.revocations");
+
+  RevocationValidator revoked("/tmp/watched.revocations", {"jti"});
+  json token = {{"jti", "second"}};
+  EXPECT_TRUE(revoked.Check(token).valid());
+
+  RevocationWriter second;
+  second.Add("jti", "second");
+  second.Write("/tmp/watched.revocations");
+  for (int i = 0; i < 100 && revoked.Check(token).valid(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  EXPECT_FALSE(revoked.Check(token).valid());
+  EXPECT_TRUE(revoked.Check({{"jti", "first"}}).valid());
+
+  // A broken file keeps the current list.
+  {
+    std::ofstream out("/tmp/watched.revocations.tmp");
+    out << "garbage";
+  }
+  std::rename("/tmp/watched.revocations.tmp", "/tmp/watched.revocations");
+  EXPECT_FALSE(revoked.Reload());
+  EXPECT_FALSE(revoked.Check(token).valid());
+}
+
+TEST(scope_test, required) {
+  ScopeValidator scope("scope", {"read", "write"}, {});
+  EXPECT_TRUE(scope.Check({{"scope", "read write"}}).valid());
+  EXPECT_TRUE(scope.Check({{"scope", " write  other read "}}).valid());
+  EXPECT_TRUE(scope.Check({{"scope", {"write", 1, "read"}}}).valid());
+  EXPECT_EQ(ClaimStatus::kInvalid, scope.Check({{"scope", "read"}}).code());
+  EXPECT_EQ(ClaimStatus::kInvalid, scope.Check({{"scope", "readwrite"}}).code());
+  EXPECT_EQ(ClaimStatus::kInvalid, scope.Check({{"scope", ""}}).code());
+  EXPECT_EQ(ClaimStatus::kMissing, scope.Check({{"roles", "read"}}).code());
+  EXPECT_EQ(ClaimStatus::kWrongType, scope.Check({{"scope", 1}}).code());
+}
+
+TEST(scope_test, any_of) {
+  ScopeValidator roles("roles", {"user"}, {"admin", "owner"});
+  EXPECT_TRUE(roles.Check({{"roles", {"user", "owner"}}}).valid());
+  EXPECT_TRUE(roles.Check({{"roles", {"admin", "user"}}}).valid());
+  EXPECT_FALSE(roles.Check({{"roles", {"admin"}}}).valid());
+  EXPECT_FALSE(roles.Check({{"roles", {"user", "guest"}}}).valid());
+}
+
+TEST(scope_test, many_scopes) {
+  std::vector<std::string> required;
+  for (int i = 0; i < 300; i += 3) {
+    required.push_back("scope" + std::to_string(i));
+  }
+  std::vector<std::string> any_of = {"scope299"};
+  ScopeValidator scope("scope", required, any_of);
+
+  std::string granted;
+  for (int i = 0; i < 300; i++) {
+    granted += "scope" + std::to_string(i) + " ";
+  }
+  EXPECT_TRUE(scope.Check({{"scope", granted}}).valid());
+
+  std::string missing_one;
+  for (int i = 0; i < 299; i++) {
+    if (i != 150) {
+      missing_one += "scope" + std::to_string(i) + " ";
+    }
+  }
+  EXPECT_FALSE(scope.Check({{"scope", missing_one}}).valid());
+}
+
+TEST(path_test, json_pointer) {
+  json claims = {{"realm_access", {{"roles", {"admin", "user"}}}},
+                 {"cnf", {{"jkt", "thumbprint"}}},
+                 {"a/b", {{"m~n", 1}}},
+                 {"plain", "value"}};
+  EXPECT_EQ(&claims["cnf"]["jkt"], ClaimPath("/cnf/jkt").Find(claims));
+  EXPECT_EQ(&claims["realm_access"]["roles"][1],
+            ClaimPath("/realm_access/roles/1").Find(claims));
+  EXPECT_EQ(&claims["a/b"]["m~n"], ClaimPath("/a~1b/m~0n").Find(claims));
+  EXPECT_EQ(&claims["plain"], ClaimPath("plain").Find(claims));
+  EXPECT_EQ(nullptr, ClaimPath("/realm_access/roles/2").Find(claims));
+  EXPECT_EQ(nullptr, ClaimPath("/realm_access/roles/01").Find(claims));
+  EXPECT_EQ(nullptr, ClaimPath("/cnf/jkt/x").Find(claims));
+  EXPECT_EQ(nullptr, ClaimPath("/missing").Find(claims));
+  EXPECT_EQ(nullptr, ClaimPath("cnf/jkt").Find(claims));
+  EXPECT_THROW(ClaimPath("/a~2"), std::logic_error);
+}
+
+TEST(path_test, nested_validators) {
+  ListClaimValidator jkt("/cnf/jkt", {"thumbprint"});
+  ScopeValidator roles("/realm_access/roles", {"admin"}, {});
+  OptionalClaimValidator optional(&jkt);
+  json claims = {{"realm_access", {{"roles", {"admin", "user"}}}},
+                 {"cnf", {{"jkt", "thumbprint"}}}};
+  json other = {{"cnf", {{"jkt", "other"}}}};
+
+  EXPECT_TRUE(jkt.Check(claims).valid());
+  EXPECT_TRUE(roles.Check(claims).valid());
+  EXPECT_EQ(ClaimStatus::kInvalid, jkt.Check(other).code());
+  EXPECT_EQ(ClaimStatus::kMissing, roles.Check(other).code());
+  EXPECT_TRUE(optional.Check({{"cnf", json::object()}}).valid());
+  EXPECT_FALSE(optional.Check(other).valid());
+  expect_same(jkt, claims);
+  expect_same(jkt, other);
+  expect_same(optional, other);
+}
+
+JWT_CLAIM_VALUES(PolicyValues, "foo", "bar");
+typedef policy::All<policy::Exp<3>, policy::Optional<policy::Nbf<>>,
+                    policy::Any<policy::Iss<PolicyValues>,
+                                policy::Aud<PolicyValues>>>
+    TestPolicy;
+
+TEST(policy_test, matches_tree) {
+  policy::Policy<TestPolicy> static_policy(&fakeClock);
+  ExpValidator exp(3, &fakeClock);
+  NbfValidator nbf(0, &fakeClock);
+  OptionalClaimValidator optional(&nbf);
+  IssValidator iss(accepted);
+  AudValidator aud(accepted);
+  AnyClaimValidator any({&iss, &aud});
+  AllClaimValidator tree({&exp, &optional, &any});
+
+  EXPECT_EQ(json::parse(tree.toJson()), json::parse(static_policy.toJson()));
+  EXPECT_EQ(tree.cost(), static_policy.cost());
+  std::vector<std::string> tree_claims, policy_claims;
+  EXPECT_TRUE(tree.ListClaims(&tree_claims));
+  EXPECT_TRUE(static_policy.ListClaims(&policy_claims));
+  EXPECT_EQ(tree_claims, policy_claims);
+
+  std::vector<json> claimsets = {
+      {{"exp", 12}, {"iss", "foo"}},
+      {{"exp", 6}, {"iss", "foo"}},
+      {{"exp", 8}, {"aud", {"baz", "bar"}}},
+      {{"exp", 12}, {"nbf", 12}, {"iss", "foo"}},
+      {{"exp", 12}, {"nbf", 9}, {"sub", "foo"}},
+      {{"exp", "12"}, {"iss", "foo"}},
+      {{"iss", "foo"}},
+      json::array()};
+  for (const auto &claimset : claimsets) {
+    ClaimStatus expected = tree.Check(claimset);
+    ClaimStatus actual = static_policy.Check(claimset);
+    EXPECT_EQ(expected.code(), actual.code()) << claimset.dump();
+    EXPECT_EQ(expected.message(), actual.message()) << claimset.dump();
+  }
+}
+
+TEST(policy_test, serializes_clock) {
+  policy::Policy<policy::All<policy::Exp<3>, policy::Iss<PolicyValues>>>
+      static_policy(TimeValidator::coarse_clock());
+  ExpValidator exp(3, TimeValidator::coarse_clock());
+  IssValidator iss({"foo", "bar"});
+  AllClaimValidator tree({&exp, &iss});
+
+  EXPECT_EQ(json::parse(tree.toJson()), json::parse(static_policy.toJson()));
+  claim_ptr parsed(ClaimValidatorFactory::Build(static_policy.toJson()));
+  EXPECT_EQ(json::parse(static_policy.toJson()), json::parse(parsed->toJson()));
+}
+
+TEST(policy_test, throws_when_invalid) {
+  policy::Policy<policy::Iss<PolicyValues>> iss;
+  EXPECT_TRUE(iss.IsValid({{"iss", "bar"}}));
+  ASSERT_THROW(iss.IsValid({{"iss", "baz"}}), InvalidClaimError);
+}
+
+// Accepts claimsets that contain its property and counts its evaluations.
+class CountingValidator : public ClaimValidator {
+public:
+  CountingValidator(const std::string &property, Cost cost)
+      : ClaimValidator(property), cost_(cost), calls_(0) {}
+  bool IsValid(const json &claimset) const {
+    calls_++;
+    return claimset.count(property_) > 0;
+  }
+  std::string toJson() const { return "{}"; }
+  Cost cost() const { return cost_; }
+  int calls() const { return calls_; }
+
+private:
+  Cost cost_;
+  mutable int calls_;
+};
+
+TEST(adaptive_test, all_checks_rejecting_first) {
+  CountingValidator a("a", ClaimValidator::kCheap);
+  CountingValidator b("b", ClaimValidator::kCheap);
+  CountingValidator c("c", ClaimValidator::kCheap);
+  AdaptiveOrder order({&a, &b, &c}, false);
+  json claims = {{"a", 1}, {"b", 1}};
+  for (uint32_t i = 0; i < AdaptiveOrder::kInterval; i++) {
+    EXPECT_EQ(ClaimStatus::kInvalid, order.All(claims).code());
+  }
+  EXPECT_EQ(2u, order.At(0));
+  int calls = a.calls();
+  EXPECT_FALSE(order.All(claims).valid());
+  EXPECT_EQ(calls, a.calls());
+}
+
+TEST(adaptive_test, any_weighs_cost) {
+  CountingValidator expensive("a", ClaimValidator::kExpensive);
+  CountingValidator cheap("b", ClaimValidator::kCheap);
+  AdaptiveOrder order({&expensive, &cheap}, true);
+  json claims = {{"a", 1}, {"b", 1}};
+  for (uint32_t i = 0; i < AdaptiveOrder::kInterval; i++) {
+    EXPECT_TRUE(order.Any(claims));
+  }
+  EXPECT_EQ(1u, order.At(0));
+  EXPECT_FALSE(order.Any({{"c", 1}}));
+}
+
+TEST(adaptive_test, keeps_stateful_in_place) {
+  CountingValidator a("a", ClaimValidator::kExpensive);
+  CountingValidator stateful("b", ClaimValidator::kStateful);
+  CountingValidator c("c", ClaimValidator::kCheap);
+  CountingValidator d("d", ClaimValidator::kCheap);
+  AdaptiveOrder order({&a, &stateful, &c, &d}, false);
+  json claims = {{"a", 1}, {"b", 1}, {"c", 1}};
+  for (uint32_t i = 0; i < AdaptiveOrder::kInterval; i++) {
+    order.All(claims);
+  }
+  EXPECT_EQ(0u, order.At(0));
+  EXPECT_EQ(1u, order.At(1));
+  EXPECT_EQ(3u, order.At(2));
+}
+
+TEST(adaptive_test, same_verdict) {
+  IssValidator iss(accepted);
+  SubValidator sub(accepted);
+  ExpValidator exp(0, &fakeClock);
+  std::vector<ClaimValidator *> children = {&exp, &iss, &sub};
+  AllClaimValidator all(children), adaptive_all(children, true);
+  AnyClaimValidator any(children), adaptive_any(children, true);
+  EXPECT_EQ(ClaimValidator::kCheap, adaptive_all.cost());
+  for (int i = 0; i < 3000; i++) {
+    json claims = {{"exp", i % 20}, {"iss", i % 3 ? "foo" : "baz"}};
+    if (i % 7) {
+      claims["sub"] = i % 5 ? "bar" : "qux";
+    }
+    EXPECT_EQ(all.Check(claims).valid(), adaptive_all.Check(claims).valid());
+    EXPECT_EQ(any.Check(claims).valid(), adaptive_any.Check(claims).valid());
+  }
+}
+
+TEST(policy_set, merges_shared_checks) {
+  ExpValidator exp(0, &fakeClock), other_exp(0, &fakeClock);
+  IssValidator iss(accepted), other_iss({"bar", "foo"});
+  ListClaimValidator also_iss("iss", accepted);
+  SubValidator sub(accepted);
+  CountingValidator counting("jti", ClaimValidator::kModerate);
+  AllClaimValidator first({&exp, &iss, &counting});
+  AllClaimValidator second({&other_exp, &also_iss, &sub});
+  AnyClaimValidator third({&other_iss, &counting});
+  OptionalClaimValidator fourth(&sub);
+
+  PolicySet set({&first, &second, &third, &fourth});
+  EXPECT_EQ(4u, set.size());
+  // exp, iss, counting, all, plain iss list, sub, all, iss, any, optional
+  EXPECT_EQ(10u, set.checks());
+
+  json claims = {{"exp", 12}, {"iss", "foo"}, {"jti", "a"}};
+  EXPECT_EQ(0xDu, set.Evaluate(claims));
+  EXPECT_EQ(1, counting.calls());
+  EXPECT_TRUE(PolicySet::Accepts(set.Evaluate(claims), 0));
+
+  claims["sub"] = "baz";
+  EXPECT_EQ(0x5u, set.Evaluate(claims));
+  claims["sub"] = "bar";
+  EXPECT_EQ(0xFu, set.Evaluate(claims));
+  EXPECT_EQ(0u, set.Evaluate({{"exp", 1}, {"sub", 1}}));
+}
+
+// A composite the library does not know about, walked through Children.
+class Forward : public ClaimValidator {
+public:
+  explicit Forward(const ClaimValidator *inner)
+      : ClaimValidator(inner->property()), inner_(inner) {}
+  bool IsValid(const json &claimset) const { return inner_->IsValid(claimset); }
+  std::string toJson() const { return inner_->toJson(); }
+  Composition Children(const ClaimValidator *const **children,
+                       size_t *num_children) const {
+    *children = &inner_;
+    *num_children = 1;
+    return kWrapper;
+  }
+
+private:
+  const ClaimValidator *inner_;
+};
+
+TEST(policy_set, walks_custom_composites) {
+  IssValidator iss(accepted), other_iss(accepted);
+  Forward forward(&other_iss);
+  PolicySet set({&iss, &forward});
+  EXPECT_EQ(1u, set.checks());
+  EXPECT_EQ(0x3u, set.Evaluate({{"iss", "foo"}}));
+
+  ClaimProgram program(&forward);
+  EXPECT_EQ(3u, program.size());
+  expect_same(forward, {{"iss", "foo"}});
+  expect_same(forward, {{"iss", "baz"}});
+}
+
+TEST(policy_set, keeps_classes_apart) {
+  AudValidator aud(accepted);
+  ListClaimValidator plain_aud("aud", accepted);
+  PolicySet set({&aud, &plain_aud});
+  EXPECT_EQ(2u, set.checks());
+  EXPECT_EQ(0x1u, set.Evaluate({{"aud", {"foo"}}}));
+  EXPECT_EQ(0x3u, set.Evaluate({{"aud", "foo"}}));
+}
+
+TEST(policy_set, matches_policies) {
+  SettableClock clock(1000);
+  JtiReplayValidator jti(100, 10, &clock);
+  IssValidator iss(accepted);
+  AudValidator aud(accepted);
+  AllClaimValidator replay({&iss, &jti});
+  AnyClaimValidator either({&iss, &aud});
+  AllClaimValidator both({&iss, &aud});
+  PolicySet set({&replay, &either, &both});
+
+  EXPECT_EQ(0x7u, set.Evaluate({{"iss", "foo"}, {"aud", "bar"}, {"jti", "a"}}));
+  EXPECT_EQ(0x3u, set.Evaluate({{"iss", "foo"}, {"jti", "b"}}));
+  EXPECT_EQ(0x2u, set.Evaluate({{"iss", "foo"}, {"jti", "b"}}));
+  EXPECT_EQ(0x2u, set.Evaluate({{"aud", {"x", "bar"}}, {"jti", "c"}}));
+  EXPECT_EQ(2, jti.size());
+
+  std::vector<const ClaimValidator *> many(PolicySet::kMaxPolicies + 1, &iss);
+  ASSERT_THROW(PolicySet too_many(many), std::logic_error);
+}
@@ -0,0 +1,137 @@
+#include <fstream>
+#include <memory>
+#include <string>
+#include "./constants.h"
+#include "gtest/gtest.h"
+#include "jwt/jwt_all.h"
+
+class JwksTest : public ::testing::Test {
+   protected:
+    virtual void SetUp() override {
+        std::ofstream out("/tmp/test.jwks");
+        out << jwks;
+        out.close();
+    }
+
+    void SignedWith(const MessageSigner &signer, const std::string &kid,
+                    MessageValidator *validator) {
+        ::json header = {{"kid", kid}};
+        std::string token = JWT::Encode(signer, {{"sub", "subject"}}, header);
+        ::json jose, payload;
+        std::tie(jose, payload) = JWT::Decode(token, validator);
+        EXPECT_EQ("subject", payload["sub"]);
+    }
+};
+
+TEST_F(JwksTest, loads_all_key_types) {
+    JwksLoader loader;
+    validator_ptr kid(loader.Load("/tmp/test.jwks"));
+
+    SignedWith(RS256Validator(pubkey, privkey), "rsa", kid.get());
+    SignedWith(ES256Validator(ecpubkey, ecprivkey), "ec", kid.get());
+    SignedWith(EdDSAValidator(edpubkey, edprivkey), "ed", kid.get());
+    SignedWith(HS384Validator("secret"), "hmac", kid.get());
+}
+
+TEST_F(JwksTest, wrong_key_fails) {
+    JwksLoader loader;
+    validator_ptr kid(loader.Load("/tmp/test.jwks"));
+    std::string token = JWT::Encode(HS384Validator("not-the-secret"),
+                                    {{"sub", "subject"}}, {{"kid", "hmac"}});
+    ASSERT_THROW(JWT::Decode(token, kid.get()), InvalidSignatureError);
+}
+
+TEST_F(JwksTest, skips_encryption_keys) {
+    JwksLoader loader;
+    validator_ptr kid(loader.Load("/tmp/test.jwks"));
+    EXPECT_TRUE(kid->Accepts({{"kid", "rsa"}, {"alg", "RS256"}}));
+    EXPECT_FALSE(kid->Accepts({{"kid", "enc"}, {"alg", "RS256"}}));
+}
+
+TEST_F(JwksTest, reload_uses_cache) {
+    JwksLoader loader;
+    validator_ptr first(loader.Load("/tmp/test.jwks"));
+    EXPECT_EQ(3u, loader.materialized());
+    EXPECT_EQ(3u, loader.cache_size());
+
+    validator_ptr second(loader.Load("/tmp/test.jwks"));
+    EXPECT_EQ(3u, loader.materialized());
+    EXPECT_EQ(3u, loader.cache_size());
+}
+
+TEST_F(JwksTest, reload_evicts_removed_keys) {
+    JwksLoader loader;
+    std::unique_ptr<KidValidator> kid(loader.Load("/tmp/test.jwks"));
+    EXPECT_EQ(3u, loader.cache_size());
+
+    ::json keys = ::json::parse(jwks);
+    keys["keys"].erase(1);
+    loader.Reload(keys, kid.get());
+    EXPECT_EQ(2u, loader.cache_size());
+    EXPECT_FALSE(kid->Accepts({{"kid", "ec"}, {"alg", "ES256"}}));
+    EXPECT_TRUE(kid->Accepts({{"kid", "rsa"}, {"alg", "RS256"}}));
+}
+
+TEST_F(JwksTest, kid_defaults_to_thumbprint) {
+    ::json keys = {{"keys", {{{"kty", "oct"}, {"k", "c2VjcmV0"}}}}};
+    JwksLoader loader;
+    validator_ptr kid(loader.Build(keys));
+    std::string thumbprint = JwksLoader::Thumbprint(keys["keys"][0]);
+    SignedWith(HS256Validator("secret"), thumbprint, kid.get());
+}
+
+TEST(jwks_test, rfc7638_thumbprint) {
+    ::json jwk = {
+        {"kty", "RSA"},
+        {"n",
+         "0vx7agoebGcQSuuPiLJXZptN9nndrQmbXEps2aiAFbWhM78LhWx4cbbfAAtVT86zwu1RK"
+         "7aPFFxuhDR1L6tSoc_BJECPebWKRXjBZCiFV4n3oknjhMstn64tZ_2W-5JsGY4Hc5n9yB"
+         "XArwl93lqt7_RN5w6Cf0h4QyQ5v-65YGjQR0_FDW2QvzqY368QQMicAtaSqzs8KJZgnYb"
+         "9c7d0zgdAZHzu6qMQvRL5hajrn1n91CbOpbISD08qNLyrdkt-bFTWhAI4vMQFh6WeZu0f"
+         "M4lFd2NcRwr3XPksINHaQ-G_xBniIqbw0Ls1jF44-csFCur-kEgU8awapJzKnqDKgw"},
+        {"e", "AQAB"},
+        {"alg", "RS256"},
+        {"kid", "2011-04-29"}};
+    EXPECT_EQ("NzbLsXh8uDCcd-6MNwXF4W_7noWXFZAfHkxZsRGC9Xs",
+              JwksLoader::Thumbprint(jwk));
+}
+
+TEST(jwks_test, missing_file) {
+    JwksLoader loader;
+    ASSERT_THROW(loader.Load("/tmp/does/not/exist.jwks"),
+                 InvalidValidatorError);
+}
+
+TEST(jwks_test, no_keys) {
+    JwksLoader loader;
+    ASSERT_THROW(loader.Build({{"foo", "bar"}}), InvalidValidatorError);
+}
+
+TEST(jwks_test, invalid_ec_point) {
+    ::json keys = {{"keys",
+                    {{{"kty", "EC"},
+                      {"crv", "P-256"},
+                      {"x", "AQAB"},
+                      {"y", "AQAB"}}}}};
+    JwksLoader loader;
+    ASSERT_THROW(loader.Build(keys), InvalidValidatorError);
+}
+
+TEST(jwks_test, alg_must_match_curve) {
+    ::json keys = ::json::parse(jwks);
+    for (auto &jwk : keys["keys"]) {
+        if (jwk["kty"] == "EC") {
+            jwk["alg"] = "ES384";
+        }
+    }
+    JwksLoader loader;
+    ASSERT_THROW(loader.Build(keys), InvalidValidatorError);
+}
+
+TEST(jwks_test, duplicate_kid) {
+    ::json keys = {{"keys",
+                    {{{"kty", "oct"}, {"kid", "a"}, {"k", "c2VjcmV0"}},
+                     {{"kty", "oct"}, {"kid", "a"}, {"k", "b3RoZXI"}}}}};
+    JwksLoader loader;
+    ASSERT_THROW(loader.Build(keys), InvalidValidatorError);
+}
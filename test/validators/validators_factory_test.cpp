@@ -1,13 +1,22 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include "./constants.h"
 #include "gtest/gtest.h"
+#include "jwt/ecdsavalidator.h"
+#include "jwt/eddsavalidator.h"
 #include "jwt/hmacvalidator.h"
 #include "jwt/jwt.h"
+#include "jwt/keystorevalidator.h"
 #include "jwt/messagevalidatorfactory.h"
 #include "jwt/nonevalidator.h"
 #include "jwt/rsavalidator.h"
+#include "private/buildwrappers.h"
+#include "private/filewatcher.h"
 
 // Test for the various validators.
 TEST(parse_test, proper_hmac) {
@@ -180,6 +189,82 @@ TEST(parse_test, proper_rsa_from_file) {
     }
 }
 
+TEST(parse_test, watched_secret_reloads) {
+    {
+        std::ofstream out("/tmp/watched.secret");
+        out << "first";
+    }
+    std::string json =
+        "{\"HS256\":{\"secret\":{\"fromfile\":\"/tmp/watched.secret\","
+        "\"watch\":true}}}";
+    validator_ptr valid(MessageValidatorFactory::Build(json));
+    EXPECT_STREQ(json.c_str(), valid->toJson().c_str());
+    EXPECT_STREQ("HS256", valid->algorithm().c_str());
+
+    ::json jose = {{"alg", "HS256"}};
+    std::string header = "header";
+    HS256Validator first("first"), second("second");
+    EXPECT_TRUE(valid->Validate(jose, header, first.Digest(header)));
+    EXPECT_FALSE(valid->Validate(jose, header, second.Digest(header)));
+
+    // Replace the file the way kubernetes does, with a rename.
+    {
+        std::ofstream out("/tmp/watched.secret.tmp");
+        out << "second";
+    }
+    std::rename("/tmp/watched.secret.tmp", "/tmp/watched.secret");
+    for (int i = 0;
+         i < 100 && !valid->Validate(jose, header, second.Digest(header));
+         i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_TRUE(valid->Validate(jose, header, second.Digest(header)));
+    EXPECT_FALSE(valid->Validate(jose, header, first.Digest(header)));
+}
+
+TEST(parse_test, watcher_waits_for_completed_writes) {
+    std::remove("/tmp/watched.partial");
+    std::atomic<int> calls(0);
+    FileWatcher watcher(50);
+    watcher.Watch("/tmp/watched.partial", [&calls]() { calls++; });
+
+    std::ofstream out("/tmp/watched.partial");
+    out << "par";
+    out.flush();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(0, calls.load());
+
+    out << "tial";
+    out.close();
+    for (int i = 0; i < 100 && calls.load() == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(1, calls.load());
+}
+
+TEST(parse_test, empty_secret_file_fails) {
+    { std::ofstream out("/tmp/empty.secret"); }
+    std::string json =
+        "{\"HS256\":{\"secret\":{\"fromfile\":\"/tmp/empty.secret\"}}}";
+    ASSERT_THROW(MessageValidatorFactory::Build(json), std::logic_error);
+}
+
+TEST(parse_test, watched_keeps_validator_on_failure) {
+    int builds = 0;
+    WatchedValidator valid({{"HS256", {{"secret", "first"}}}}, [&builds]() {
+        if (builds++ > 0) {
+            throw std::logic_error("partially written key");
+        }
+        return new HS256Validator("first");
+    });
+
+    json jose = {{"alg", "HS256"}};
+    std::string header = "header";
+    HS256Validator first("first");
+    EXPECT_FALSE(valid.Reload());
+    EXPECT_TRUE(valid.Validate(jose, header, first.Digest(header)));
+}
+
 // Test for the various validators.
 TEST(parse_test, parse_set) {
     std::string json =
@@ -195,6 +280,25 @@ TEST(parse_test, parse_set) {
     EXPECT_TRUE(valid->Accepts({{"alg", "HS512"}}));
 }
 
+TEST(parse_test, parse_multi) {
+    std::string json =
+        "{ \"multi\" : [ "
+        "{ \"HS256\" : { \"secret\" : \"old\" } }, "
+        "{ \"HS256\" : { \"secret\" : \"new\" } }"
+        " ] }";
+    validator_ptr valid(MessageValidatorFactory::Build(json));
+    EXPECT_STREQ(json.c_str(), valid->toJson().c_str());
+    EXPECT_STREQ("HS256", valid->algorithm().c_str());
+
+    std::string message = "Hello World!";
+    EXPECT_TRUE(valid->Validate({{"alg", "HS256"}}, message,
+                                HS256Validator("old").Digest(message)));
+    EXPECT_TRUE(valid->Validate({{"alg", "HS256"}}, message,
+                                HS256Validator("new").Digest(message)));
+    EXPECT_FALSE(valid->Validate({{"alg", "HS256"}}, message,
+                                 HS256Validator("other").Digest(message)));
+}
+
 TEST(parse_test, parse_kid) {
     std::string json =
         "{ \"kid\" : { "
@@ -211,6 +315,87 @@ TEST(parse_test, parse_kid) {
     EXPECT_FALSE(valid->Accepts({{"alg", "HS512"}, {"kid", "key1"}}));
 }
 
+TEST(parse_test, lazy_kid) {
+    json config = {
+        {"lazy",
+         {{"kid",
+           {{"good", {{"RS256", {{"public", pubkey}}}}},
+            {"bad", {{"RS256", {{"public", "not a pem"}}}}}}}}}};
+    validator_ptr valid(MessageValidatorFactory::Build(config));
+    EXPECT_EQ(config, json::parse(valid->toJson()));
+
+    RS256Validator signer(pubkey, privkey);
+    std::string header = "header";
+    std::string signature = signer.Digest(header);
+    json good = {{"alg", "RS256"}, {"kid", "good"}};
+    json bad = {{"alg", "RS256"}, {"kid", "bad"}};
+    EXPECT_TRUE(valid->Accepts(good));
+    EXPECT_TRUE(valid->Validate(good, header, signature));
+    EXPECT_TRUE(valid->Validate(good, header, signature));
+    EXPECT_FALSE(valid->Validate(bad, header, signature));
+}
+
+TEST(parse_test, warmup_kid) {
+    json config = {
+        {"warmup", {{"kid", {{"key1", {{"HS256", {{"secret", "key1"}}}}}}}}}};
+    validator_ptr valid(MessageValidatorFactory::Build(config));
+    EXPECT_EQ(config, json::parse(valid->toJson()));
+
+    HS256Validator signer("key1");
+    json jose = {{"alg", "HS256"}, {"kid", "key1"}};
+    EXPECT_TRUE(valid->Validate(jose, "header", signer.Digest("header")));
+}
+
+TEST(parse_test, lazy_parses_failed_keys_once) {
+    int builds = 0;
+    LazyValidator valid({{"HS256", {{"secret", "first"}}}},
+                        [&builds]() -> MessageValidator * {
+                            builds++;
+                            throw std::logic_error("not a key");
+                        });
+
+    json jose = {{"alg", "HS256"}};
+    std::string header = "header";
+    HS256Validator first("first");
+    EXPECT_FALSE(valid.Validate(jose, header, first.Digest(header)));
+    EXPECT_FALSE(valid.Validate(jose, header, first.Digest(header)));
+    EXPECT_EQ(nullptr, valid.Materialize());
+    EXPECT_EQ(1, builds);
+}
+
+TEST(parse_test, lazy_still_rejects_unknown) {
+    std::string json = "{ \"lazy\" : { \"XS256\" : { \"secret\" : \"a\" } } }";
+    ASSERT_THROW(MessageValidatorFactory::Build(json), std::logic_error);
+}
+
+TEST(parse_test, parse_keystore) {
+    KeyStoreWriter writer;
+    writer.Add("key1", "HS256", "key1");
+    writer.Write("/tmp/test.keystore");
+
+    std::string json =
+        "{ \"keystore\" : { \"file\" : \"/tmp/test.keystore\", "
+        "\"cache\" : 10 } }";
+    validator_ptr valid(MessageValidatorFactory::Build(json));
+    EXPECT_STREQ(json.c_str(), valid->toJson().c_str());
+    EXPECT_TRUE(valid->Accepts({{"alg", "HS256"}, {"kid", "key1"}}));
+    EXPECT_FALSE(valid->Accepts({{"alg", "HS256"}, {"kid", "key2"}}));
+    EXPECT_THROW(MessageValidatorFactory::Build(
+                     std::string("{ \"keystore\" : { \"cache\" : 10 } }")),
+                 std::logic_error);
+}
+
+TEST(parse_test, parse_derived) {
+    std::string json =
+        "{ \"derived\" : { \"alg\" : \"HS256\", \"secret\" : \"master\", "
+        "\"kid\" : \"tenant-*\", \"cache\" : 10 } }";
+    validator_ptr valid(MessageValidatorFactory::Build(json));
+    EXPECT_STREQ(json.c_str(), valid->toJson().c_str());
+    EXPECT_STREQ("HS256", valid->algorithm().c_str());
+    EXPECT_TRUE(valid->Accepts({{"alg", "HS256"}, {"kid", "tenant-1"}}));
+    EXPECT_FALSE(valid->Accepts({{"alg", "HS256"}, {"kid", "other"}}));
+}
+
 TEST(parse_test, accepts_multiple_types) {
     // do not have to be of the same type..
     std::string json =
@@ -349,3 +534,23 @@ TEST(parse_signer, round_trip_rs512) {
     RS512Validator msg(pubkey, privkey);
     roundtrip_signer(&msg);
 }
+
+TEST(parse, round_trip_es256) {
+    ES256Validator msg(ecpubkey);
+    roundtrip(&msg);
+}
+
+TEST(parse, round_trip_eddsa) {
+    EdDSAValidator msg(edpubkey);
+    roundtrip(&msg);
+}
+
+TEST(parse_signer, round_trip_es256) {
+    ES256Validator msg(ecpubkey, ecprivkey);
+    roundtrip_signer(&msg);
+}
+
+TEST(parse_signer, round_trip_eddsa) {
+    EdDSAValidator msg(edpubkey, edprivkey);
+    roundtrip_signer(&msg);
+}
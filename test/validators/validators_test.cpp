@@ -1,6 +1,9 @@
 #include <array>
+#include <atomic>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 #include "constants.h"
 #include "gtest/gtest.h"
@@ -41,6 +44,7 @@ class MessageValidatorTest : public ::testing::Test {
 
     std::vector<MessageSigner *> hslist_;
     std::vector<MessageSigner *> rslist_;
+    std::vector<MessageSigner *> eclist_;
     std::string message_;
 
    protected:
@@ -53,6 +57,9 @@ class MessageValidatorTest : public ::testing::Test {
         rslist_.push_back(new RS256Validator(pubkey, privkey));
         rslist_.push_back(new RS384Validator(pubkey, privkey));
         rslist_.push_back(new RS512Validator(pubkey, privkey));
+
+        eclist_.push_back(new ES256Validator(ecpubkey, ecprivkey));
+        eclist_.push_back(new EdDSAValidator(edpubkey, edprivkey));
     }
 
     virtual void TearDown() override {
@@ -64,6 +71,10 @@ class MessageValidatorTest : public ::testing::Test {
             delete s;
         }
         rslist_.clear();
+        for (auto s : eclist_) {
+            delete s;
+        }
+        eclist_.clear();
     }
 };
 
@@ -107,6 +118,36 @@ TEST_F(MessageValidatorTest, rs_signing_on_substr_succeed) {
     for (auto rs : rslist_) SignOnSubstr(rs);
 }
 
+TEST_F(MessageValidatorTest, ec_tamper_resistant) {
+    for (auto ec : eclist_) TamperResistant(ec);
+}
+
+TEST_F(MessageValidatorTest, ec_unsigned_fails) {
+    for (auto ec : eclist_) UnsignedFailsTest(ec);
+}
+
+TEST_F(MessageValidatorTest, ec_double_validate) {
+    for (auto ec : eclist_) DoubleValidate(ec);
+}
+
+TEST_F(MessageValidatorTest, ec_signing_succeed) {
+    for (auto ec : eclist_) SignSucceeds(ec);
+}
+
+TEST_F(MessageValidatorTest, ec_signing_on_substr_succeed) {
+    for (auto ec : eclist_) SignOnSubstr(ec);
+}
+
+TEST(ecdsavalidator_test, raw_signature_size) {
+    ES256Validator es256(ecpubkey, ecprivkey);
+    std::string sign = es256.Digest("Hello World!");
+    EXPECT_EQ(64u, sign.size());
+}
+
+TEST(ecdsavalidator_test, rejects_rsa_key) {
+    ASSERT_THROW(ES256Validator validator(pubkey), InvalidValidatorError);
+}
+
 TEST(nonevalidator_test, signed_fails) {
     NoneValidator validator;
     EXPECT_FALSE(validator.Validate(nullptr, "foo", "bar"));
@@ -117,6 +158,86 @@ TEST(nonevalidator_test, unsigned_succeeds) {
     EXPECT_TRUE(validator.Validate(nullptr, "hello", ""));
 }
 
+TEST(algorithm_test, parses_names) {
+    for (size_t i = 0; i < Algorithms::kCount; i++) {
+        Algorithm alg = static_cast<Algorithm>(i);
+        EXPECT_EQ(alg, Algorithms::Parse(Algorithms::Name(alg)));
+        if (i > 0) {
+            // The enum is sorted by name.
+            EXPECT_LT(std::string(Algorithms::Name(static_cast<Algorithm>(i - 1))),
+                      Algorithms::Name(alg));
+        }
+    }
+    EXPECT_EQ(Algorithm::UNKNOWN, Algorithms::Parse("HS25"));
+    EXPECT_EQ(Algorithm::UNKNOWN, Algorithms::Parse("hs256"));
+    EXPECT_EQ(Algorithm::UNKNOWN, Algorithms::Parse(""));
+    EXPECT_EQ(Algorithm::RS384, Algorithms::FromJose({{"alg", "RS384"}}));
+    EXPECT_EQ(Algorithm::UNKNOWN, Algorithms::FromJose({{"alg", 256}}));
+    EXPECT_EQ(Algorithm::UNKNOWN, Algorithms::FromJose(nullptr));
+    EXPECT_EQ(Algorithm::HS512, HS512Validator("secret").algorithm_id());
+    EXPECT_EQ(Algorithm::none, NoneValidator().algorithm_id());
+}
+
+TEST(setvalidator_test, passes_jose_to_kid) {
+    HS256Validator hs1("secret1");
+    KidValidator kid;
+    kid.Register("kid1", &hs1);
+    HS512Validator hs512("secret512");
+    SetValidator set({&kid, &hs512});
+
+    std::string message = "Hello World!";
+    EXPECT_TRUE(
+        set.Validate({{"alg", "HS256"}, {"kid", "kid1"}}, message, hs1.Digest(message)));
+    EXPECT_TRUE(set.Validate({{"alg", "HS512"}}, message, hs512.Digest(message)));
+    EXPECT_FALSE(set.Validate({{"alg", "HS384"}}, message, hs512.Digest(message)));
+    EXPECT_FALSE(set.Accepts({{"alg", "HS256"}, {"kid", "kid2"}}));
+}
+
+TEST(multikeyvalidator_test, tries_all_keys) {
+    RS256Validator old_key(pubkey, privkey);
+    RS256Validator new_key(pubkey2, privkey2);
+    HS256Validator hmac("secret");
+    MultiKeyValidator multi({&old_key, &new_key, &hmac});
+    std::string message = "Hello World!";
+    ::json rs256 = {{"alg", "RS256"}};
+
+    EXPECT_STREQ("MULTI", multi.algorithm().c_str());
+    EXPECT_TRUE(multi.Accepts(rs256));
+    EXPECT_FALSE(multi.Accepts({{"alg", "RS384"}}));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_TRUE(multi.Validate(rs256, message, new_key.Digest(message)));
+        EXPECT_TRUE(multi.Validate(rs256, message, old_key.Digest(message)));
+    }
+    EXPECT_TRUE(multi.Validate({{"alg", "HS256"}}, message, hmac.Digest(message)));
+    EXPECT_FALSE(multi.Validate({{"alg", "HS256"}}, message, new_key.Digest(message)));
+    EXPECT_FALSE(multi.Validate(rs256, message, hmac.Digest(message)));
+}
+
+TEST(multikeyvalidator_test, single_algorithm) {
+    RS256Validator old_key(pubkey, privkey);
+    RS256Validator new_key(pubkey2, privkey2);
+    MultiKeyValidator multi({&old_key, &new_key});
+    EXPECT_STREQ("RS256", multi.algorithm().c_str());
+    EXPECT_EQ(Algorithm::RS256, multi.algorithm_id());
+}
+
+TEST(rsavalidator_test, verify_digest) {
+    RS256Validator key(pubkey, privkey);
+    std::string message = "Hello World!";
+    std::string sig = key.Digest(message);
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int num_digest = 0;
+    EVP_Digest(message.data(), message.size(), digest, &num_digest, key.md(),
+               NULL);
+    EXPECT_TRUE(key.VerifyDigest(digest, num_digest,
+                                 reinterpret_cast<const uint8_t *>(sig.data()),
+                                 sig.size()));
+    digest[0] ^= 1;
+    EXPECT_FALSE(key.VerifyDigest(digest, num_digest,
+                                  reinterpret_cast<const uint8_t *>(sig.data()),
+                                  sig.size()));
+}
+
 TEST(kidvalidator_test, accepts_alg) {
     HS256Validator hs1("secret1");
     HS384Validator hs2("secret2");
@@ -162,6 +283,162 @@ TEST(kidvalidator_test, can_register_kid) {
     EXPECT_FALSE(kid.Validate(json, message, sig2));
 }
 
+TEST(kidvalidator_test, unregister_kid) {
+    HS256Validator hs1("secret1");
+    KidValidator kid;
+    kid.Register("kid1", &hs1);
+    std::string message = "Hello World!";
+    std::string sig1 = hs1.Digest(message);
+    ::json json = {{"kid", "kid1"}};
+
+    EXPECT_TRUE(kid.Validate(json, message, sig1));
+    EXPECT_TRUE(kid.Unregister("kid1"));
+    EXPECT_FALSE(kid.Unregister("kid1"));
+    EXPECT_FALSE(kid.Validate(json, message, sig1));
+    EXPECT_STREQ("", kid.algorithm().c_str());
+}
+
+TEST(kidvalidator_test, swap_table) {
+    std::shared_ptr<MessageValidator> hs1(new HS256Validator("secret1"));
+    std::shared_ptr<MessageValidator> hs2(new HS256Validator("secret2"));
+    KidValidator kid({{"kid1", hs1}});
+    std::string message = "Hello World!";
+    std::string sig2 = static_cast<MessageSigner *>(hs2.get())->Digest(message);
+    ::json json = {{"kid", "kid2"}};
+
+    EXPECT_FALSE(kid.Validate(json, message, sig2));
+    kid.Swap({{"kid2", hs2}});
+    EXPECT_TRUE(kid.Validate(json, message, sig2));
+    EXPECT_FALSE(kid.Accepts({{"kid", "kid1"}, {"alg", "HS256"}}));
+    EXPECT_STREQ("HS256", kid.algorithm().c_str());
+}
+
+TEST(kidvalidator_test, swap_keeps_first_algorithm) {
+    std::shared_ptr<MessageValidator> hs(new HS256Validator("secret"));
+    std::shared_ptr<MessageValidator> hs384(new HS384Validator("secret"));
+    KidValidator kid({{"b", hs}, {"a", hs384}}, "b");
+    EXPECT_STREQ("HS256", kid.algorithm().c_str());
+    kid.Swap({{"b", hs}, {"a", hs384}});
+    EXPECT_STREQ("HS384", kid.algorithm().c_str());
+}
+
+TEST(kidvalidator_test, rotate_while_verifying) {
+    std::shared_ptr<MessageValidator> stable(new HS256Validator("stable"));
+    KidValidator kid({{"stable", stable}});
+    std::string message = "Hello World!";
+    std::string sig =
+        static_cast<MessageSigner *>(stable.get())->Digest(message);
+    ::json json = {{"kid", "stable"}};
+
+    std::atomic<int> failures(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.push_back(std::thread([&]() {
+            for (int j = 0; j < 2000; j++) {
+                if (!kid.Validate(json, message, sig)) failures++;
+            }
+        }));
+    }
+
+    for (int i = 0; i < 200; i++) {
+        std::shared_ptr<MessageValidator> rotated(
+            new HS256Validator("rotated" + std::to_string(i)));
+        kid.Swap({{"stable", stable}, {"rotated", rotated}});
+    }
+
+    for (auto &reader : readers) reader.join();
+    EXPECT_EQ(0, failures.load());
+}
+
+TEST(keystorevalidator_test, verifies_keys_from_file) {
+    KeyStoreWriter writer;
+    for (int i = 0; i < 1000; i++) {
+        writer.Add("tenant" + std::to_string(i), i % 2 ? "HS256" : "HS512",
+                   "secret" + std::to_string(i));
+    }
+    writer.Write("/tmp/test.keystore");
+
+    KeyStoreValidator store("/tmp/test.keystore", 16);
+    EXPECT_EQ(1000u, store.size());
+    EXPECT_STREQ("HS512", store.algorithm().c_str());
+    std::string message = "Hello World!";
+    for (int i = 0; i < 1000; i++) {
+        std::string kid = "tenant" + std::to_string(i);
+        std::string alg = i % 2 ? "HS256" : "HS512";
+        std::string sig =
+            i % 2 ? HS256Validator("secret" + std::to_string(i)).Digest(message)
+                  : HS512Validator("secret" + std::to_string(i)).Digest(message);
+        EXPECT_TRUE(store.Accepts({{"kid", kid}, {"alg", alg}}));
+        EXPECT_TRUE(store.Validate({{"kid", kid}}, message, sig));
+        EXPECT_FALSE(store.Validate({{"kid", "tenant1000"}}, message, sig));
+    }
+
+    // Only the most recently used validators are kept.
+    EXPECT_EQ(16u, store.cache_size());
+    EXPECT_FALSE(store.Accepts({{"kid", "tenant1"}, {"alg", "HS512"}}));
+    EXPECT_FALSE(store.Accepts({{"kid", "tenant"}, {"alg", "HS256"}}));
+    EXPECT_FALSE(store.Accepts({{"alg", "HS256"}}));
+}
+
+TEST(keystorevalidator_test, rejects_invalid_files) {
+    KeyStoreWriter writer;
+    EXPECT_THROW(writer.Add("kid", "RS256", "secret"), std::logic_error);
+    writer.Add("kid", "HS256", "secret");
+    EXPECT_THROW(writer.Add("kid", "HS256", "other"), std::logic_error);
+
+    {
+        std::ofstream out("/tmp/test.notakeystore");
+        out << "This is not a key file, but it is long enough.";
+    }
+    EXPECT_THROW(KeyStoreValidator("/tmp/test.notakeystore", 16),
+                 std::logic_error);
+    EXPECT_THROW(KeyStoreValidator("/tmp/does/not/exist", 16),
+                 std::logic_error);
+}
+
+TEST(derivedkeyvalidator_test, rfc5869_test_case_3) {
+    // RFC 5869, A.3: SHA-256 with an empty salt and info.
+    DerivedKeyValidator derived("HS256", std::string(22, 0x0b), "*", 16);
+    const uint8_t expected[] = {
+        0x8d, 0xa4, 0xe7, 0x75, 0xa5, 0x63, 0xc1, 0x8f, 0x71, 0x5f, 0x80,
+        0x2a, 0x06, 0x3c, 0x5a, 0x31, 0xb8, 0xa1, 0x1f, 0x5c, 0x5e, 0xe1,
+        0x87, 0x9e, 0xc3, 0x45, 0x4e, 0x5f, 0x3c, 0x73, 0x8d, 0x2d};
+    EXPECT_EQ(std::string(reinterpret_cast<const char *>(expected), 32),
+              derived.DeriveKey(""));
+}
+
+TEST(derivedkeyvalidator_test, verifies_derived_keys) {
+    DerivedKeyValidator derived("HS512", "master", "tenant-*", 4, "salt");
+    std::string message = "Hello World!";
+    for (int i = 0; i < 10; i++) {
+        std::string kid = "tenant-" + std::to_string(i);
+        HS512Validator signer(derived.DeriveKey(kid));
+        std::string sig = signer.Digest(message);
+        EXPECT_EQ(64u, derived.DeriveKey(kid).size());
+        EXPECT_TRUE(derived.Accepts({{"kid", kid}, {"alg", "HS512"}}));
+        EXPECT_TRUE(derived.Validate({{"kid", kid}}, message, sig));
+        EXPECT_FALSE(derived.Validate({{"kid", "tenant-x"}}, message, sig));
+    }
+    EXPECT_EQ(4u, derived.cache_size());
+
+    std::string sig = HS512Validator(derived.DeriveKey("other-1")).Digest(message);
+    EXPECT_FALSE(derived.Accepts({{"kid", "other-1"}, {"alg", "HS512"}}));
+    EXPECT_FALSE(derived.Validate({{"kid", "other-1"}}, message, sig));
+    EXPECT_FALSE(derived.Accepts({{"kid", "tenant-1"}, {"alg", "HS256"}}));
+    EXPECT_THROW(DerivedKeyValidator("RS256", "master", "*", 4),
+                 std::logic_error);
+}
+
+TEST(derivedkeyvalidator_test, kid_patterns) {
+    DerivedKeyValidator derived("HS256", "master", "t?-*-prod", 4);
+    EXPECT_TRUE(derived.Matches("t1-abc-prod"));
+    EXPECT_TRUE(derived.Matches("t1--prod"));
+    EXPECT_TRUE(derived.Matches("t1-a-prod-prod"));
+    EXPECT_FALSE(derived.Matches("t12-abc-prod"));
+    EXPECT_FALSE(derived.Matches("t1-abc-dev"));
+    EXPECT_FALSE(derived.Matches(""));
+}
+
 TEST_F(MessageValidatorTest, wrong_algo) {
     std::vector<MessageValidator *> validators(hslist_.begin(), hslist_.end());
     SetValidator set(validators);